@@ -6,6 +6,13 @@
 #include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "esp_event.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "gpio_lanes.h"
+#include "gpio_batch.h"
+#include "gpio_state.h"
+#include "gpio_cores.h"
+#include "gpio_liveness.h"
 
 namespace GPIO {
 
@@ -19,6 +26,25 @@ namespace GPIO {
         HIGH = 1  ///< Represents a high output level (1).
     };
 
+    /**
+     * @brief One GPIO interrupt that ran over its cycle budget.
+     */
+    struct IsrBudgetRecord {
+        gpio_num_t pin;         ///< GPIO whose handler overran.
+        uint32_t cycles;        ///< CPU cycles the handler took.
+        int64_t timestamp_us;   ///< esp_timer time at the end of the handler.
+    };
+
+    /**
+     * @brief Activity of a coalesced input over one window.
+     */
+    struct CoalescedEvent {
+        gpio_num_t pin;         ///< GPIO the edges occurred on.
+        uint32_t edges;         ///< Edges since the previous event.
+        int level;              ///< Logical level at the last edge, active low applied.
+        int64_t last_edge_us;   ///< esp_timer time of the last edge.
+    };
+
     /**
      * @brief Base class for GPIO control.
      * 
@@ -53,15 +79,46 @@ namespace GPIO {
 
             esp_err_t _clearEventHandlers();
 
+            bool _interrupt_enabled = false;                ///< Interrupts are enabled on the pin
+            BaseType_t _interrupt_core = tskNO_AFFINITY;    ///< Core the pin should interrupt, tskNO_AFFINITY for the service core
+            bool _core_routed = false;                      ///< Interrupts are dispatched by GpioCores
+            bool _power_lock_enabled = false;               ///< Hold PM locks while interrupts are enabled
+            bool _power_lock_held = false;                  ///< PM locks are currently acquired
+            esp_pm_lock_handle_t _cpu_lock{nullptr};        ///< Keeps the CPU at its maximum frequency
+            esp_pm_lock_handle_t _sleep_lock{nullptr};      ///< Keeps the chip out of light sleep
+
+            esp_err_t _updatePowerLock(void);
+
             struct interrupt_args {
                 const uint32_t type_tag = 0x47504941;  // "GPIA" in hex
                 bool _event_handler_set = false;
                 bool _custom_event_handler_set = false;
                 bool _queue_enabled = false;
+                bool _lane_enabled = false;
                 gpio_num_t _pin;
                 esp_event_loop_handle_t _custom_event_loop_handle{nullptr};
                 QueueHandle_t _queue_handle {nullptr};
+                GpioBatch *_batch{nullptr};         ///< Batch the edges are staged in, nullptr for none
+                bool _state_tracking = false;       ///< Edges also update the GpioState bitmap
+                bool _liveness = false;             ///< Edges also feed the GpioLiveness monitor
+                bool _coalescing = false;           ///< Count edges instead of delivering each one
+                portMUX_TYPE _coalesce_mutex = portMUX_INITIALIZER_UNLOCKED;   ///< Guards the three fields below
+                uint32_t _edge_count{0};            ///< Edges counted while coalescing, only ever incremented
+                uint32_t _last_level{0};            ///< Raw level at the last counted edge
+                int64_t _last_edge_us{0};           ///< esp_timer time of the last counted edge
+                uint32_t _budget_cycles{0};         ///< Over-budget threshold in CPU cycles, 0 for none
+                uint32_t _worst_cycles{0};          ///< Longest handler invocation in CPU cycles
+                uint32_t _over_budget{0};           ///< Invocations longer than _budget_cycles
             } _interrupt_args;
+
+            esp_timer_handle_t _coalesce_timer{nullptr};   ///< Delivers one event per window while coalescing
+            uint32_t _coalesced_edges{0};                  ///< Edge count covered by delivered events
+
+            static void _coalesceCallback(void *arg);
+
+            static portMUX_TYPE _budgetLogMutex;
+
+            static void IRAM_ATTR _checkIsrBudget(interrupt_args *args, uint32_t cycles);
             
         public:
             /**
@@ -81,6 +138,9 @@ namespace GPIO {
             
             /** @brief Default constructor. */
             GpioInput(void);
+
+            /** @brief Stops coalescing and liveness monitoring and frees the PM locks, interrupts must be disabled before destruction. */
+            ~GpioInput();
             
             /**
              * @brief Initializes the GPIO input.
@@ -156,6 +216,101 @@ namespace GPIO {
              */
             esp_err_t enableInterrupt(gpio_int_type_t int_type);
 
+            /**
+             * @brief Installs the shared GPIO interrupt service if it is not installed yet.
+             * 
+             * Also starts the Timebase that timestamps edges.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success).
+             */
+            static esp_err_t installInterruptService(void);
+
+            /**
+             * @brief Gets the core the shared GPIO interrupt service runs on.
+             * 
+             * @return BaseType_t Core of the service, tskNO_AFFINITY if not installed by this library.
+             */
+            static BaseType_t getInterruptServiceCore(void);
+
+            /**
+             * @brief Selects the core this pin interrupts.
+             * 
+             * Pins on the service core are dispatched by the ESP-IDF service,
+             * pins on the other core by GpioCores, so latency-critical pins can
+             * interrupt the core that runs their consumer and bulk inputs the
+             * other one. Takes effect with the next enableInterrupt(), which fails
+             * with ESP_ERR_INVALID_STATE if the service was installed outside
+             * this library and its core is unknown.
+             * 
+             * @param core Core to interrupt, tskNO_AFFINITY for the service core.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a bad core,
+             *         ESP_ERR_INVALID_STATE while interrupts are enabled).
+             */
+            esp_err_t setInterruptCore(BaseType_t core);
+
+            /**
+             * @brief Disables interrupt functionality for the GPIO pin.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success).
+             */
+            esp_err_t disableInterrupt(void);
+
+            /**
+             * @brief Holds CPU frequency and no-light-sleep locks while interrupts are enabled.
+             * 
+             * For high-rate inputs whose edges must be serviced at full speed
+             * under dynamic frequency scaling. The locks are released as soon
+             * as interrupts are disabled.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_NOT_SUPPORTED without CONFIG_PM_ENABLE).
+             */
+            esp_err_t enablePowerLock(void);
+
+            /**
+             * @brief Stops holding power management locks for this pin.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success).
+             */
+            esp_err_t disablePowerLock(void);
+
+            /**
+             * @brief Sets the cycle budget of this pin's interrupt handler.
+             * 
+             * Invocations longer than the budget are counted and logged for
+             * readIsrBudgetLog(). A budget of 0 only tracks the worst case.
+             * 
+             * @param cycles Budget in CPU cycles.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_NOT_SUPPORTED without CONFIG_GPIO_ISR_BUDGET).
+             */
+            esp_err_t setIsrBudget(uint32_t cycles);
+
+            /**
+             * @brief Gets the longest interrupt handler invocation of this pin.
+             * 
+             * @return uint32_t Worst case in CPU cycles since the last reset.
+             */
+            uint32_t getIsrWorstCycles(void) const;
+
+            /**
+             * @brief Gets how often this pin's interrupt handler exceeded its budget.
+             * 
+             * @return uint32_t Over-budget invocations since the last reset.
+             */
+            uint32_t getIsrOverBudgetCount(void) const;
+
+            /**
+             * @brief Clears the worst case and over-budget count of this pin.
+             */
+            void resetIsrBudgetStats(void);
+
+            /**
+             * @brief Takes the oldest entry from the over-budget log of all pins.
+             * 
+             * @param record Filled with the entry.
+             * @return bool True if an entry was returned, false if the log is empty.
+             */
+            static bool readIsrBudgetLog(IsrBudgetRecord &record);
+
             /**
              * @brief Sets the default event handler for GPIO input events.
              * 
@@ -191,11 +346,105 @@ namespace GPIO {
              */
             void setQueueHandle(QueueHandle_t Gpio_e_q);
 
+            /**
+             * @brief Delivers at most one event per window, carrying the number of edges.
+             * 
+             * For inputs where only the activity rate matters. The ISR just
+             * counts the edge and notes its level and time. Once per window,
+             * if there were edges, a CoalescedEvent is sent to the queue or
+             * posted as INPUT_EVENTS event data. Queues must be created with
+             * an item size of sizeof(CoalescedEvent).
+             * 
+             * @param window_us Window length in microseconds.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a zero window,
+             *         ESP_ERR_NOT_SUPPORTED for pins delivered through a lane or batch).
+             */
+            esp_err_t enableCoalescing(uint32_t window_us);
+
+            /**
+             * @brief Delivers every edge again.
+             * 
+             * Returns only after a window callback already dispatched by
+             * esp_timer has finished. Must not be called from an esp_timer callback.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success).
+             */
+            esp_err_t disableCoalescing(void);
+
+            /**
+             * @brief Delivers the pin's edges through the delivery lane of a priority class.
+             * 
+             * The handler runs in the lane's dispatcher task, started with
+             * GpioLanes::start(). Setting a lane handler will clear any
+             * previously set event handlers or queue.
+             * 
+             * @param priority_class Lane to deliver through.
+             * @param handler Handler run for every edge.
+             * @param context Handler argument.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a bad handler,
+             *         ESP_ERR_NOT_SUPPORTED while coalescing).
+             */
+            esp_err_t setLaneHandler(PriorityClass priority_class, LaneHandler handler, void *context);
+
+            /**
+             * @brief Stages the pin's edges in a batch for block-wise delivery.
+             * 
+             * Several inputs can share one batch, their edges are interleaved
+             * in the order they occurred. Setting a batch will clear any
+             * previously set event handlers, queue or lane.
+             * 
+             * @param batch Batch started with GpioBatch::start().
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for no batch,
+             *         ESP_ERR_NOT_SUPPORTED while coalescing).
+             */
+            esp_err_t setBatch(GpioBatch *batch);
+
+            /**
+             * @brief Tracks the pin's level in the GpioState bitmap.
+             * 
+             * Every edge updates the pin's level and changed bits in addition
+             * to any other delivery. The current level is recorded as a change
+             * right away. Interrupts must be enabled on both edges for the
+             * bitmap to follow the pin.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success).
+             */
+            esp_err_t enableStateTracking(void);
+
+            /**
+             * @brief Stops tracking the pin and clears its bits in the GpioState bitmap.
+             */
+            void disableStateTracking(void);
+
+            /**
+             * @brief Watches the pin for missing edges with GpioLiveness.
+             * 
+             * Every edge refreshes the pin's last-edge time in addition to any
+             * other delivery. SIGNAL_LOST is posted once the pin has had no
+             * edge for timeout_us, SIGNAL_RESTORED on its next edge. Interrupts
+             * must be enabled on the pin and GpioLiveness::start() called.
+             * 
+             * @param timeout_us Time without edges after which the signal is lost.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a timeout of 0 or
+             *         above GpioLiveness::MAX_TIMEOUT_US).
+             */
+            esp_err_t enableLivenessMonitor(uint32_t timeout_us);
+
+            /**
+             * @brief Stops watching the pin without posting an event.
+             */
+            void disableLivenessMonitor(void);
+
             /**
              * @brief Static callback function for GPIO interrupts.
              * 
              * This function is called when a GPIO interrupt occurs.
-             * It handles routing the interrupt to the appropriate handler:
+             * It updates the pin-state bitmap if tracking and the last-edge
+             * time if monitored for liveness, then routes the
+             * interrupt to the appropriate handler:
+             * - Edge counter if coalescing
+             * - Delivery lane if set
+             * - Batch if set
              * - Queue handler if enabled
              * - Custom event loop handler if set
              * - Default event handler if set
@@ -0,0 +1,141 @@
+#ifndef GPIO_BATCH_H
+#define GPIO_BATCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "lock_free_pool.h"
+
+namespace GPIO {
+
+    constexpr size_t EDGE_BLOCK_RECORDS = 32;  ///< Edges per EdgeBlock.
+
+    /**
+     * @brief One edge staged by the GPIO ISR.
+     */
+    struct EdgeRecord {
+        gpio_num_t pin;         ///< GPIO that interrupted.
+        uint32_t level;         ///< Raw level of the pin in the ISR.
+        int64_t timestamp_us;   ///< esp_timer time in the ISR.
+    };
+
+    /**
+     * @brief Edges handed to a consumer as one queue item.
+     */
+    struct EdgeBlock {
+        size_t count;                               ///< Records filled.
+        EdgeRecord records[EDGE_BLOCK_RECORDS];     ///< Edges in the order they occurred.
+    };
+
+    /**
+     * @brief Counters of a GpioBatch.
+     */
+    struct BatchStats {
+        uint32_t blocks;        ///< Blocks handed to the queue.
+        uint32_t edges;         ///< Edges in those blocks.
+        uint32_t drops;         ///< Edges lost to an empty pool or a full queue.
+    };
+
+    /**
+     * @brief Batched delivery of GPIO edges to one consumer.
+     * 
+     * The GPIO ISR appends every edge of the attached pins to a staging
+     * block taken from a fixed pool. A full block, or one older than the
+     * deadline, is sent to the consumer's queue as a single EdgeBlock
+     * pointer, so the consumer wakes once per block instead of once per
+     * edge. Blocks go back to the pool with release().
+     * 
+     * Pins are attached with GpioInput::setBatch().
+     */
+    class GpioBatch {
+        public:
+            static constexpr size_t POOL_BLOCKS = 8;           ///< Blocks per instance, staged, queued or held by the consumer
+            static constexpr uint32_t MIN_DEADLINE_US = 100;   ///< Shortest deadline, the timer runs at half of it and esp_timer periods start at 50 us
+
+        private:
+            Pool::LockFreePool<EdgeBlock, POOL_BLOCKS> _pool;
+            EdgeBlock *_staging{nullptr};               ///< Block the ISR appends to
+            portMUX_TYPE _staging_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+            QueueHandle_t _queue{nullptr};
+            esp_timer_handle_t _deadline_timer{nullptr};
+            int64_t _flush_age_us{0};                   ///< Age at which the timer hands off a partial block
+
+            std::atomic<uint32_t> _blocks{0};
+            std::atomic<uint32_t> _edges{0};
+            std::atomic<uint32_t> _drops{0};
+
+            void IRAM_ATTR _handOff(QueueHandle_t queue, EdgeBlock *block, BaseType_t *woken);
+            static void _deadlineCallback(void *arg);
+
+        public:
+            /** @brief Default constructor. */
+            GpioBatch(void);
+
+            /** @brief Stops the deadline timer, attached pins must have interrupts disabled before destruction. */
+            ~GpioBatch();
+
+            GpioBatch(const GpioBatch &) = delete;
+            GpioBatch &operator=(const GpioBatch &) = delete;
+
+            /**
+             * @brief Starts delivering blocks to a queue.
+             * 
+             * @param queue Queue created with an item size of sizeof(EdgeBlock *).
+             * @param deadline_us Longest an edge waits in a partial block.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for no queue or a
+             *         deadline under MIN_DEADLINE_US, ESP_ERR_INVALID_STATE if started).
+             */
+            esp_err_t start(QueueHandle_t queue, uint32_t deadline_us);
+
+            /**
+             * @brief Stops the deadline timer and hands off the partial block.
+             * 
+             * Returns only after a deadline callback already dispatched by
+             * esp_timer has finished. Must not be called from an esp_timer callback.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_STATE if not started).
+             */
+            esp_err_t stop(void);
+
+            /**
+             * @brief Returns a block received from the queue to the pool.
+             * 
+             * @param block Block to return.
+             */
+            void release(EdgeBlock *block);
+
+            /**
+             * @brief Stages an edge, called from the GPIO ISR.
+             * 
+             * @param pin GPIO that interrupted.
+             * @param level Raw level of the pin.
+             * @param woken Set to pdTRUE if the consumer should run before the ISR returns.
+             * @return bool True if the edge was staged.
+             */
+            bool IRAM_ATTR post(gpio_num_t pin, uint32_t level, BaseType_t *woken);
+
+            /**
+             * @brief Gets the counters.
+             * 
+             * @return BatchStats Counters since start().
+             */
+            BatchStats getStats(void) const;
+
+            /**
+             * @brief Gets the usage counters of the block pool.
+             * 
+             * @return Pool::PoolStats Capacity, blocks in use and high-water mark.
+             */
+            Pool::PoolStats getPoolStats(void) const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef GPIO_CORES_H
+#define GPIO_CORES_H
+
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+
+namespace GPIO {
+
+    /**
+     * @brief Per-core GPIO interrupt dispatch.
+     * 
+     * The ESP32 GPIO block has separate PRO and APP CPU interrupt enables
+     * per pin, while the ESP-IDF interrupt service only serves the core it
+     * was installed on. GpioCores allocates the GPIO interrupt on another
+     * core with its own dispatch table, so a pin can interrupt the core
+     * that runs its consumer.
+     * 
+     * The core of the ESP-IDF service keeps using the service's table.
+     * Ownership of each core's GPIO interrupt is tracked explicitly, the
+     * service is installed through installService() so a dispatcher never
+     * takes its core and the service never takes a dispatcher's.
+     * Pins are routed with GpioInput::setInterruptCore().
+     */
+    class GpioCores {
+        public:
+            /**
+             * @brief Routes a pin's interrupt to a core and dispatches it from that core's table.
+             * 
+             * Installs the core's dispatcher on first use. The interrupt type
+             * must already be set.
+             * 
+             * @param pin GPIO to route.
+             * @param core Core to interrupt.
+             * @param handler Handler run on that core for every interrupt of the pin.
+             * @param arg Handler argument.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin, core or
+             *         handler, ESP_ERR_INVALID_STATE if the ESP-IDF service owns the core or was installed outside
+             *         installService() on an unknown core).
+             */
+            static esp_err_t attach(gpio_num_t pin, BaseType_t core, gpio_isr_t handler, void *arg);
+
+            /**
+             * @brief Disables a routed pin's interrupt and removes it from its core's table.
+             * 
+             * @param pin GPIO to remove.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin,
+             *         ESP_ERR_INVALID_STATE if not routed).
+             */
+            static esp_err_t detach(gpio_num_t pin);
+
+            /**
+             * @brief Gets the number of interrupts a core's dispatcher has served.
+             * 
+             * @param core Core to read.
+             * @return uint32_t Dispatcher invocations since boot, 0 for a core without a dispatcher.
+             */
+            static uint32_t getDispatchCount(BaseType_t core);
+
+            /**
+             * @brief Installs the ESP-IDF GPIO interrupt service on a core and records the core as its own.
+             * 
+             * A service installed elsewhere in the application is accepted,
+             * but its core is unknown and attach() refuses every core.
+             * 
+             * @param core Core to install the service on.
+             * @return esp_err_t Status of the operation (ESP_OK on success or if already installed, ESP_ERR_INVALID_ARG
+             *         for a bad core, ESP_ERR_INVALID_STATE if a GpioCores dispatcher owns the core).
+             */
+            static esp_err_t installService(BaseType_t core);
+
+            /**
+             * @brief Gets the core that owns the ESP-IDF service.
+             * 
+             * @return BaseType_t Core of the service, tskNO_AFFINITY if not installed through installService().
+             */
+            static BaseType_t getServiceCore(void);
+
+        private:
+            static void _install(void *arg);
+            static void _installService(void *arg);
+            static esp_err_t _runOn(BaseType_t core, void (*function)(void *), void *arg);
+            static void IRAM_ATTR _dispatch(void *arg);
+    };
+
+}
+
+#endif
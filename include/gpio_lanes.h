@@ -0,0 +1,122 @@
+#ifndef GPIO_LANES_H
+#define GPIO_LANES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+
+namespace GPIO {
+
+    /**
+     * @brief Priority classes of GPIO inputs, each served by its own delivery lane.
+     */
+    enum class PriorityClass : uint8_t {
+        LOW = 0,        ///< Chatty or bulk inputs.
+        NORMAL = 1,     ///< Regular inputs.
+        HIGH = 2        ///< Inputs that must be handled promptly, such as an emergency stop.
+    };
+
+    constexpr size_t PRIORITY_CLASSES = 3;  ///< Number of PriorityClass values.
+
+    /**
+     * @brief One edge delivered through a lane.
+     */
+    struct LaneEvent {
+        gpio_num_t pin;         ///< GPIO that interrupted.
+        int64_t timestamp_us;   ///< esp_timer time in the ISR.
+    };
+
+    /**
+     * @brief Handler run by a lane's dispatcher task for every edge of a routed pin.
+     */
+    typedef void (*LaneHandler)(const LaneEvent &event, void *context);
+
+    /**
+     * @brief Counters of one lane.
+     */
+    struct LaneStats {
+        uint32_t delivered;     ///< Events handed to handlers.
+        uint32_t drops;         ///< Edges that found the ring full.
+        uint32_t high_water;    ///< Most events waiting in the ring at once.
+    };
+
+    /**
+     * @brief Delivery lanes for GPIO interrupts, one per priority class.
+     * 
+     * Every lane is a ring written by the GPIO ISR and drained by a
+     * dispatcher task at the lane's own FreeRTOS priority. The ISR finds the
+     * lane of a pin with a table lookup, so a flood on a low class fills only
+     * its own ring and never delays the dispatcher of a higher class. Pins of
+     * one lane may interrupt different cores, writers take a per-lane spinlock.
+     * 
+     * Pins are routed with GpioInput::setLaneHandler().
+     */
+    class GpioLanes {
+        public:
+            static constexpr size_t RING_SIZE = 64;    ///< Events buffered per lane, a power of two
+
+            /**
+             * @brief Creates the dispatcher task of a lane.
+             * 
+             * @param priority_class Lane to start.
+             * @param task_priority FreeRTOS priority of the dispatcher, handlers run at it.
+             * @param core Core of the dispatcher, tskNO_AFFINITY for either.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_STATE if running,
+             *         ESP_ERR_NO_MEM if the task could not be created).
+             */
+            static esp_err_t start(PriorityClass priority_class, UBaseType_t task_priority, BaseType_t core = tskNO_AFFINITY);
+
+            /**
+             * @brief Stops the dispatcher task of a lane, events still in its ring are discarded.
+             * 
+             * @param priority_class Lane to stop.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_STATE if not running).
+             */
+            static esp_err_t stop(PriorityClass priority_class);
+
+            /**
+             * @brief Routes the edges of a pin to a lane.
+             * 
+             * @param pin GPIO to route.
+             * @param priority_class Lane of the pin.
+             * @param handler Handler run for every edge.
+             * @param context Handler argument.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin or handler).
+             */
+            static esp_err_t route(gpio_num_t pin, PriorityClass priority_class, LaneHandler handler, void *context);
+
+            /**
+             * @brief Stops routing a pin, its edges are counted as undelivered.
+             * 
+             * @param pin GPIO to unroute.
+             */
+            static void unroute(gpio_num_t pin);
+
+            /**
+             * @brief Queues an edge of a routed pin on its lane, called from the GPIO ISR on either core.
+             * 
+             * @param pin GPIO that interrupted.
+             * @param woken Set to pdTRUE if the dispatcher should run before the ISR returns.
+             * @return bool True if the edge was queued.
+             */
+            static bool IRAM_ATTR post(gpio_num_t pin, BaseType_t *woken);
+
+            /**
+             * @brief Gets the counters of a lane.
+             * 
+             * @param priority_class Lane to read.
+             * @return LaneStats Counters since the lane was started.
+             */
+            static LaneStats getStats(PriorityClass priority_class);
+
+        private:
+            static void _dispatcherTask(void *arg);
+    };
+
+}
+
+#endif
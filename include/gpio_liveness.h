@@ -0,0 +1,114 @@
+#ifndef GPIO_LIVENESS_H
+#define GPIO_LIVENESS_H
+
+#include <cstdint>
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_event.h"
+
+namespace GPIO {
+
+    ESP_EVENT_DECLARE_BASE(LIVENESS_EVENTS);
+
+    /**
+     * @brief Event ids posted under LIVENESS_EVENTS.
+     */
+    enum LivenessEventId : int32_t {
+        SIGNAL_LOST,        ///< A watched pin had no edge for its timeout.
+        SIGNAL_RESTORED     ///< A lost pin had an edge again.
+    };
+
+    /**
+     * @brief Event data of SIGNAL_LOST and SIGNAL_RESTORED.
+     */
+    struct LivenessEvent {
+        gpio_num_t pin;         ///< Pin that changed state.
+        uint32_t silent_us;     ///< Time without edges, until detection when lost, the whole gap when restored.
+    };
+
+    /**
+     * @brief Missing-edge detection for periodic signals on many pins.
+     * 
+     * The GPIO ISR of every watched pin stores the time of its last edge,
+     * nothing else. A single esp_timer turns a hashed timing wheel with one
+     * slot per tick and checks only the pins whose deadline falls in the
+     * current slot. A pin that saw edges since it was scheduled is moved to
+     * the slot of its new deadline, a pin that did not is reported lost.
+     * 
+     * An edge on a lost pin flags it in a pending mask that the next tick
+     * reports as restored, so each transition posts exactly one event.
+     * Detection is late by at most one tick.
+     * 
+     * Pins are watched with GpioInput::enableLivenessMonitor(), which needs
+     * interrupts enabled on the pin.
+     */
+    class GpioLiveness {
+        public:
+            static constexpr uint32_t WHEEL_SLOTS = 64;                 ///< Ticks in one turn of the wheel
+            static constexpr uint32_t MIN_TICK_US = 1000;               ///< Finest tick
+            static constexpr uint32_t MAX_TIMEOUT_US = 600000000;       ///< Longest timeout, edge times are 32-bit
+
+            /**
+             * @brief Starts the wheel timer.
+             * 
+             * @param tick_us Wheel resolution, the worst detection delay.
+             * @param loop Custom event loop, nullptr to post to the default loop.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a tick below
+             *         MIN_TICK_US, ESP_ERR_INVALID_STATE if already started).
+             */
+            static esp_err_t start(uint32_t tick_us, esp_event_loop_handle_t loop = nullptr);
+
+            /**
+             * @brief Stops the wheel timer, watched pins stay registered.
+             */
+            static void stop(void);
+
+            /**
+             * @brief Starts watching a pin, counted as alive from now.
+             * 
+             * Watching a watched pin changes its timeout.
+             * 
+             * @param pin GPIO to watch.
+             * @param timeout_us Time without edges after which the pin is lost.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin or a
+             *         timeout of 0 or above MAX_TIMEOUT_US).
+             */
+            static esp_err_t watch(gpio_num_t pin, uint32_t timeout_us);
+
+            /**
+             * @brief Stops watching a pin without posting an event.
+             * 
+             * @param pin GPIO to forget.
+             */
+            static void unwatch(gpio_num_t pin);
+
+            /**
+             * @brief Records an edge of a watched pin, called from the GPIO ISR.
+             * 
+             * @param pin GPIO that interrupted.
+             */
+            static void IRAM_ATTR post(gpio_num_t pin);
+
+            /**
+             * @brief Checks whether a pin is currently reported lost.
+             * 
+             * @param pin GPIO to check.
+             * @return true if SIGNAL_LOST was the pin's last event.
+             */
+            static bool isLost(gpio_num_t pin);
+
+            /**
+             * @brief Gets the number of events the event loop had no room for.
+             * 
+             * @return uint32_t Dropped events since boot.
+             */
+            static uint32_t getDropCount(void);
+
+        private:
+            static void _tick(void *arg);
+    };
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef GPIO_STATE_H
+#define GPIO_STATE_H
+
+#include <cstdint>
+#include "driver/gpio.h"
+#include "esp_attr.h"
+
+namespace GPIO {
+
+    /**
+     * @brief Levels of all tracked pins together with the pins that changed.
+     */
+    struct PinStates {
+        uint64_t levels;    ///< Raw level of each tracked pin, bit n for GPIO n.
+        uint64_t changed;   ///< Pins with an edge since the previous fetch.
+    };
+
+    /**
+     * @brief Pin-state bitmap for poll-style consumers.
+     * 
+     * The GPIO ISR of every pin with state tracking enabled updates a
+     * current-level mask and sets the pin's bit in a sticky changed mask.
+     * Control loops on either core read all levels and fetch-and-clear the
+     * changed pins without queues, handlers or wakeups.
+     * 
+     * The ESP32 has no 64-bit atomics, so each mask is held as two 32-bit
+     * words matching the GPIO_IN and GPIO_IN1 registers. Each word is
+     * updated and cleared with a single atomic operation, a 64-bit read
+     * is two word reads.
+     * 
+     * Pins are tracked with GpioInput::enableStateTracking().
+     */
+    class GpioState {
+        public:
+            /**
+             * @brief Records an edge of a tracked pin, called from the GPIO ISR.
+             * 
+             * The level is stored before the changed bit is set, so a
+             * consumer that sees the change also sees the new level.
+             * 
+             * @param pin GPIO that interrupted.
+             * @param level Raw level of the pin.
+             */
+            static void IRAM_ATTR post(gpio_num_t pin, uint32_t level);
+
+            /**
+             * @brief Gets the current levels.
+             * 
+             * @return uint64_t Raw level of each tracked pin, bit n for GPIO n.
+             */
+            static uint64_t getLevels(void);
+
+            /**
+             * @brief Gets and clears the pins that changed.
+             * 
+             * @return uint64_t Pins with an edge since the previous fetch, bit n for GPIO n.
+             */
+            static uint64_t fetchChanged(void);
+
+            /**
+             * @brief Fetches the changed pins, then reads the levels.
+             * 
+             * @return PinStates Levels no older than the changes they are returned with.
+             */
+            static PinStates poll(void);
+
+            /**
+             * @brief Stops tracking a pin and clears its bits.
+             * 
+             * @param pin GPIO to forget.
+             */
+            static void clear(gpio_num_t pin);
+    };
+
+}
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef GPIO_TRIGGER_H
+#define GPIO_TRIGGER_H
+
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/gpio.h"
+#include "esp_event.h"
+#include "gpio.h"
+
+namespace GPIO {
+
+    ESP_EVENT_DECLARE_BASE(TRIGGER_EVENTS);
+
+    /**
+     * @brief A compound pin condition evaluated on an edge.
+     * 
+     * The trigger matches when an edge on edge_pin finds every pin in
+     * care_mask at the level given by value_mask. "Pin 4 rises while pins 5
+     * and 6 are low" is edge_pin 4, care_mask bits 4, 5 and 6, value_mask
+     * bit 4.
+     */
+    struct TriggerDefinition {
+        uint64_t care_mask;     ///< Pins whose level matters, bit n for GPIO n.
+        uint64_t value_mask;    ///< Required levels of the cared pins.
+        gpio_num_t edge_pin;    ///< Pin whose edges evaluate the trigger.
+    };
+
+    /**
+     * @brief Delivered for every matching trigger, as queue item or event data.
+     */
+    struct TriggerEvent {
+        int32_t id;             ///< Id the trigger was added with, also the event id.
+        gpio_num_t edge_pin;    ///< Pin whose edge matched.
+        uint64_t levels;        ///< Levels of all pins when the edge was handled.
+    };
+
+    /**
+     * @brief Class for compound conditions across several GPIO pins.
+     * 
+     * Triggers are compiled into a table grouped by edge pin. The interrupt
+     * of an edge pin takes one snapshot of the input registers and checks
+     * only the triggers of that pin, so tasks are woken for matches alone.
+     * 
+     * The pins must be configured as inputs, for example with GpioInput,
+     * and edge pins must not have interrupts enabled through GpioInput.
+     */
+    class GpioTrigger {
+        public:
+            static constexpr size_t MAX_TRIGGERS = 16;     ///< Triggers per instance
+            static constexpr size_t MAX_EDGE_PINS = 8;     ///< Distinct edge pins per instance
+
+        private:
+            struct _trigger {
+                uint64_t care_mask;
+                uint64_t value_mask;
+                gpio_num_t edge_pin;
+                int32_t id;
+            };
+
+            struct _edge_args {
+                const uint32_t type_tag = 0x47505447;  // "GPTG" in hex
+                GpioTrigger *owner{nullptr};
+                gpio_num_t pin{GPIO_NUM_NC};
+                size_t first{0};                        ///< First trigger of the pin in the compiled table
+                size_t count{0};                        ///< Triggers of the pin
+            };
+
+            _trigger _triggers[MAX_TRIGGERS]{};
+            size_t _trigger_count{0};
+            _edge_args _edge_pins[MAX_EDGE_PINS]{};
+            size_t _edge_pin_count{0};
+            bool _high_pins{false};                     ///< Some trigger cares about GPIO 32 and up
+            bool _enabled{false};
+
+            QueueHandle_t _queue_handle{nullptr};
+            esp_event_loop_handle_t _event_loop_handle{nullptr};
+            bool _event_loop_set{false};
+
+            uint32_t _edges{0};                         ///< Edges evaluated
+            uint32_t _matches{0};                       ///< Triggers that matched
+            uint32_t _drops{0};                         ///< Matches that could not be delivered
+
+            esp_err_t _compile(void);
+            static void IRAM_ATTR _isr(void *arg);
+
+        public:
+            /** @brief Default constructor. */
+            GpioTrigger(void);
+
+            /** @brief Disables the interrupts of the edge pins. */
+            ~GpioTrigger();
+
+            /**
+             * @brief Adds a trigger.
+             * 
+             * @param definition Condition of the trigger.
+             * @param id Id delivered when the trigger matches.
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin or a
+             *         value bit outside care_mask, ESP_ERR_NO_MEM when full, ESP_ERR_INVALID_STATE while enabled).
+             */
+            esp_err_t addTrigger(const TriggerDefinition &definition, int32_t id);
+
+            /**
+             * @brief Removes every trigger.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_STATE while enabled).
+             */
+            esp_err_t clearTriggers(void);
+
+            /**
+             * @brief Delivers matches as TriggerEvent items to a queue.
+             * 
+             * @param queue Queue created with an item size of sizeof(TriggerEvent).
+             */
+            void setQueueHandle(QueueHandle_t queue);
+
+            /**
+             * @brief Posts matches as TRIGGER_EVENTS to an event loop.
+             * 
+             * @param loop Event loop to post to, nullptr for the default loop.
+             */
+            void setEventLoop(esp_event_loop_handle_t loop);
+
+            /**
+             * @brief Compiles the triggers and enables interrupts on every edge pin.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success, ESP_ERR_INVALID_STATE if no
+             *         triggers, no delivery target or already enabled, ESP_ERR_NO_MEM for too many edge pins).
+             */
+            esp_err_t enable(void);
+
+            /**
+             * @brief Disables interrupts on every edge pin.
+             * 
+             * @return esp_err_t Status of the operation (ESP_OK on success).
+             */
+            esp_err_t disable(void);
+
+            /**
+             * @brief Gets the number of edges evaluated.
+             * 
+             * @return uint32_t Edges on the edge pins since enable().
+             */
+            uint32_t getEdgeCount(void) const;
+
+            /**
+             * @brief Gets the number of matches delivered or dropped.
+             * 
+             * @return uint32_t Matching triggers since enable().
+             */
+            uint32_t getMatchCount(void) const;
+
+            /**
+             * @brief Gets the number of matches the queue or event loop had no room for.
+             * 
+             * @return uint32_t Dropped matches since enable().
+             */
+            uint32_t getDropCount(void) const;
+    };
+
+}
+
+#endif
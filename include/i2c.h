@@ -1,10 +1,109 @@
 #ifndef I2C_H
 #define I2C_H
 
+#include <span>
 #include "driver/i2c.h"
 #include "esp_intr_alloc.h"
+#include "esp_pm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "i2c_pool.h"
+#include "i2c_scan.h"
+#include "i2c_sequence.h"
+#include "i2c_snapshot.h"
 
 namespace I2C {
+    /**
+     * @brief Per-device transaction policy
+     * 
+     * Controls how long a transaction to a single device may take and how
+     * aggressively a persistently failing device is isolated from the bus.
+     */
+    struct DeviceConfig {
+        uint32_t timeout_ms = 50;           ///< Transaction deadline for this device
+        uint8_t breaker_threshold = 3;      ///< Consecutive failures before the device is quarantined, 0 for no breaker
+        uint32_t backoff_base_ms = 100;     ///< First quarantine period
+        uint32_t backoff_max_ms = 10000;    ///< Upper bound for the exponential backoff
+        uint32_t clk_speed = 0;             ///< SCL frequency in Hz for this device, 0 to use the port speed
+        uint16_t sda_sample_cycles = 0;     ///< SDA sample point after SCL rises in APB cycles, 0 for the default
+        uint16_t sda_hold_cycles = 0;       ///< SDA hold time after SCL falls in APB cycles, 0 for the default
+        bool pec = false;                   ///< Append an SMBus PEC byte to writes and verify it on reads
+    };
+
+    /**
+     * @brief One register access in a batch submitted to I2c::ExecuteBatch
+     */
+    struct Transaction {
+        uint8_t dev_addr{};                 ///< I2C device address
+        uint8_t reg_addr{};                 ///< Register address
+        uint8_t *data{};                    ///< Source or destination buffer
+        size_t length{};                    ///< Number of bytes to transfer
+        bool read{};                        ///< true to read into data, false to write from it
+        esp_err_t status{ESP_OK};           ///< Result, filled in by ExecuteBatch
+    };
+
+    /**
+     * @brief Bus health counters maintained by an I2c object
+     */
+    struct I2cMetrics {
+        uint32_t transactions{};            ///< Transactions issued to the driver
+        uint32_t errors{};                  ///< Transactions that returned an error
+        uint32_t timeouts{};                ///< Transactions that hit their deadline
+        uint32_t stuck_bus_detections{};    ///< Times SDA or SCL was found held low while idle
+        uint32_t recoveries{};              ///< Recovery sequences that released the bus
+        uint32_t recovery_failures{};       ///< Recovery sequences that left the bus stuck
+        uint64_t recovery_time_us{};        ///< Total time spent in recovery
+        uint32_t recovery_time_max_us{};    ///< Longest single recovery
+        uint32_t quarantines{};             ///< Times a device was quarantined by the circuit breaker
+        uint32_t quarantine_rejections{};   ///< Transactions refused because the device was quarantined
+        uint32_t speed_switches{};          ///< Times the bus timing was reprogrammed for a different device speed
+        uint32_t crc_errors{};              ///< Reads whose PEC or word CRC did not match
+    };
+
+    class I2c;
+
+    /**
+     * @brief A register transfer whose command links are built once and re-executed
+     * 
+     * One command link is prepared per bound data buffer, so switching the
+     * destination (or source) between calls costs nothing. Must stay at a
+     * fixed address after I2c::Prepare(), e.g. as a static or member object.
+     * The device's PEC setting is captured at prepare time.
+     */
+    class PreparedTransaction {
+        public:
+            static constexpr size_t MAX_BUFFERS = 4;        ///< Data buffers that can be bound to one transaction
+
+            PreparedTransaction() = default;
+            PreparedTransaction(const PreparedTransaction &) = delete;
+            PreparedTransaction &operator=(const PreparedTransaction &) = delete;
+
+            /**
+             * @brief Check whether the links have been built
+             * 
+             * @return true after a successful I2c::Prepare()
+             */
+            bool IsPrepared(void) const { return _buffer_count > 0; }
+
+        private:
+            friend class I2c;
+
+            static constexpr size_t LINK_SIZE = I2C_INTERNAL_STRUCT_SIZE * 11; ///< Header plus the commands of one write-read with PEC
+
+            uint8_t _link[MAX_BUFFERS][LINK_SIZE]{};        ///< Static command link storage, one per buffer
+            i2c_cmd_handle_t _handles[MAX_BUFFERS]{};       ///< Built links
+            uint8_t *_buffers[MAX_BUFFERS]{};               ///< Bound data buffers
+            size_t _buffer_count{};                         ///< Number of bound buffers
+            size_t _length{};                               ///< Bytes transferred per execution
+            uint8_t _header[2]{};                           ///< Write address and register, chained by pointer
+            uint8_t _read_addr{};                           ///< Read address byte, chained by pointer
+            uint8_t _pec{};                                 ///< PEC byte read back or sent
+            uint8_t _pec_seed{};                            ///< PEC of the bytes that never change
+            uint8_t _dev_addr{};                            ///< I2C device address
+            bool _read{};                                   ///< Read from the device if true, write otherwise
+            bool _use_pec{};                                ///< Device had PEC enabled when prepared
+    };
+
     /**
      * @brief Class for handling I2C communication on ESP32
      * 
@@ -20,8 +119,84 @@ namespace I2C {
             size_t _slv_rx_buf_len{};     ///< Slave receive buffer length
             size_t _slv_tx_buf_len{};     ///< Slave transmit buffer length
             int _intr_alloc_flags{};      ///< Interrupt allocation flags
+            i2c_config_t _config{};       ///< Master configuration kept for driver reinstall after recovery
+
+            /**
+             * @brief Runtime state of a configured device
+             */
+            struct _device_state {
+                DeviceConfig config{};          ///< Device policy
+                uint8_t addr{};                 ///< 7-bit device address
+                uint8_t consecutive_failures{}; ///< Failures since the last success
+                uint8_t quarantine_count{};     ///< Quarantines since the last success, drives the backoff
+                int64_t quarantined_until_us{}; ///< esp_timer time until which the device is skipped
+            };
+
+            /**
+             * @brief SCL timing programmed into the controller
+             */
+            struct _bus_timing {
+                uint32_t clk_speed{};           ///< SCL frequency in Hz
+                uint16_t sda_sample{};          ///< SDA sample point in APB cycles, 0 for half of the high period
+                uint16_t sda_hold{};            ///< SDA hold time in APB cycles, 0 for half of the low period
+
+                bool operator==(const _bus_timing &other) const = default;
+            };
+
+            static constexpr size_t MAX_DEVICES = 16;          ///< Number of devices with individual policies
+            static constexpr uint8_t NO_DEVICE = 0xFF;         ///< Empty slot marker in the address index
+            static constexpr uint32_t DEFAULT_TIMEOUT_MS = 1000; ///< Deadline for devices without a policy
+            static constexpr uint32_t MAX_CLK_SPEED = 1000000;   ///< Upper limit for calibration
+
+            _device_state _devices[MAX_DEVICES]{};  ///< Configured devices
+            size_t _device_count{};                 ///< Number of used entries in _devices
+            uint8_t _device_index[128];             ///< 7-bit address to _devices slot
+            I2cMetrics _metrics{};                  ///< Bus health counters
+            portMUX_TYPE _stateMutex = portMUX_INITIALIZER_UNLOCKED; ///< Protects device state and metrics
+            _bus_timing _active_timing{};           ///< Timing currently programmed, guarded by _bus_lock
+            SemaphoreHandle_t _bus_lock{nullptr};   ///< Serializes transactions and recovery
+            StaticSemaphore_t _bus_lock_buffer{};   ///< Storage for _bus_lock
+            esp_pm_lock_handle_t _pm_lock{nullptr}; ///< APB frequency lock held while operations are pending
+
+            _device_state* _findDevice(uint8_t dev_addr);
+            bool _linesReleased(void);
+            esp_err_t _recover(void);
+            esp_err_t _admit(uint8_t dev_addr);
+            void _complete(uint8_t dev_addr, esp_err_t status);
+            TickType_t _deadline(uint8_t dev_addr);
+            _bus_timing _timing(uint8_t dev_addr);
+            bool _pecEnabled(uint8_t dev_addr);
+            esp_err_t _crcFailure(void);
+            uint8_t* _acquireLink(size_t &size);
+            void _releaseLink(uint8_t *link);
+            esp_err_t _applyTiming(const _bus_timing &timing);
+            void _pmAcquire(void);
+            void _pmRelease(void);
+            esp_err_t _run(uint8_t dev_addr, i2c_cmd_handle_t handle);
+            esp_err_t _transfer(uint8_t dev_addr, const uint8_t *tx_data, size_t tx_length, uint8_t *rx_data, size_t rx_length);
+            esp_err_t _transfer(uint8_t dev_addr, std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx);
+            void _stepInitSequence(InitSequence &sequence, int64_t now, InitReport &report);
         
         public:
+            static constexpr size_t MAX_CRC_WORDS = 16;        ///< Word limit of ReadWords() and WriteWords()
+            static constexpr size_t MAX_SEGMENTS = CONFIG_I2C_MAX_SEGMENTS; ///< Segment limit per direction of Write() and WriteRead()
+
+            /**
+             * @brief Command link buffer size for a scatter-gather transaction
+             * 
+             * Counts start, address, one write per tx segment, repeated start,
+             * address, one read per rx segment plus the NACKed last byte, the
+             * optional PEC byte and stop, plus the link header.
+             * 
+             * @param tx_segments Number of write segments
+             * @param rx_segments Number of read segments
+             * @return size_t Buffer size in bytes for i2c_cmd_link_create_static()
+             */
+            static constexpr size_t LinkSize(size_t tx_segments, size_t rx_segments){
+                const size_t commands = 2 + tx_segments + (rx_segments > 0 ? 3 + rx_segments : 0) + 1 + 1;
+                return I2C_INTERNAL_STRUCT_SIZE * (commands + 2);
+            }
+
             /**
              * @brief Construct a new I2c object
              * 
@@ -95,6 +270,375 @@ namespace I2C {
              * @return esp_err_t ESP_OK on success, error code otherwise
              */
             esp_err_t WriteRegisterMultipleBytes(uint8_t dev_addr, uint8_t reg_addr, uint8_t *tx_data, int length);
+
+            /**
+             * @brief Read multiple bytes from an I2C register into a span
+             * 
+             * @param dev_addr I2C device address
+             * @param reg_addr Register address to read from
+             * @param rx_data Destination, its size is the number of bytes read
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            esp_err_t ReadRegisterMultipleBytes(uint8_t dev_addr, uint8_t reg_addr, std::span<uint8_t> rx_data);
+
+            /**
+             * @brief Write multiple bytes from a span to an I2C register
+             * 
+             * @param dev_addr I2C device address
+             * @param reg_addr Register address to write to
+             * @param tx_data Source, its size is the number of bytes written
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            esp_err_t WriteRegisterMultipleBytes(uint8_t dev_addr, uint8_t reg_addr, std::span<const uint8_t> tx_data);
+
+            /**
+             * @brief Read sizeof(T) bytes from an I2C register and publish them to a snapshot
+             * 
+             * The value is read into a local copy first, so a failed read
+             * leaves the published value untouched. Readers of the snapshot
+             * never wait on the bus.
+             * 
+             * @tparam T Trivially copyable register image
+             * @param dev_addr I2C device address
+             * @param reg_addr Starting register address to read from
+             * @param snapshot Snapshot this task is the only writer of
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<typename T, size_t Buffers>
+            esp_err_t ReadRegisterSnapshot(uint8_t dev_addr, uint8_t reg_addr, Snapshot<T, Buffers> &snapshot){
+                T value;
+                const esp_err_t status = ReadRegisterMultipleBytes(dev_addr, reg_addr,
+                    std::span<uint8_t>(reinterpret_cast<uint8_t*>(&value), sizeof(T)));
+                if (status == ESP_OK){
+                    snapshot.Publish(value);
+                }
+                return status;
+            }
+
+            /**
+             * @brief Write several buffers as one transaction
+             * 
+             * Each segment is chained into the command link as is, so a command
+             * header and a payload stored elsewhere need no staging buffer.
+             * 
+             * @param dev_addr I2C device address
+             * @param tx Segments written back to back, at most MAX_SEGMENTS
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for too many segments,
+             *         ESP_ERR_NO_MEM if no link buffer became free, error code otherwise
+             */
+            esp_err_t Write(uint8_t dev_addr, std::span<const std::span<const uint8_t>> tx);
+
+            /**
+             * @brief Write several buffers, then read into several buffers after a repeated start
+             * 
+             * @param dev_addr I2C device address
+             * @param tx Segments written back to back, at most MAX_SEGMENTS
+             * @param rx Segments filled in order, at most MAX_SEGMENTS
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for too many segments,
+             *         ESP_ERR_NO_MEM if no link buffer became free, error code otherwise
+             */
+            esp_err_t WriteRead(uint8_t dev_addr, std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx);
+
+            /**
+             * @brief Read bytes without addressing a register first
+             * 
+             * Only the read address goes on the wire, as needed for the SMBus
+             * Alert Response Address and for devices that stream on every read.
+             * 
+             * @param dev_addr I2C device address
+             * @param rx_data Destination, its size is the number of bytes read
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an empty buffer,
+             *         ESP_ERR_NO_MEM if no link buffer became free, error code otherwise
+             */
+            esp_err_t Read(uint8_t dev_addr, std::span<uint8_t> rx_data);
+
+            /**
+             * @brief Write a fixed number of buffers as one transaction
+             * 
+             * The segment count is checked at compile time.
+             * 
+             * @code
+             * const uint8_t command[2] = {0x24, 0x00};
+             * bus.Write(0x44, {command, payload});
+             * @endcode
+             * 
+             * @param dev_addr I2C device address
+             * @param tx Segments written back to back
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<size_t TxCount>
+            esp_err_t Write(uint8_t dev_addr, const std::span<const uint8_t> (&tx)[TxCount]){
+                static_assert(TxCount <= MAX_SEGMENTS, "Too many write segments");
+                return _transfer(dev_addr, tx, {});
+            }
+
+            /**
+             * @brief Write, then read a fixed number of buffers after a repeated start
+             * 
+             * The segment counts are checked at compile time.
+             * 
+             * @param dev_addr I2C device address
+             * @param tx Segments written back to back
+             * @param rx Segments filled in order
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<size_t TxCount, size_t RxCount>
+            esp_err_t WriteRead(uint8_t dev_addr, const std::span<const uint8_t> (&tx)[TxCount], const std::span<uint8_t> (&rx)[RxCount]){
+                static_assert(TxCount <= MAX_SEGMENTS && RxCount <= MAX_SEGMENTS, "Too many segments");
+                return _transfer(dev_addr, tx, rx);
+            }
+
+            /**
+             * @brief Build the command links of a repeated register transfer
+             * 
+             * Validates the parameters and builds one link per buffer, so
+             * Execute() only has to run an existing link. Preparing an already
+             * prepared transaction rebuilds it.
+             * 
+             * @param prepared Transaction to build, must not move afterwards
+             * @param dev_addr I2C device address
+             * @param reg_addr Register address
+             * @param length Bytes per transfer
+             * @param read true to read into the buffers, false to write from them
+             * @param buffers Data buffers of at least length bytes, at most PreparedTransaction::MAX_BUFFERS
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for bad parameters, error code otherwise
+             */
+            esp_err_t Prepare(PreparedTransaction &prepared, uint8_t dev_addr, uint8_t reg_addr, size_t length, bool read,
+                              std::span<uint8_t *const> buffers);
+
+            /**
+             * @brief Run a prepared transfer
+             * 
+             * Goes through the same deadline, circuit breaker, recovery and
+             * timing handling as the other methods.
+             * 
+             * @param prepared Transaction built by Prepare()
+             * @param buffer Index of the bound buffer to transfer
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if not prepared, error code otherwise
+             */
+            esp_err_t Execute(PreparedTransaction &prepared, size_t buffer = 0);
+
+            /**
+             * @brief Check whether a device acknowledges its address
+             * 
+             * Sends only the address byte with a write bit and a STOP, at the
+             * port speed, so nothing in the device is read or changed. The
+             * deadline follows the address byte's wire time at the port speed,
+             * with a margin and a floor, instead of the device timeout. Probes
+             * bypass the circuit breaker and do not count as transaction errors.
+             * 
+             * @param dev_addr 7-bit address
+             * @return esp_err_t ESP_OK if the address was acknowledged, ESP_ERR_NOT_FOUND if not, error code otherwise
+             */
+            esp_err_t Probe(uint8_t dev_addr);
+
+            /**
+             * @brief Probe a range of addresses
+             * 
+             * @param result Addresses that answered and the scan time
+             * @param first_addr First address to probe
+             * @param last_addr Last address to probe
+             * @return esp_err_t ESP_OK on success, error code if the bus failed during the scan
+             */
+            esp_err_t Scan(ScanResult &result, uint8_t first_addr = FIRST_SCAN_ADDR, uint8_t last_addr = LAST_SCAN_ADDR);
+
+            /**
+             * @brief Scan two ports concurrently
+             * 
+             * The second port is scanned by a helper task pinned to the other core.
+             * 
+             * @param first First bus
+             * @param first_result Result for the first bus
+             * @param second Second bus
+             * @param second_result Result for the second bus
+             * @return esp_err_t ESP_OK if both scans succeeded, otherwise the first error
+             */
+            static esp_err_t Scan(I2c &first, ScanResult &first_result, I2c &second, ScanResult &second_result);
+
+            /**
+             * @brief Get the port this object drives
+             * 
+             * @return i2c_port_t I2C port number
+             */
+            i2c_port_t GetPort(void) const { return _port; }
+
+            /**
+             * @brief Take a transaction descriptor from this port's pool
+             * 
+             * O(1) and lock-free. Waits for a release or fails fast as
+             * configured by CONFIG_I2C_POOL_FAIL_FAST.
+             * 
+             * @return Transaction* Reset descriptor, or nullptr if the pool stayed exhausted
+             */
+            Transaction* AcquireTransaction(void);
+
+            /**
+             * @brief Return a descriptor obtained from AcquireTransaction()
+             * 
+             * @param transaction Descriptor to release
+             */
+            void ReleaseTransaction(Transaction *transaction);
+
+            /**
+             * @brief Get the usage counters of this port's command link pool
+             * 
+             * @return PoolStats Capacity, current use and high-water mark
+             */
+            PoolStats GetLinkPoolStats(void);
+
+            /**
+             * @brief Get the usage counters of this port's descriptor pool
+             * 
+             * @return PoolStats Capacity, current use and high-water mark
+             */
+            PoolStats GetDescriptorPoolStats(void);
+
+            /**
+             * @brief Read 16-bit words that each carry a Sensirion CRC-8
+             * 
+             * The device sends msb, lsb, crc for every word.
+             * 
+             * @param dev_addr I2C device address
+             * @param reg_addr Register or command to read from
+             * @param words Output for the words
+             * @param count Number of words, at most MAX_CRC_WORDS
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_CRC if a word CRC does not match
+             */
+            esp_err_t ReadWords(uint8_t dev_addr, uint8_t reg_addr, uint16_t *words, size_t count);
+
+            /**
+             * @brief Write 16-bit words, adding a Sensirion CRC-8 after each
+             * 
+             * @param dev_addr I2C device address
+             * @param reg_addr Register or command to write to
+             * @param words Words to write
+             * @param count Number of words, at most MAX_CRC_WORDS
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            esp_err_t WriteWords(uint8_t dev_addr, uint8_t reg_addr, const uint16_t *words, size_t count);
+
+            /**
+             * @brief Set the transaction policy for a device
+             * 
+             * Devices without a policy use a 1-second deadline and are never quarantined.
+             * 
+             * @param dev_addr I2C device address
+             * @param config Deadline and circuit breaker settings
+             * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the device table is full
+             */
+            esp_err_t ConfigureDevice(uint8_t dev_addr, const DeviceConfig &config);
+
+            /**
+             * @brief Get the transaction policy of a device
+             * 
+             * @param dev_addr I2C device address
+             * @param config Output policy
+             * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the device has no policy
+             */
+            esp_err_t GetDeviceConfig(uint8_t dev_addr, DeviceConfig &config);
+
+            /**
+             * @brief Check whether SDA or SCL is held low while the bus should be idle
+             * 
+             * @return true if a line is stuck low
+             */
+            bool IsBusStuck(void);
+
+            /**
+             * @brief Release a stuck bus and reset the driver
+             * 
+             * Clocks SCL nine times until the slave lets go of SDA, issues a STOP
+             * condition and reinstalls the driver with the original configuration.
+             * 
+             * @return esp_err_t ESP_OK if both lines are released afterwards, ESP_FAIL otherwise
+             */
+            esp_err_t RecoverBus(void);
+
+            /**
+             * @brief Check whether the circuit breaker currently isolates a device
+             * 
+             * @param dev_addr I2C device address
+             * @return true if transactions to the device are being refused
+             */
+            bool IsQuarantined(uint8_t dev_addr);
+
+            /**
+             * @brief Get a copy of the bus health counters
+             * 
+             * @return I2cMetrics Current counter values
+             */
+            I2cMetrics GetMetrics(void);
+
+            /**
+             * @brief Run a list of register accesses, grouped by bus timing
+             * 
+             * Transactions for devices sharing the currently programmed timing run
+             * first, then each remaining timing group in order of first appearance,
+             * so the controller is reprogrammed at most once per distinct timing.
+             * A timing is the SCL speed together with the SDA sample and hold
+             * points. Order is preserved within a group. Each entry's status is set.
+             * 
+             * @param transactions Transactions to run
+             * @param count Number of transactions
+             * @return esp_err_t ESP_OK if every transaction succeeded, otherwise the first error
+             */
+            esp_err_t ExecuteBatch(Transaction *transactions, size_t count);
+
+            /**
+             * @brief Find the highest SCL frequency a device handles reliably
+             * 
+             * Reads a known, stable register block at the device's current speed as
+             * a reference, then stress-reads it at increasing speeds up to 1 MHz. At
+             * each speed a few SDA sample/hold settings are tried and the first one
+             * that returns the reference on every read is kept. The fastest passing
+             * speed and its timing are stored in the device policy, and the
+             * device's circuit breaker is reset. A device without a policy gets
+             * one with the default deadline and no breaker, so only its speed
+             * and timing change.
+             * 
+             * @param dev_addr I2C device address
+             * @param reg_addr First register of a block whose contents do not change (e.g. an ID register)
+             * @param length Number of bytes to compare, at most 16
+             * @param iterations Reads per speed and timing setting
+             * @param max_clk_speed Optional output for the speed that was selected
+             * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the reference read fails
+             */
+            esp_err_t CalibrateDevice(uint8_t dev_addr, uint8_t reg_addr, size_t length, uint32_t iterations = 64, uint32_t *max_clk_speed = nullptr);
+
+            /**
+             * @brief Run device init programs, interleaving independent devices
+             * 
+             * Steps of all sequences are executed round-robin: while one device waits
+             * in a DELAY or between POLL reads, the others keep using the bus. With
+             * auto_increment set, adjacent WRITE/BURST steps to consecutive registers
+             * are merged into a single burst transaction. A failing sequence stops
+             * at the failing step, the others continue.
+             * 
+             * @param sequences Sequences to run, their status and elapsed_us are filled in
+             * @param count Number of sequences
+             * @param report Optional summary including the total init time
+             * @return esp_err_t ESP_OK if every sequence succeeded, otherwise the first error
+             */
+            esp_err_t RunInitSequences(InitSequence *sequences, size_t count, InitReport *report = nullptr);
+
+            /**
+             * @brief Run device init programs on two ports in parallel
+             * 
+             * The second port's sequences run in a helper task pinned to the other
+             * core while the calling task runs the first port's sequences.
+             * 
+             * @param first First bus
+             * @param first_sequences Sequences for devices on the first bus
+             * @param first_count Number of sequences for the first bus
+             * @param second Second bus
+             * @param second_sequences Sequences for devices on the second bus
+             * @param second_count Number of sequences for the second bus
+             * @param report Optional combined summary, total_us is the wall time of both
+             * @return esp_err_t ESP_OK if every sequence succeeded, otherwise the first error
+             */
+            static esp_err_t RunInitSequences(I2c &first, InitSequence *first_sequences, size_t first_count,
+                                              I2c &second, InitSequence *second_sequences, size_t second_count,
+                                              InitReport *report = nullptr);
     };
 }
 
@@ -0,0 +1,152 @@
+#ifndef I2C_ALERT_H
+#define I2C_ALERT_H
+
+#include "i2c.h"
+#include "gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+namespace I2C {
+    constexpr uint8_t ALERT_RESPONSE_ADDR = 0x0C;  ///< SMBus Alert Response Address
+
+    /**
+     * @brief Device handler run by an AlertRouter
+     * 
+     * @param dev_addr 7-bit address of the device that raised the alert
+     * @param status Status register value, or the raw Alert Response byte for ARA devices
+     * @param context Pointer given when the device was added
+     */
+    using AlertHandler = void (*)(uint8_t dev_addr, uint8_t status, void *context);
+
+    /**
+     * @brief Counters maintained by an AlertRouter
+     */
+    struct AlertStats {
+        uint32_t interrupts{};      ///< Alert line assertions seen by the ISR
+        uint32_t serviced{};        ///< Device handlers run
+        uint32_t ara_reads{};       ///< Alert Response Address reads
+        uint32_t status_reads{};    ///< Status register reads
+        uint32_t unclaimed{};       ///< Service rounds no device claimed
+    };
+
+    /**
+     * @brief Interrupt-driven servicing of devices on a shared alert line
+     * 
+     * Devices with an open-drain SMBALERT# or INT output share one active-low
+     * line. Its falling edge wakes a router task that finds the source, either
+     * with an SMBus Alert Response Address read or by reading each configured
+     * status register, and runs only that device's handler. While the line
+     * stays low the next source is serviced. Nothing goes on the bus while the
+     * line is idle.
+     */
+    class AlertRouter {
+        public:
+            static constexpr size_t MAX_ROUTES = 8;         ///< Devices one router can serve
+            static constexpr uint8_t MAX_ROUNDS = 8;        ///< Service rounds per wake-up while the line stays low
+            static constexpr uint32_t RETRY_MS = 10;        ///< Retry period while the line is held low by no known device
+
+        private:
+            struct _route {
+                uint8_t dev_addr;           ///< 7-bit device address
+                bool ara;                   ///< Identified by an Alert Response Address read
+                uint8_t status_reg;         ///< Status register of non-ARA devices
+                uint8_t status_mask;        ///< Bits of the status register that signal an alert
+                AlertHandler handler;       ///< Handler of the device
+                void *context;              ///< Handler argument
+            };
+
+            static constexpr int32_t STOP_SIGNAL = -1;      ///< Queue item that stops the router task
+            static constexpr size_t QUEUE_LENGTH = 4;       ///< Pending edges kept by the ISR
+
+            I2c &_bus;                                      ///< Bus the devices are on
+            GPIO::GpioInput _alert;                         ///< Shared alert line, active low
+            _route _routes[MAX_ROUTES]{};                   ///< Registered devices
+            size_t _route_count{};                          ///< Number of registered devices
+            bool _has_ara{false};                           ///< At least one device uses the Alert Response Address
+            AlertStats _stats{};                            ///< Counters
+            QueueHandle_t _queue{nullptr};                  ///< Edges from the GPIO ISR
+            StaticQueue_t _queue_buffer{};                  ///< Storage for _queue
+            uint8_t _queue_storage[QUEUE_LENGTH * sizeof(int32_t)]{};  ///< Items of _queue
+            TaskHandle_t _task{nullptr};                    ///< Router task
+            SemaphoreHandle_t _stopped{nullptr};            ///< Given by the task when it exits
+            StaticSemaphore_t _stopped_buffer{};            ///< Storage for _stopped
+            portMUX_TYPE _mutex = portMUX_INITIALIZER_UNLOCKED; ///< Protects _stats
+
+            static void _routerTask(void *arg);
+            esp_err_t _addRoute(const _route &route);
+            const _route *_serviceAra(uint8_t &status, AlertStats &stats);
+            const _route *_serviceStatus(uint8_t &status, AlertStats &stats);
+
+        public:
+            /**
+             * @brief Construct a router for an initialized master bus
+             * 
+             * @param bus Bus the devices are on
+             * @param alert_pin GPIO of the shared active-low alert line
+             */
+            AlertRouter(I2c &bus, gpio_num_t alert_pin);
+
+            /**
+             * @brief Stop the router task and release the alert interrupt
+             */
+            ~AlertRouter();
+
+            /**
+             * @brief Add a device identified by an Alert Response Address read
+             * 
+             * @param dev_addr 7-bit device address
+             * @param handler Handler run when the device answers the ARA read
+             * @param context Handler argument
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad address or handler,
+             *         ESP_ERR_NO_MEM if MAX_ROUTES devices are registered, ESP_ERR_INVALID_STATE if running
+             */
+            esp_err_t AddDevice(uint8_t dev_addr, AlertHandler handler, void *context = nullptr);
+
+            /**
+             * @brief Add a device identified by reading its status register
+             * 
+             * @param dev_addr 7-bit device address
+             * @param status_reg Register read to check the device
+             * @param status_mask Bits that signal an alert, the handler runs if any is set
+             * @param handler Handler run with the register value
+             * @param context Handler argument
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad address, mask or handler,
+             *         ESP_ERR_NO_MEM if MAX_ROUTES devices are registered, ESP_ERR_INVALID_STATE if running
+             */
+            esp_err_t AddDevice(uint8_t dev_addr, uint8_t status_reg, uint8_t status_mask, AlertHandler handler, void *context = nullptr);
+
+            /**
+             * @brief Enable the alert interrupt and start the router task
+             * 
+             * @param priority FreeRTOS priority of the router task, device handlers run at it
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if already running,
+             *         ESP_ERR_NO_MEM if the task could not be created, error code otherwise
+             */
+            esp_err_t Start(UBaseType_t priority = 10);
+
+            /**
+             * @brief Disable the alert interrupt and stop the router task
+             */
+            void Stop(void);
+
+            /**
+             * @brief Find the device behind the alert and run its handler
+             * 
+             * Called by the router task on every alert, may also be called
+             * directly when the router is not running.
+             * 
+             * @return esp_err_t ESP_OK if a device claimed the alert, ESP_ERR_NOT_FOUND otherwise
+             */
+            esp_err_t Service(void);
+
+            /**
+             * @brief Get the router counters
+             * 
+             * @return AlertStats Counters since construction
+             */
+            AlertStats GetStats(void);
+    };
+}
+
+#endif
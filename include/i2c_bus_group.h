@@ -0,0 +1,172 @@
+#ifndef I2C_BUS_GROUP_H
+#define I2C_BUS_GROUP_H
+
+#include "i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+namespace I2C {
+    /**
+     * @brief Load counters of one port in a bus group
+     */
+    struct PortStats {
+        uint32_t transactions{};            ///< Transactions run on the port
+        uint32_t errors{};                  ///< Transactions that returned an error
+        uint64_t busy_us{};                 ///< Time the port worker spent in transactions
+        uint64_t window_us{};               ///< Time since the counters were last reset
+        float utilization{};                ///< busy_us / window_us
+    };
+
+    /**
+     * @brief Device to port assignment proposed by I2cBusGroup::SuggestPlacement
+     */
+    struct PortPlacement {
+        uint8_t port[128]{};                ///< Port index for each 7-bit address
+        uint64_t projected_busy_us[2]{};    ///< Busy time each port would have had with this placement
+    };
+
+    /**
+     * @brief Runs transactions on both I2C controllers concurrently
+     * 
+     * Each port gets a worker task pinned to its own core. Submitted
+     * transactions are routed to the port a device is assigned to, both ports
+     * work in parallel, and the caller is released when all of them are done.
+     * Per-device bus time is recorded so a balanced placement can be
+     * suggested, and applied automatically to devices wired to both buses.
+     */
+    class I2cBusGroup {
+        private:
+            static constexpr size_t PORTS = 2;              ///< Controllers on the ESP32
+            static constexpr size_t QUEUE_LENGTH = 8;       ///< Pending jobs per port
+
+            /**
+             * @brief Work handed to a port worker
+             */
+            struct _job {
+                Transaction *transactions;      ///< Submitted transactions, nullptr asks the worker to exit
+                size_t count;                   ///< Number of transactions
+                const uint8_t *routes;          ///< Port of every device at submit time
+                SemaphoreHandle_t done;         ///< Given once per port when its share is finished
+            };
+
+            /**
+             * @brief Worker context of one port
+             */
+            struct _port {
+                I2cBusGroup *group{};               ///< Owning group
+                I2c *bus{};                         ///< Controller driven by this worker
+                uint8_t index{};                    ///< Port index within the group
+                TaskHandle_t task{nullptr};         ///< Worker task
+                SemaphoreHandle_t stopped{nullptr}; ///< Given by the worker when it exits
+                StaticSemaphore_t stopped_buffer{}; ///< Storage for stopped
+                QueueHandle_t queue{nullptr};       ///< Pending jobs
+                StaticQueue_t queue_buffer{};       ///< Storage for queue
+                uint8_t queue_storage[QUEUE_LENGTH * sizeof(_job)]{}; ///< Item storage for queue
+                PortStats stats{};                  ///< Load counters
+            };
+
+            _port _ports[PORTS];                    ///< Worker contexts
+            uint8_t _placement[128];                ///< Assigned port per device address
+            bool _mirrored[128]{};                  ///< Device is reachable from both ports
+            uint64_t _device_busy_us[128]{};        ///< Measured bus time per device
+            int64_t _window_start_us{};             ///< Start of the current statistics window
+            portMUX_TYPE _statsMutex = portMUX_INITIALIZER_UNLOCKED; ///< Protects statistics and placement
+
+            static void _worker(void *arg);
+            void _run(_port &port, const _job &job);
+            esp_err_t _moveDeviceConfig(uint8_t dev_addr, uint8_t from, uint8_t to);
+
+        public:
+            /**
+             * @brief Construct a group over two initialized master ports
+             * 
+             * Devices are placed on the first port until assigned otherwise.
+             * 
+             * @param first Bus on the first controller
+             * @param second Bus on the second controller
+             */
+            I2cBusGroup(I2c &first, I2c &second);
+
+            /**
+             * @brief Stop the port workers
+             */
+            ~I2cBusGroup();
+
+            /**
+             * @brief Stop the port workers, waiting for the jobs already queued
+             * 
+             * Submit() must not be in progress.
+             */
+            void Stop(void);
+
+            /**
+             * @brief Start one worker per port, pinned to core 0 and core 1
+             * 
+             * @param priority FreeRTOS priority of the workers
+             * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if a worker could not be created
+             */
+            esp_err_t Start(UBaseType_t priority = 5);
+
+            /**
+             * @brief Assign a device to a port
+             * 
+             * @param dev_addr I2C device address
+             * @param port Port index, 0 or 1
+             * @param mirrored true if the device is wired to both buses and may be moved by Rebalance()
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad address or port
+             */
+            esp_err_t AssignDevice(uint8_t dev_addr, uint8_t port, bool mirrored = false);
+
+            /**
+             * @brief Run transactions on both ports concurrently
+             * 
+             * Blocks until every transaction has finished. Order is preserved
+             * among transactions that run on the same port.
+             * 
+             * @param transactions Transactions to run, each status is filled in
+             * @param count Number of transactions
+             * @return esp_err_t ESP_OK if every transaction succeeded, ESP_ERR_INVALID_STATE if a port the
+             *         transactions route to has no worker, otherwise the first error
+             */
+            esp_err_t Submit(Transaction *transactions, size_t count);
+
+            /**
+             * @brief Get the load counters of a port
+             * 
+             * @param port Port index, 0 or 1
+             * @return PortStats Counters and utilization since the last reset
+             */
+            PortStats GetPortStats(uint8_t port);
+
+            /**
+             * @brief Start a new statistics window
+             */
+            void ResetStats(void);
+
+            /**
+             * @brief Propose a device placement that balances measured bus time
+             * 
+             * Devices wired to only one bus keep their port. Mirrored devices are
+             * placed largest load first onto the port with less projected load.
+             * 
+             * @param placement Output placement and projected load
+             */
+            void SuggestPlacement(PortPlacement &placement);
+
+            /**
+             * @brief Apply the suggested placement to mirrored devices
+             * 
+             * A moved device takes its DeviceConfig (deadline, speed, sample/hold
+             * timing, PEC and breaker settings) along, it is copied to the target
+             * bus with I2c::ConfigureDevice(). Its breaker state starts fresh there.
+             * A device is left in place if the copy fails, or if it has no policy
+             * on its current bus but one on the target bus, which cannot be removed.
+             * 
+             * @return size_t Number of devices that changed port
+             */
+            size_t Rebalance(void);
+    };
+}
+
+#endif
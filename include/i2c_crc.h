@@ -0,0 +1,103 @@
+#ifndef I2C_CRC_H
+#define I2C_CRC_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace I2C {
+    /**
+     * @brief Table-driven CRC-8 used by I2C devices
+     * 
+     * Two variants are provided:
+     * - SMBus PEC: polynomial 0x07, initial value 0x00, over the whole transaction
+     * - Sensirion: polynomial 0x31, initial value 0xFF, over each 2-byte word
+     * 
+     * Short inputs use one 256-entry table lookup per byte. Long inputs use
+     * slicing-by-4, which folds four bytes per step with four tables.
+     */
+    namespace Crc {
+        constexpr uint8_t SMBUS_POLY = 0x07;        ///< SMBus PEC polynomial x^8 + x^2 + x + 1
+        constexpr uint8_t SMBUS_INIT = 0x00;        ///< SMBus PEC initial value
+        constexpr uint8_t SENSIRION_POLY = 0x31;    ///< Sensirion polynomial x^8 + x^5 + x^4 + 1
+        constexpr uint8_t SENSIRION_INIT = 0xFF;    ///< Sensirion initial value
+
+        /**
+         * @brief Build the four slicing tables for a polynomial at compile time
+         * 
+         * tables[0] is the classic byte table, tables[k][x] is the CRC of x
+         * followed by k zero bytes.
+         * 
+         * @param poly Generator polynomial without the x^8 term
+         * @return std::array Four 256-entry tables
+         */
+        constexpr std::array<std::array<uint8_t, 256>, 4> MakeTables(uint8_t poly){
+            std::array<std::array<uint8_t, 256>, 4> tables{};
+            for (unsigned value = 0; value < 256; value++){
+                uint8_t crc = static_cast<uint8_t>(value);
+                for (int bit = 0; bit < 8; bit++){
+                    crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ poly) : static_cast<uint8_t>(crc << 1);
+                }
+                tables[0][value] = crc;
+            }
+            for (size_t slice = 1; slice < 4; slice++){
+                for (unsigned value = 0; value < 256; value++){
+                    tables[slice][value] = tables[0][tables[slice - 1][value]];
+                }
+            }
+            return tables;
+        }
+
+        /**
+         * @brief Bit-by-bit CRC-8, the reference the tables are checked against
+         * 
+         * @param data Input bytes
+         * @param length Number of bytes
+         * @param poly Generator polynomial
+         * @param crc Initial value, or the CRC of preceding data
+         * @return uint8_t CRC
+         */
+        uint8_t Bitwise(const uint8_t *data, size_t length, uint8_t poly, uint8_t crc);
+
+        /**
+         * @brief SMBus packet error code
+         * 
+         * @param data Input bytes
+         * @param length Number of bytes
+         * @param crc Initial value, or the PEC of the preceding bytes of the transaction
+         * @return uint8_t PEC
+         */
+        uint8_t Smbus(const uint8_t *data, size_t length, uint8_t crc = SMBUS_INIT);
+
+        /**
+         * @brief Sensirion CRC-8
+         * 
+         * @param data Input bytes, usually one 2-byte word
+         * @param length Number of bytes
+         * @param crc Initial value
+         * @return uint8_t CRC
+         */
+        uint8_t Sensirion(const uint8_t *data, size_t length, uint8_t crc = SENSIRION_INIT);
+
+        /**
+         * @brief Check and strip Sensirion word CRCs
+         * 
+         * @param frame Raw bytes as read: word msb, word lsb, crc, repeated
+         * @param words Output for the big-endian words
+         * @param count Number of words
+         * @return true if every CRC matched
+         */
+        bool UnpackSensirionWords(const uint8_t *frame, uint16_t *words, size_t count);
+
+        /**
+         * @brief Add Sensirion word CRCs
+         * 
+         * @param words Words to send
+         * @param frame Output, 3 bytes per word
+         * @param count Number of words
+         */
+        void PackSensirionWords(const uint16_t *words, uint8_t *frame, size_t count);
+    }
+}
+
+#endif
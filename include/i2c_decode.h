@@ -0,0 +1,166 @@
+#ifndef I2C_DECODE_H
+#define I2C_DECODE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace I2C {
+    /**
+     * @brief Decoding of raw sensor frames read over I2C
+     * 
+     * Sensors return samples as big-endian 12 to 24-bit fields. The array
+     * kernels here work a 32-bit word at a time instead of byte by byte, and
+     * physical scaling uses precomputed fixed-point multipliers instead of
+     * floats.
+     */
+    namespace Decode {
+        /**
+         * @brief Location of one field in a big-endian bit stream
+         * 
+         * Bit 0 is the most significant bit of the first frame byte, so a
+         * 20-bit value stored as msb, lsb, xlsb[7:4] starts at bit 0 with 20 bits.
+         */
+        struct PackedField {
+            uint16_t bit_offset;    ///< Offset of the field's most significant bit
+            uint8_t bits;           ///< Field width, 1 to 25
+            bool is_signed;         ///< Sign-extend the field
+        };
+
+        /**
+         * @brief Fixed-point conversion from raw counts to physical units
+         * 
+         * value = ((raw * multiplier) >> shift) + offset
+         */
+        struct Scale {
+            int32_t multiplier;     ///< Gain in Q(shift) format
+            uint8_t shift;          ///< Fraction bits of multiplier
+            int32_t offset;         ///< Added after scaling, in output units
+        };
+
+        /**
+         * @brief Build a Scale at compile time
+         * 
+         * @param gain Output units per raw count, e.g. 1000.0 / 16384 for mg at ±2 g
+         * @param offset Output units added after scaling
+         * @param shift Fraction bits, larger is more precise but limits the raw range
+         * @return Scale Precomputed multiplier
+         */
+        constexpr Scale MakeScale(double gain, int32_t offset = 0, uint8_t shift = 16){
+            const double scaled = gain * static_cast<double>(1u << shift);
+            return {static_cast<int32_t>(scaled >= 0 ? scaled + 0.5 : scaled - 0.5), shift, offset};
+        }
+
+        /**
+         * @brief Extract one field from a frame
+         * 
+         * Loads the covering bytes as one big-endian word, then shifts and
+         * masks. Inline so that constant layouts fold into fixed shifts.
+         * 
+         * @param frame Raw frame
+         * @param field Field location
+         * @return int32_t Field value, sign-extended if the field is signed
+         */
+        inline int32_t ExtractField(const uint8_t *frame, const PackedField &field){
+            const uint8_t *bytes = frame + field.bit_offset / 8;
+            const unsigned lead = field.bit_offset % 8;
+            const unsigned span = (lead + field.bits + 7) / 8;
+            uint32_t word{0};
+            for (unsigned i = 0; i < 4; i++){
+                word = (word << 8) | (i < span ? bytes[i] : 0);
+            }
+            const uint32_t value = (word << lead) >> (32 - field.bits);
+            if (field.is_signed){
+                return static_cast<int32_t>(value << (32 - field.bits)) >> (32 - field.bits);
+            }
+            return static_cast<int32_t>(value);
+        }
+
+        /**
+         * @brief Extract every field of a compile-time layout from a frame
+         * 
+         * @code
+         * static constexpr std::array<Decode::PackedField, 2> bmp280_layout{{
+         *     {0, 20, false},     // pressure: 0xF7..0xF9[7:4]
+         *     {24, 20, false},    // temperature: 0xFA..0xFC[7:4]
+         * }};
+         * int32_t raw[2];
+         * Decode::ExtractFields<bmp280_layout>(frame, raw);
+         * @endcode
+         * 
+         * @tparam Layout Field locations, must be a constexpr array
+         * @param frame Raw frame
+         * @param out One value per field
+         */
+        template<const auto &Layout>
+        inline void ExtractFields(const uint8_t *frame, int32_t *out){
+            for (size_t i = 0; i < Layout.size(); i++){
+                out[i] = ExtractField(frame, Layout[i]);
+            }
+        }
+
+        /**
+         * @brief Extract every field of a runtime layout from a frame
+         * 
+         * @param frame Raw frame
+         * @param layout Field locations
+         * @param count Number of fields
+         * @param out One value per field
+         */
+        void ExtractFields(const uint8_t *frame, const PackedField *layout, size_t count, int32_t *out);
+
+        /**
+         * @brief Convert big-endian int16 samples to native order
+         * 
+         * Two samples are swapped per 32-bit word. src and dst may alias.
+         * 
+         * @param src Raw bytes, 2 per sample
+         * @param dst Output samples
+         * @param count Number of samples
+         */
+        void SwapInt16(const uint8_t *src, int16_t *dst, size_t count);
+
+        /**
+         * @brief Convert big-endian 24-bit samples to sign-extended int32
+         * 
+         * Four samples are unpacked from three 32-bit words.
+         * 
+         * @param src Raw bytes, 3 per sample
+         * @param dst Output samples
+         * @param count Number of samples
+         */
+        void UnpackInt24(const uint8_t *src, int32_t *dst, size_t count);
+
+        /**
+         * @brief Convert left-justified 12-bit samples (two bytes each, low nibble unused) to int16
+         * 
+         * @param src Raw bytes, 2 per sample
+         * @param dst Output samples
+         * @param count Number of samples
+         * @param is_signed Sign-extend the samples
+         */
+        void UnpackInt12(const uint8_t *src, int16_t *dst, size_t count, bool is_signed = true);
+
+        /**
+         * @brief Apply a fixed-point scale to int16 samples
+         * 
+         * @param raw Raw samples
+         * @param out Scaled values
+         * @param count Number of samples
+         * @param scale Precomputed scale
+         */
+        void ApplyScale(const int16_t *raw, int32_t *out, size_t count, const Scale &scale);
+
+        /**
+         * @brief Apply a fixed-point scale to int32 samples
+         * 
+         * @param raw Raw samples, may alias out
+         * @param out Scaled values
+         * @param count Number of samples
+         * @param scale Precomputed scale
+         */
+        void ApplyScale(const int32_t *raw, int32_t *out, size_t count, const Scale &scale);
+    }
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef I2C_POOL_H
+#define I2C_POOL_H
+
+#include "sdkconfig.h"
+#include "lock_free_pool.h"
+
+#ifndef CONFIG_I2C_LINK_POOL_BLOCKS
+#define CONFIG_I2C_LINK_POOL_BLOCKS 4
+#endif
+
+#ifndef CONFIG_I2C_MAX_SEGMENTS
+#define CONFIG_I2C_MAX_SEGMENTS 8
+#endif
+
+#ifndef CONFIG_I2C_DESCRIPTOR_POOL_SIZE
+#define CONFIG_I2C_DESCRIPTOR_POOL_SIZE 8
+#endif
+
+#if !defined(CONFIG_I2C_POOL_FAIL_FAST) && !defined(CONFIG_I2C_POOL_WAIT_MS)
+#define CONFIG_I2C_POOL_WAIT_MS 1000
+#endif
+
+namespace I2C {
+    using Pool::LockFreePool;
+    using Pool::PoolStats;
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef I2C_PRESENCE_H
+#define I2C_PRESENCE_H
+
+#include "i2c.h"
+#include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace I2C {
+
+    ESP_EVENT_DECLARE_BASE(I2C_EVENTS);
+
+    /**
+     * @brief Event ids posted under I2C_EVENTS
+     */
+    enum PresenceEventId : int32_t {
+        DEVICE_ADDED,       ///< A device started acknowledging its address
+        DEVICE_REMOVED      ///< A device stopped acknowledging its address
+    };
+
+    /**
+     * @brief Event data of DEVICE_ADDED and DEVICE_REMOVED
+     */
+    struct PresenceEvent {
+        i2c_port_t port;    ///< Port the device is on
+        uint8_t dev_addr;   ///< 7-bit device address
+    };
+
+    /**
+     * @brief Background hot-plug detection on one bus
+     * 
+     * A low-priority task scans an address range at a fixed period and posts
+     * DEVICE_ADDED when an address starts answering and DEVICE_REMOVED when
+     * it has missed several scans in a row. Devices found by the first scan
+     * are reported as added. Events go to the default event loop unless a
+     * custom loop is given.
+     */
+    class PresenceMonitor {
+        private:
+            I2c &_bus;                              ///< Bus to watch
+            uint8_t _first_addr;                    ///< First address to scan
+            uint8_t _last_addr;                     ///< Last address to scan
+            uint8_t _miss_threshold;                ///< Consecutive misses before a device is reported removed
+            uint32_t _period_ms{};                  ///< Scan period
+            ScanResult _present{};                  ///< Devices currently considered present
+            uint8_t _misses[128]{};                 ///< Consecutive misses of present devices
+            esp_event_loop_handle_t _loop{nullptr}; ///< Custom event loop, nullptr for the default loop
+            TaskHandle_t _task{nullptr};            ///< Monitor task
+            SemaphoreHandle_t _stopped{nullptr};    ///< Given by the task when it exits
+            StaticSemaphore_t _stopped_buffer{};    ///< Storage for _stopped
+            portMUX_TYPE _mutex = portMUX_INITIALIZER_UNLOCKED; ///< Protects _present
+
+            static void _monitorTask(void *arg);
+            void _post(int32_t id, uint8_t dev_addr);
+
+        public:
+            /**
+             * @brief Construct a monitor for an initialized master bus
+             * 
+             * @param bus Bus to watch
+             * @param first_addr First address to scan
+             * @param last_addr Last address to scan
+             * @param miss_threshold Consecutive missed scans before a device is reported removed
+             */
+            PresenceMonitor(I2c &bus, uint8_t first_addr = FIRST_SCAN_ADDR, uint8_t last_addr = LAST_SCAN_ADDR, uint8_t miss_threshold = 2);
+
+            /**
+             * @brief Stop the monitor task
+             */
+            ~PresenceMonitor();
+
+            /**
+             * @brief Start scanning in the background
+             * 
+             * @param period_ms Time between scans
+             * @param priority FreeRTOS priority of the monitor task
+             * @param loop Custom event loop, nullptr to post to the default loop
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if already running, ESP_ERR_NO_MEM if the task could not be created
+             */
+            esp_err_t Start(uint32_t period_ms = 1000, UBaseType_t priority = 1, esp_event_loop_handle_t loop = nullptr);
+
+            /**
+             * @brief Stop scanning, waiting for a scan in progress to finish
+             */
+            void Stop(void);
+
+            /**
+             * @brief Run one scan and post events for changes
+             * 
+             * Called by the monitor task every period, may also be called
+             * directly when the monitor is not running.
+             * 
+             * @return esp_err_t ESP_OK on success, error code if the scan failed
+             */
+            esp_err_t Poll(void);
+
+            /**
+             * @brief Get the devices currently considered present
+             * 
+             * @return ScanResult Present addresses as of the last scan
+             */
+            ScanResult GetPresent(void);
+    };
+}
+
+#endif
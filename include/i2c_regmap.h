@@ -0,0 +1,345 @@
+#ifndef I2C_REGMAP_H
+#define I2C_REGMAP_H
+
+#include <algorithm>
+#include <cassert>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include "i2c.h"
+
+namespace I2C {
+    /**
+     * @brief Access mode of a device register
+     */
+    enum class Access : uint8_t {
+        RO,     ///< Read only, writes are rejected at compile time
+        WO,     ///< Write only, reads are rejected at compile time and updates never read back
+        RW      ///< Read and write
+    };
+
+    /**
+     * @brief Byte order of a multi-byte register
+     */
+    enum class Endian : uint8_t {
+        BIG,    ///< Most significant byte at the lowest address
+        LITTLE  ///< Least significant byte at the lowest address
+    };
+
+    /**
+     * @brief How a device addresses its registers on the wire
+     */
+    struct RegisterAddressing {
+        uint8_t address_bytes = 1;      ///< Register address width, 1 or 2 bytes sent most significant first
+        bool auto_increment = true;     ///< The device advances to the next register within a burst
+    };
+
+    /**
+     * @brief Compile-time description of a device register
+     * 
+     * @tparam Address Register address, above 0xFF only for devices with 2-byte addressing
+     * @tparam Width Register width in bytes, 1 to 4
+     * @tparam Order Byte order of multi-byte registers
+     * @tparam Mode Access mode
+     */
+    template<uint16_t Address, size_t Width = 1, Endian Order = Endian::BIG, Access Mode = Access::RW>
+    struct Register {
+        static_assert(Width >= 1 && Width <= 4, "Register width must be 1 to 4 bytes");
+
+        /** @brief Unsigned type that holds the raw register value. */
+        using value_type = std::conditional_t<Width == 1, uint8_t, std::conditional_t<Width == 2, uint16_t, uint32_t>>;
+
+        static constexpr uint16_t address = Address;    ///< Register address
+        static constexpr size_t width = Width;          ///< Width in bytes
+        static constexpr Endian endian = Order;         ///< Byte order
+        static constexpr Access access = Mode;          ///< Access mode
+        static constexpr value_type full_mask = static_cast<value_type>(Width == 4 ? 0xFFFFFFFFu : (1u << (8 * Width)) - 1); ///< All register bits
+
+        /**
+         * @brief Assemble the raw value from bus bytes
+         * 
+         * @param bytes Width bytes as read from the device
+         * @return value_type Raw register value
+         */
+        static constexpr value_type decode(const uint8_t *bytes){
+            uint32_t raw{0};
+            for (size_t i = 0; i < Width; i++){
+                const size_t index = Order == Endian::BIG ? i : Width - 1 - i;
+                raw = (raw << 8) | bytes[index];
+            }
+            return static_cast<value_type>(raw);
+        }
+
+        /**
+         * @brief Split a raw value into bus bytes
+         * 
+         * @param raw Raw register value
+         * @param bytes Output for Width bytes in bus order
+         */
+        static constexpr void encode(value_type raw, uint8_t *bytes){
+            for (size_t i = 0; i < Width; i++){
+                const size_t index = Order == Endian::BIG ? Width - 1 - i : i;
+                bytes[index] = static_cast<uint8_t>(raw >> (8 * i));
+            }
+        }
+    };
+
+    /**
+     * @brief Compile-time description of a bit field within a register
+     * 
+     * @tparam Reg Register the field lives in
+     * @tparam Offset Position of the least significant bit
+     * @tparam Bits Field width in bits
+     * @tparam T Type the field is presented as, may be an enum or bool
+     */
+    template<typename Reg, unsigned Offset, unsigned Bits,
+             typename T = std::conditional_t<Bits <= 8, uint8_t, std::conditional_t<Bits <= 16, uint16_t, uint32_t>>>
+    struct Field {
+        static_assert(Bits > 0 && Offset + Bits <= 8 * Reg::width, "Field does not fit its register");
+
+        using reg = Reg;                                            ///< Register the field lives in
+        using type = T;                                             ///< Presented type
+        using value_type = typename Reg::value_type;                ///< Raw register type
+
+        static constexpr value_type mask = static_cast<value_type>(
+            (Bits == 32 ? 0xFFFFFFFFu : ((1u << Bits) - 1)) << Offset);  ///< Field bits within the register
+
+        /**
+         * @brief Extract the field from a raw register value
+         * 
+         * @param raw Raw register value
+         * @return T Field value
+         */
+        static constexpr T get(value_type raw){
+            return static_cast<T>((raw & mask) >> Offset);
+        }
+
+        /**
+         * @brief Replace the field in a raw register value
+         * 
+         * @param raw Raw register value
+         * @param value New field value
+         * @return value_type Raw value with the field replaced
+         */
+        static constexpr value_type set(value_type raw, T value){
+            return static_cast<value_type>((raw & ~mask) | ((static_cast<value_type>(value) << Offset) & mask));
+        }
+    };
+
+    /**
+     * @brief True if all fields live in the same register
+     */
+    template<typename First, typename... Rest>
+    inline constexpr bool SameRegister = (std::is_same_v<typename First::reg, typename Rest::reg> && ...);
+
+    /**
+     * @brief True if no two fields share a bit
+     */
+    template<typename... Fields>
+    inline constexpr bool DisjointFields =
+        (std::popcount(static_cast<uint32_t>(Fields::mask)) + ...) == std::popcount(static_cast<uint32_t>((Fields::mask | ...)));
+
+    /**
+     * @brief Number of bytes a burst covering the registers of all fields spans
+     */
+    template<typename... Fields>
+    inline constexpr size_t BurstSpan =
+        std::max({static_cast<size_t>(Fields::reg::address + Fields::reg::width)...}) - std::min({Fields::reg::address...});
+
+    /**
+     * @brief Typed register access to one device
+     * 
+     * Field accessors are templates over the register map, so masks, shifts
+     * and the number of transactions are all resolved at compile time:
+     * - Read<F>() reads only the register of F
+     * - Update<F1, F2, ...>() changes several fields of one register with a
+     *   single write, reading it first only if the fields leave other bits
+     *   untouched and the register is readable
+     * - ReadFields<F1, F2, ...>() reads fields spread over consecutive
+     *   registers with one burst, or one read per field on devices without
+     *   auto-increment
+     * 
+     * The register address width and auto-increment behaviour are given per
+     * device with RegisterAddressing, the default is 1-byte addresses with
+     * auto-increment.
+     */
+    class RegisterDevice {
+        private:
+            I2c &_bus;                          ///< Bus the device is on
+            uint8_t _addr;                      ///< I2C device address
+            RegisterAddressing _addressing;     ///< Register addressing of the device
+
+            /**
+             * @brief Check that a register address fits the device's address width
+             * 
+             * @param reg Register address
+             * @return true if the address can be sent
+             */
+            bool _fits(uint16_t reg) const {
+                return _addressing.address_bytes == 2 || reg <= 0xFF;
+            }
+
+            /**
+             * @brief Read bytes starting at a register
+             * 
+             * @param reg Register address
+             * @param bytes Destination
+             * @param length Number of bytes
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if the address does not fit, error code otherwise
+             */
+            esp_err_t _read(uint16_t reg, uint8_t *bytes, size_t length){
+                if (!_fits(reg)){
+                    return ESP_ERR_INVALID_ARG;
+                }
+                if (_addressing.address_bytes == 1){
+                    return _bus.ReadRegisterMultipleBytes(_addr, static_cast<uint8_t>(reg), bytes, length);
+                }
+                const uint8_t header[2] = {static_cast<uint8_t>(reg >> 8), static_cast<uint8_t>(reg)};
+                const std::span<const uint8_t> tx[1] {{header, 2}};
+                const std::span<uint8_t> rx[1] {{bytes, length}};
+                return _bus.WriteRead(_addr, tx, rx);
+            }
+
+            /**
+             * @brief Write bytes starting at a register
+             * 
+             * @param reg Register address
+             * @param bytes Source
+             * @param length Number of bytes
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if the address does not fit, error code otherwise
+             */
+            esp_err_t _write(uint16_t reg, uint8_t *bytes, size_t length){
+                if (!_fits(reg)){
+                    return ESP_ERR_INVALID_ARG;
+                }
+                if (_addressing.address_bytes == 1){
+                    return _bus.WriteRegisterMultipleBytes(_addr, static_cast<uint8_t>(reg), bytes, length);
+                }
+                const uint8_t header[2] = {static_cast<uint8_t>(reg >> 8), static_cast<uint8_t>(reg)};
+                const std::span<const uint8_t> tx[2] {{header, 2}, {bytes, length}};
+                return _bus.Write(_addr, tx);
+            }
+
+        public:
+            /**
+             * @brief Bind a device on a bus
+             * 
+             * @param bus Initialized I2C bus
+             * @param dev_addr I2C device address
+             * @param addressing Register address width and auto-increment behaviour, address_bytes must be 1 or 2
+             */
+            RegisterDevice(I2c &bus, uint8_t dev_addr, RegisterAddressing addressing = {})
+                : _bus(bus), _addr(dev_addr), _addressing(addressing) {
+                assert(addressing.address_bytes == 1 || addressing.address_bytes == 2);
+            }
+
+            /**
+             * @brief Read a whole register
+             * 
+             * @param raw Output for the raw register value
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<typename Reg>
+            esp_err_t ReadRegister(typename Reg::value_type &raw){
+                static_assert(Reg::access != Access::WO, "Register is write-only");
+                uint8_t bytes[Reg::width];
+                esp_err_t status = _read(Reg::address, bytes, Reg::width);
+                if (status == ESP_OK){
+                    raw = Reg::decode(bytes);
+                }
+                return status;
+            }
+
+            /**
+             * @brief Write a whole register
+             * 
+             * @param raw Raw register value
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<typename Reg>
+            esp_err_t WriteRegister(typename Reg::value_type raw){
+                static_assert(Reg::access != Access::RO, "Register is read-only");
+                uint8_t bytes[Reg::width];
+                Reg::encode(raw, bytes);
+                return _write(Reg::address, bytes, Reg::width);
+            }
+
+            /**
+             * @brief Read one field
+             * 
+             * @param value Output for the field value
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<typename F>
+            esp_err_t Read(typename F::type &value){
+                typename F::reg::value_type raw{};
+                esp_err_t status = ReadRegister<typename F::reg>(raw);
+                if (status == ESP_OK){
+                    value = F::get(raw);
+                }
+                return status;
+            }
+
+            /**
+             * @brief Change several fields of one register with a single write
+             * 
+             * @param values New values, in the order of the field parameters
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<typename... Fields>
+            esp_err_t Update(typename Fields::type... values){
+                static_assert(sizeof...(Fields) > 0, "Update needs at least one field");
+                static_assert(SameRegister<Fields...>, "Fields updated together must share a register");
+                static_assert(DisjointFields<Fields...>, "Fields updated together must not overlap");
+                using Reg = typename std::tuple_element_t<0, std::tuple<Fields...>>::reg;
+                static_assert(Reg::access != Access::RO, "Register is read-only");
+
+                constexpr typename Reg::value_type covered = (Fields::mask | ...);
+                typename Reg::value_type raw{};
+                if constexpr (covered != Reg::full_mask && Reg::access == Access::RW){
+                    esp_err_t status = ReadRegister<Reg>(raw);
+                    if (status != ESP_OK){
+                        return status;
+                    }
+                }
+                ((raw = Fields::set(raw, values)), ...);
+                return WriteRegister<Reg>(raw);
+            }
+
+            /**
+             * @brief Read fields from consecutive registers with one burst
+             * 
+             * Devices without auto-increment read each field's register on
+             * its own instead.
+             * 
+             * @param values Outputs, in the order of the field parameters
+             * @return esp_err_t ESP_OK on success, error code otherwise
+             */
+            template<typename... Fields>
+            esp_err_t ReadFields(typename Fields::type&... values){
+                static_assert(sizeof...(Fields) > 0, "ReadFields needs at least one field");
+                static_assert(((Fields::reg::access != Access::WO) && ...), "A field is in a write-only register");
+                constexpr uint16_t first = std::min({Fields::reg::address...});
+                constexpr size_t span = BurstSpan<Fields...>;
+                static_assert(span <= 32, "Fields must lie within one 32-byte burst");
+
+                if (!_addressing.auto_increment){
+                    esp_err_t status{ESP_OK};
+                    ((status = status == ESP_OK ? Read<Fields>(values) : status), ...);
+                    return status;
+                }
+
+                uint8_t bytes[span];
+                esp_err_t status = _read(first, bytes, span);
+                if (status == ESP_OK){
+                    ((values = Fields::get(Fields::reg::decode(&bytes[Fields::reg::address - first]))), ...);
+                }
+                return status;
+            }
+    };
+}
+
+#endif
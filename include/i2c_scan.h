@@ -0,0 +1,43 @@
+#ifndef I2C_SCAN_H
+#define I2C_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace I2C {
+    constexpr uint8_t FIRST_SCAN_ADDR = 0x08;  ///< Lowest non-reserved 7-bit address
+    constexpr uint8_t LAST_SCAN_ADDR = 0x77;   ///< Highest non-reserved 7-bit address
+
+    /**
+     * @brief Set of 7-bit addresses that acknowledged a probe
+     */
+    struct ScanResult {
+        uint32_t present[4]{};              ///< One bit per 7-bit address
+        size_t count{};                     ///< Number of addresses that answered
+        uint32_t elapsed_us{};              ///< Wall time of the scan
+
+        /**
+         * @brief Check whether an address answered
+         * 
+         * @param dev_addr 7-bit address
+         * @return true if the address is present
+         */
+        constexpr bool Contains(uint8_t dev_addr) const {
+            return dev_addr < 128 && (present[dev_addr / 32] >> (dev_addr % 32)) & 1;
+        }
+
+        /**
+         * @brief Mark an address as present
+         * 
+         * @param dev_addr 7-bit address
+         */
+        constexpr void Add(uint8_t dev_addr){
+            if (dev_addr < 128 && !Contains(dev_addr)){
+                present[dev_addr / 32] |= 1u << (dev_addr % 32);
+                count++;
+            }
+        }
+    };
+}
+
+#endif
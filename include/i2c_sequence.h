@@ -0,0 +1,168 @@
+#ifndef I2C_SEQUENCE_H
+#define I2C_SEQUENCE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "esp_err.h"
+
+namespace I2C {
+    /**
+     * @brief Opcodes of the device init sequence bytecode
+     * 
+     * A program is a flat byte array of steps terminated by END:
+     * - WRITE  reg value                                   (3 bytes)
+     * - BURST  reg count byte...                           (3 + count bytes)
+     * - DELAY  ms_lo ms_hi                                 (3 bytes)
+     * - POLL   reg mask value timeout_lo timeout_hi        (6 bytes)
+     * - VERIFY reg mask value                              (4 bytes)
+     */
+    enum class InitOp : uint8_t {
+        END = 0,     ///< End of program
+        WRITE = 1,   ///< Write one register
+        BURST = 2,   ///< Write consecutive registers
+        DELAY = 3,   ///< Wait before the next step of this device
+        POLL = 4,    ///< Re-read a register until (value & mask) matches or the timeout expires
+        VERIFY = 5   ///< Read a register once and fail if (value & mask) does not match
+    };
+
+    /**
+     * @brief Builders for init sequence programs
+     * 
+     * All builders are constexpr so a complete program can be declared as
+     * static constexpr data and stays in flash:
+     * 
+     * @code
+     * static constexpr auto bme280_init = I2C::Init::Sequence(
+     *     I2C::Init::Write(0xE0, 0xB6),
+     *     I2C::Init::Delay(2),
+     *     I2C::Init::PollUntil(0xF3, 0x01, 0x00, 50),
+     *     I2C::Init::BurstWrite(0xF4, 0x27, 0xA0));
+     * @endcode
+     */
+    namespace Init {
+        /**
+         * @brief Write one register
+         * 
+         * @param reg Register address
+         * @param value Value to write
+         */
+        constexpr std::array<uint8_t, 3> Write(uint8_t reg, uint8_t value){
+            return {static_cast<uint8_t>(InitOp::WRITE), reg, value};
+        }
+
+        /**
+         * @brief Write consecutive registers starting at reg
+         * 
+         * @param reg First register address
+         * @param bytes Values to write, at most 32
+         */
+        template<typename... Bytes>
+        constexpr std::array<uint8_t, 3 + sizeof...(Bytes)> BurstWrite(uint8_t reg, Bytes... bytes){
+            static_assert(sizeof...(Bytes) > 0 && sizeof...(Bytes) <= 32, "Burst length must be 1 to 32 bytes");
+            return {static_cast<uint8_t>(InitOp::BURST), reg, static_cast<uint8_t>(sizeof...(Bytes)), static_cast<uint8_t>(bytes)...};
+        }
+
+        /**
+         * @brief Wait before the next step of this device
+         * 
+         * Other devices keep running while one device waits.
+         * 
+         * @param ms Delay in milliseconds
+         */
+        constexpr std::array<uint8_t, 3> Delay(uint16_t ms){
+            return {static_cast<uint8_t>(InitOp::DELAY), static_cast<uint8_t>(ms & 0xFF), static_cast<uint8_t>(ms >> 8)};
+        }
+
+        /**
+         * @brief Re-read a register until (register & mask) == value
+         * 
+         * @param reg Register address
+         * @param mask Bits to compare
+         * @param value Expected value of the masked bits
+         * @param timeout_ms Time after which the sequence fails with ESP_ERR_TIMEOUT
+         */
+        constexpr std::array<uint8_t, 6> PollUntil(uint8_t reg, uint8_t mask, uint8_t value, uint16_t timeout_ms){
+            return {static_cast<uint8_t>(InitOp::POLL), reg, mask, value,
+                    static_cast<uint8_t>(timeout_ms & 0xFF), static_cast<uint8_t>(timeout_ms >> 8)};
+        }
+
+        /**
+         * @brief Read a register once and fail with ESP_ERR_INVALID_RESPONSE unless (register & mask) == value
+         * 
+         * @param reg Register address
+         * @param mask Bits to compare
+         * @param value Expected value of the masked bits
+         */
+        constexpr std::array<uint8_t, 4> Verify(uint8_t reg, uint8_t mask, uint8_t value){
+            return {static_cast<uint8_t>(InitOp::VERIFY), reg, mask, value};
+        }
+
+        /**
+         * @brief Concatenate steps into a program terminated by END
+         * 
+         * @param steps Steps produced by the other builders
+         */
+        template<size_t... N>
+        constexpr std::array<uint8_t, (N + ... + 0) + 1> Sequence(const std::array<uint8_t, N>&... steps){
+            std::array<uint8_t, (N + ... + 0) + 1> program{};
+            size_t offset{0};
+            auto append = [&](const auto &step){
+                for (uint8_t byte : step){
+                    program[offset++] = byte;
+                }
+            };
+            (append(steps), ...);
+            program[offset] = static_cast<uint8_t>(InitOp::END);
+            return program;
+        }
+    }
+
+    /**
+     * @brief Init program bound to a device, with its execution state
+     * 
+     * The program itself is referenced, not copied, so it can stay in flash.
+     */
+    struct InitSequence {
+        uint8_t dev_addr{};                 ///< I2C device address
+        const uint8_t *program{};           ///< Program built with Init::Sequence()
+        size_t length{};                    ///< Program size in bytes
+        bool auto_increment{true};          ///< Device advances the register address on multi-byte writes, allowing merges
+        esp_err_t status{ESP_OK};           ///< Result, filled in by the executor
+        uint32_t elapsed_us{};              ///< Time from start until this device finished
+
+        size_t pc{};                        ///< Executor: offset of the next step
+        int64_t ready_at_us{};              ///< Executor: earliest time the next step may run
+        int64_t poll_deadline_us{};         ///< Executor: deadline of the POLL step in progress, 0 if none
+    };
+
+    /**
+     * @brief Bind a program to a device
+     * 
+     * @param dev_addr I2C device address
+     * @param program Program built with Init::Sequence()
+     * @param auto_increment Whether adjacent register writes may be merged into one burst
+     * @return InitSequence Sequence ready to pass to I2c::RunInitSequences()
+     */
+    template<size_t N>
+    constexpr InitSequence MakeInitSequence(uint8_t dev_addr, const std::array<uint8_t, N> &program, bool auto_increment = true){
+        InitSequence sequence{};
+        sequence.dev_addr = dev_addr;
+        sequence.program = program.data();
+        sequence.length = N;
+        sequence.auto_increment = auto_increment;
+        return sequence;
+    }
+
+    /**
+     * @brief Summary of one init run
+     */
+    struct InitReport {
+        uint32_t total_us{};                ///< Wall time for all sequences
+        uint32_t transactions{};            ///< Bus transactions issued
+        uint32_t merged_writes{};           ///< Write steps folded into a preceding burst
+        uint32_t failed_sequences{};        ///< Sequences that ended with an error
+    };
+}
+
+#endif
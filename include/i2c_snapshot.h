@@ -0,0 +1,133 @@
+#ifndef I2C_SNAPSHOT_H
+#define I2C_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace I2C {
+    /**
+     * @brief Sequence-locked publication of the latest value of T
+     * 
+     * One writer, usually the task that owns the bus, publishes values and
+     * any number of readers on either core copy the latest one. Nobody takes
+     * a lock. The sequence is odd while a write is in progress, and
+     * version n lives in slot n % Buffers.
+     * 
+     * With the default two buffers the writer fills the slot readers are not
+     * using, so a read only retries if the reader is preempted for a whole
+     * write. A reader never waits for a writer that is stuck mid-write. With
+     * one buffer, readers that overlap a write retry until it finishes.
+     * 
+     * @tparam T Trivially copyable value type
+     * @tparam Buffers Number of slots, 1 or 2
+     */
+    template<typename T, size_t Buffers = 2>
+    class Snapshot {
+        static_assert(std::is_trivially_copyable_v<T>, "Snapshot values are copied byte-wise");
+        static_assert(Buffers == 1 || Buffers == 2, "Snapshot supports one or two buffers");
+
+        private:
+            static constexpr uint32_t SPINS_BEFORE_SLEEP = 64; ///< Failed attempts before Read() sleeps a tick
+
+            std::atomic<uint32_t> _sequence{0};     ///< Twice the published version, plus one while writing
+            T _slots[Buffers]{};                    ///< Published values
+
+        public:
+            Snapshot() = default;
+            Snapshot(const Snapshot&) = delete;
+            Snapshot& operator=(const Snapshot&) = delete;
+
+            /**
+             * @brief Publish a new value
+             * 
+             * Wait-free, must only be called by one task at a time.
+             * 
+             * @param value Value to publish
+             */
+            void Publish(const T &value){
+                const uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+                const uint32_t version = (sequence >> 1) + 1;
+                _sequence.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                std::memcpy(&_slots[version % Buffers], &value, sizeof(T));
+                _sequence.store(sequence + 2, std::memory_order_release);
+            }
+
+            /**
+             * @brief Copy the latest value once
+             * 
+             * @param value Set to the latest value on success
+             * @param version Set to the version of the value, 0 before the first Publish()
+             * @return true if the copy is consistent, false if a write overlapped it
+             */
+            bool TryRead(T &value, uint32_t *version = nullptr) const {
+                const uint32_t begin = _sequence.load(std::memory_order_acquire);
+                const uint32_t published = begin >> 1;
+                if (Buffers == 1 && (begin & 1)){
+                    return false;
+                }
+
+                std::memcpy(&value, &_slots[published % Buffers], sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const uint32_t end = _sequence.load(std::memory_order_relaxed);
+
+                // The slot is rewritten once the write of version published + Buffers starts
+                if (end - (begin & ~1u) >= 2 * Buffers - 1){
+                    return false;
+                }
+                if (version != nullptr){
+                    *version = published;
+                }
+                return true;
+            }
+
+            /**
+             * @brief Copy the latest value, retrying until the copy is consistent
+             * 
+             * @param version Set to the version of the value, 0 before the first Publish()
+             * @return T Latest value
+             */
+            T Read(uint32_t *version = nullptr) const {
+                T value;
+                uint32_t attempts{};
+                while (!TryRead(value, version)){
+                    // A preempted single-buffer writer only finishes if the reader lets it run
+                    if (++attempts % SPINS_BEFORE_SLEEP == 0){
+                        vTaskDelay(1);
+                    }
+                }
+                return value;
+            }
+
+            /**
+             * @brief Copy the latest value if it is newer than one already seen
+             * 
+             * @param value Set to the latest value if it is newer
+             * @param version Version already seen, updated when a newer value is copied
+             * @return true if a newer value was copied
+             */
+            bool ReadIfNewer(T &value, uint32_t &version) const {
+                if (GetVersion() == version){
+                    return false;
+                }
+                value = Read(&version);
+                return true;
+            }
+
+            /**
+             * @brief Get the number of values published so far
+             * 
+             * @return uint32_t Version of the latest complete value
+             */
+            uint32_t GetVersion(void) const {
+                return _sequence.load(std::memory_order_acquire) >> 1;
+            }
+    };
+}
+
+#endif
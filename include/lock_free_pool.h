@@ -0,0 +1,175 @@
+#ifndef LOCK_FREE_POOL_H
+#define LOCK_FREE_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+namespace Pool {
+    /**
+     * @brief Usage counters of a fixed-size pool
+     */
+    struct PoolStats {
+        size_t capacity{};                  ///< Number of entries
+        size_t in_use{};                    ///< Entries currently acquired
+        size_t high_water{};                ///< Most entries ever acquired at once
+        uint32_t acquisitions{};            ///< Successful acquisitions
+        uint32_t exhaustions{};             ///< Acquisitions that found the pool empty
+    };
+
+    /**
+     * @brief Preallocated pool of N objects with lock-free O(1) acquire and release
+     * 
+     * Free entries form a Treiber stack of indices. The head packs the top
+     * index with a tag that changes on every update, so a pop that raced
+     * with a pop and push of the same entry fails its compare-and-swap
+     * instead of corrupting the list. Callers that may wait block on a
+     * counting semaphore that every release gives.
+     * 
+     * @tparam T Entry type
+     * @tparam N Number of entries, fewer than 65535
+     */
+    template<typename T, size_t N>
+    class LockFreePool {
+        static_assert(N > 0 && N < 0xFFFF, "Pool size must fit a 16-bit index");
+
+        private:
+            static constexpr uint16_t EMPTY = 0xFFFF;   ///< End of the free list
+
+            T _entries[N]{};                            ///< Pool storage
+            std::atomic<uint16_t> _next[N];             ///< Free-list link of each entry
+            std::atomic<uint32_t> _head;                ///< Tag in the upper, top index in the lower 16 bits
+            std::atomic<uint32_t> _in_use{0};           ///< Entries currently acquired
+            std::atomic<uint32_t> _high_water{0};       ///< Most entries acquired at once
+            std::atomic<uint32_t> _acquisitions{0};     ///< Successful acquisitions
+            std::atomic<uint32_t> _exhaustions{0};      ///< Empty-pool encounters
+            std::atomic<uint32_t> _waiters{0};          ///< Tasks blocked in Acquire()
+            SemaphoreHandle_t _released{nullptr};       ///< Given on release while tasks wait
+            StaticSemaphore_t _released_buffer{};       ///< Storage for _released
+
+            /**
+             * @brief Pop the top of the free list
+             * 
+             * @return T* Entry, or nullptr if the list is empty
+             */
+            T* _pop(void){
+                uint32_t head = _head.load(std::memory_order_acquire);
+                while (true){
+                    const uint16_t index = static_cast<uint16_t>(head);
+                    if (index == EMPTY){
+                        return nullptr;
+                    }
+                    const uint32_t next = ((head + 0x10000) & 0xFFFF0000) | _next[index].load(std::memory_order_relaxed);
+                    if (_head.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)){
+                        return &_entries[index];
+                    }
+                }
+            }
+
+            /**
+             * @brief Push an entry onto the free list
+             * 
+             * @param entry Entry to free
+             */
+            void _push(T *entry){
+                const uint16_t index = static_cast<uint16_t>(entry - _entries);
+                uint32_t head = _head.load(std::memory_order_relaxed);
+                do {
+                    _next[index].store(static_cast<uint16_t>(head), std::memory_order_relaxed);
+                } while (!_head.compare_exchange_weak(head, ((head + 0x10000) & 0xFFFF0000) | index,
+                                                       std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            /**
+             * @brief Update the usage counters after a successful pop
+             */
+            void _countAcquired(void){
+                const uint32_t in_use = _in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+                uint32_t high = _high_water.load(std::memory_order_relaxed);
+                while (in_use > high && !_high_water.compare_exchange_weak(high, in_use, std::memory_order_relaxed)){}
+                _acquisitions.fetch_add(1, std::memory_order_relaxed);
+            }
+
+        public:
+            /**
+             * @brief Construct a pool with every entry free
+             */
+            LockFreePool(){
+                for (size_t i = 0; i < N; i++){
+                    _next[i].store(i + 1 < N ? static_cast<uint16_t>(i + 1) : EMPTY, std::memory_order_relaxed);
+                }
+                _head.store(0, std::memory_order_release);
+                _released = xSemaphoreCreateCountingStatic(N, 0, &_released_buffer);
+            }
+
+            LockFreePool(const LockFreePool &) = delete;
+            LockFreePool &operator=(const LockFreePool &) = delete;
+
+            /**
+             * @brief Take a free entry
+             * 
+             * @param wait Ticks to wait for a release if the pool is empty, 0 to fail fast
+             * @return T* Entry, or nullptr if none became free in time
+             */
+            T* Acquire(TickType_t wait = 0){
+                T *entry = _pop();
+                if (entry == nullptr){
+                    _exhaustions.fetch_add(1, std::memory_order_relaxed);
+                    if (wait > 0){
+                        const TickType_t start = xTaskGetTickCount();
+                        _waiters.fetch_add(1, std::memory_order_acq_rel);
+                        while ((entry = _pop()) == nullptr){
+                            const TickType_t waited = xTaskGetTickCount() - start;
+                            if (waited >= wait || xSemaphoreTake(_released, wait - waited) != pdTRUE){
+                                entry = _pop();
+                                break;
+                            }
+                        }
+                        _waiters.fetch_sub(1, std::memory_order_acq_rel);
+                    }
+                }
+                if (entry != nullptr){
+                    _countAcquired();
+                }
+                return entry;
+            }
+
+            /**
+             * @brief Return an entry to the pool
+             * 
+             * @param entry Entry obtained from Acquire()
+             */
+            void Release(T *entry){
+                _in_use.fetch_sub(1, std::memory_order_relaxed);
+                _push(entry);
+                if (_waiters.load(std::memory_order_acquire) > 0){
+                    xSemaphoreGive(_released);
+                }
+            }
+
+            /**
+             * @brief Check whether an entry belongs to this pool
+             * 
+             * @param entry Pointer to check
+             * @return true if entry is one of the pool's entries
+             */
+            bool Owns(const T *entry) const {
+                return entry >= _entries && entry < _entries + N;
+            }
+
+            /**
+             * @brief Get the usage counters
+             * 
+             * @return PoolStats Capacity, current use and high-water mark
+             */
+            PoolStats GetStats(void) const {
+                return {N, _in_use.load(std::memory_order_relaxed), _high_water.load(std::memory_order_relaxed),
+                        _acquisitions.load(std::memory_order_relaxed), _exhaustions.load(std::memory_order_relaxed)};
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+
+#ifndef CONFIG_METRICS_MAX_DEVICES
+#define CONFIG_METRICS_MAX_DEVICES 16
+#endif
+
+namespace Metrics {
+    constexpr size_t MAX_PINS = GPIO_NUM_MAX;                   ///< GPIOs tracked, indexed by pin number
+    constexpr size_t MAX_DEVICES = CONFIG_METRICS_MAX_DEVICES;  ///< I2C devices tracked, in order of first transaction
+    constexpr size_t LATENCY_BUCKETS = 8;                       ///< Transaction latency histogram buckets
+    constexpr uint32_t FIRST_BUCKET_US = 64;                    ///< Upper bound of the first bucket, each next one doubles
+    constexpr uint32_t BINARY_MAGIC = 0x4D545243;               ///< "MTRC", first word of a binary export
+    constexpr uint8_t BINARY_VERSION = 1;                       ///< Layout version of a binary export
+
+    /**
+     * @brief Aggregated counters of one GPIO
+     * 
+     * Counters are 32 bits wide and wrap. Consumers should ship raw values and
+     * take modular differences between snapshots.
+     */
+    struct PinMetrics {
+        uint32_t edges{};               ///< Interrupts handled
+        uint32_t drops{};               ///< Edges whose queue or event loop was full
+        uint32_t isr_cycles_total{};    ///< CPU cycles spent in the ISR
+        uint32_t isr_cycles_max{};      ///< Longest single ISR invocation in cycles
+    };
+
+    /**
+     * @brief Aggregated counters of one I2C device
+     */
+    struct DeviceMetrics {
+        uint8_t port{};                                 ///< I2C port the device is on
+        uint8_t dev_addr{};                             ///< 7-bit device address
+        uint32_t transactions{};                        ///< Transactions issued
+        uint32_t errors{};                              ///< Transactions that failed
+        uint32_t latency_total_us{};                    ///< Sum of transaction latencies
+        uint32_t latency_max_us{};                      ///< Slowest transaction
+        uint32_t latency_histogram[LATENCY_BUCKETS]{};  ///< Bucket i counts latencies below FIRST_BUCKET_US << i, the last one the rest
+    };
+
+    /**
+     * @brief Consistent copy of every counter, summed over both cores
+     */
+    struct MetricsSnapshot {
+        int64_t timestamp_us{};                 ///< esp_timer time of the snapshot
+        PinMetrics pins[MAX_PINS]{};            ///< Indexed by GPIO number
+        DeviceMetrics devices[MAX_DEVICES]{};   ///< Devices seen so far
+        size_t device_count{};                  ///< Used entries of devices
+    };
+
+#ifdef CONFIG_METRICS_ENABLE
+    /**
+     * @brief Count a handled GPIO interrupt, callable from an ISR
+     * 
+     * @param pin GPIO that interrupted
+     * @param isr_cycles CPU cycles the ISR took
+     */
+    void IRAM_ATTR RecordEdge(gpio_num_t pin, uint32_t isr_cycles);
+
+    /**
+     * @brief Count an edge that could not be delivered, callable from an ISR or a task
+     * 
+     * @param pin GPIO that interrupted
+     */
+    void IRAM_ATTR RecordDrop(gpio_num_t pin);
+
+    /**
+     * @brief Count a completed I2C transaction
+     * 
+     * @param port I2C port
+     * @param dev_addr 7-bit device address
+     * @param status Result of the transaction
+     * @param latency_us Time from queueing for the bus to completion
+     */
+    void RecordTransaction(i2c_port_t port, uint8_t dev_addr, esp_err_t status, uint32_t latency_us);
+#else
+    inline void RecordEdge(gpio_num_t, uint32_t){}
+    inline void RecordDrop(gpio_num_t){}
+    inline void RecordTransaction(i2c_port_t, uint8_t, esp_err_t, uint32_t){}
+#endif
+
+    /**
+     * @brief Sum the per-core counters into a snapshot
+     * 
+     * Increments are never blocked. A snapshot taken while counters change
+     * may be a few events behind on individual counters.
+     * 
+     * @param snapshot Filled with the current totals
+     */
+    void TakeSnapshot(MetricsSnapshot &snapshot);
+
+    /**
+     * @brief Clear every counter and forget the known devices
+     * 
+     * Must not race with transactions, intended for tests and start-up.
+     */
+    void Reset(void);
+
+    /**
+     * @brief Encode a snapshot into a compact little-endian byte stream
+     * 
+     * Header: magic (4), version (1), pin count (1), device count (1),
+     * reserved (1), timestamp (8). Then per pin with edges: pin (1) and the
+     * four PinMetrics counters (4 each). Then per device: port (1), address (1)
+     * and the DeviceMetrics counters (4 each) including the histogram.
+     * 
+     * @param snapshot Snapshot to encode
+     * @param buffer Destination
+     * @param size Size of buffer
+     * @param written Set to the number of bytes written
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the buffer is too small
+     */
+    esp_err_t ExportBinary(const MetricsSnapshot &snapshot, uint8_t *buffer, size_t size, size_t &written);
+
+    /**
+     * @brief Format a snapshot as text, one "name{labels} value" line per counter
+     * 
+     * Pins without edges are skipped.
+     * 
+     * @param snapshot Snapshot to format
+     * @param buffer Destination, always NUL-terminated if size > 0
+     * @param size Size of buffer
+     * @param written Set to the length of the text
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the text was truncated
+     */
+    esp_err_t ExportText(const MetricsSnapshot &snapshot, char *buffer, size_t size, size_t &written);
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <cstdint>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+
+#ifndef CONFIG_TIMEBASE_CALIBRATION_MS
+#define CONFIG_TIMEBASE_CALIBRATION_MS 100
+#endif
+
+namespace Timebase {
+    /**
+     * @brief Calibration of one core's cycle counter against esp_timer
+     */
+    struct CoreCalibration {
+        uint32_t cycle_base{};      ///< Cycle count paired with us_base
+        int64_t us_base{};          ///< esp_timer time at cycle_base
+        uint32_t ticks_per_us{};    ///< CPU frequency in MHz at calibration, 0 while uncalibrated
+        uint32_t window_cycles{};   ///< Cycles the esp_timer read took, the pairing uncertainty
+    };
+
+    /**
+     * @brief Calibrate every core and keep recalibrating every CONFIG_TIMEBASE_CALIBRATION_MS
+     * 
+     * Further calls while running do nothing.
+     * 
+     * @return esp_err_t ESP_OK on success, error code if the calibration timer could not be started
+     */
+    esp_err_t Start(void);
+
+    /**
+     * @brief Stop recalibrating, Now() falls back to esp_timer_get_time()
+     */
+    void Stop(void);
+
+    /**
+     * @brief Current time on the esp_timer timeline, callable from an ISR on either core
+     * 
+     * Reads the local cycle counter and converts it with the core's
+     * calibration. Falls back to esp_timer_get_time() while the core is
+     * uncalibrated or its CPU frequency changed since the calibration. With
+     * CONFIG_PM_ENABLE cores stay uncalibrated while esp_pm is configured
+     * for DFS or automatic light sleep, which can switch the frequency away
+     * and back between two calibrations. A fixed-frequency configuration,
+     * the default, keeps the cycle counter. A reconfiguration is picked up
+     * by the next calibration, Stop() and Start() apply it at once.
+     * 
+     * @return int64_t Microseconds since boot
+     */
+    int64_t IRAM_ATTR Now(void);
+
+    /**
+     * @brief Check whether every core has a calibration for its current frequency
+     * 
+     * @return true if Now() converts cycles on both cores
+     */
+    bool IsCalibrated(void);
+
+    /**
+     * @brief Bound on the error between timestamps taken on different cores
+     * 
+     * Sums the pairing uncertainty of both cores' latest calibrations and
+     * one microsecond of rounding each. Two events whose Now() values are
+     * further apart than this are ordered correctly.
+     * 
+     * @return uint32_t Error bound in microseconds
+     */
+    uint32_t GetErrorBoundUs(void);
+
+    /**
+     * @brief Get the latest calibration of a core
+     * 
+     * @param core Core to read
+     * @return CoreCalibration Calibration, all zero for a bad or uncalibrated core
+     */
+    CoreCalibration GetCalibration(BaseType_t core);
+}
+
+#endif
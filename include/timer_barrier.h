@@ -0,0 +1,23 @@
+#ifndef TIMER_BARRIER_H
+#define TIMER_BARRIER_H
+
+#include "esp_err.h"
+
+namespace TimerBarrier {
+    /**
+     * @brief Wait until every esp_timer callback dispatched so far has returned
+     * 
+     * esp_timer_stop() and esp_timer_delete() do not wait for a callback that
+     * the esp_timer task already started, or fetched and is about to call. A
+     * one-shot timer queued behind it runs on the same task, so once it has
+     * fired the earlier callback is finished and its object may be freed.
+     * 
+     * Only covers timers dispatched from the esp_timer task. Must not be
+     * called from an esp_timer callback, which would wait for itself.
+     * 
+     * @return esp_err_t ESP_OK once the barrier fired, error code if its timer could not be started
+     */
+    esp_err_t Wait(void);
+}
+
+#endif
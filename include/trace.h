@@ -0,0 +1,278 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "i2c.h"
+
+namespace Trace {
+    constexpr uint32_t STREAM_MAGIC = 0x45435254;   ///< "TRCE", first word of a recorded stream
+    constexpr uint8_t STREAM_VERSION = 1;           ///< Layout version of a recorded stream
+    constexpr size_t HEADER_SIZE = 16;              ///< Magic (4), version (1), reserved (3), start time (8)
+
+    /**
+     * @brief Kinds of recorded events
+     */
+    enum class EventType : uint8_t {
+        EDGE = 1,           ///< GPIO interrupt
+        TRANSACTION = 2     ///< Completed I2C transaction
+    };
+
+    /**
+     * @brief One decoded event of a recorded stream
+     * 
+     * Only the fields of the event's type are set. Data spans point into the
+     * stream and stay valid as long as it does.
+     */
+    struct Event {
+        EventType type{};                   ///< Kind of event
+        int64_t timestamp_us{};             ///< Time since the recording started
+        gpio_num_t pin{GPIO_NUM_NC};        ///< EDGE: GPIO that interrupted
+        uint8_t level{};                    ///< EDGE: level of the pin in the ISR
+        i2c_port_t port{};                  ///< TRANSACTION: I2C port
+        uint8_t dev_addr{};                 ///< TRANSACTION: 7-bit device address
+        esp_err_t status{ESP_OK};           ///< TRANSACTION: result
+        uint32_t duration_us{};             ///< TRANSACTION: time on the bus including queueing
+        std::span<const uint8_t> tx{};      ///< TRANSACTION: bytes written after the address
+        std::span<const uint8_t> rx{};      ///< TRANSACTION: bytes read
+    };
+
+    /**
+     * @brief Called by Replayer::Run() for every event, a non-ESP_OK result stops the replay
+     */
+    typedef esp_err_t (*EventHandler)(const Event &event, void *context);
+
+    /**
+     * @brief Timing of a paced replay
+     */
+    struct ReplayStats {
+        uint32_t events{};              ///< Events delivered
+        int64_t elapsed_us{};           ///< Wall time of the replay
+        int64_t max_lateness_us{};      ///< Largest delay of a delivery past its scheduled time
+    };
+
+    /**
+     * @brief Captures GPIO edges and I2C transactions into a compact binary stream
+     * 
+     * One recorder is active at a time. Events are encoded as a type byte,
+     * the zigzag varint time difference to the previous event and the event
+     * fields, with lengths and counters as varints. When the buffer is full
+     * further events are counted as dropped, the stream stays decodable.
+     * 
+     * The buffer is written from the GPIO ISR and must be in internal RAM.
+     */
+    class Recorder {
+        private:
+            uint8_t *_buffer;
+            size_t _size;
+            size_t _length{0};
+            int64_t _last_us{0};
+            uint32_t _dropped{0};
+            portMUX_TYPE _mutex = portMUX_INITIALIZER_UNLOCKED;
+
+            bool IRAM_ATTR _reserve(EventType type, size_t length, int64_t now_us, uint8_t *&out);
+
+        public:
+            /**
+             * @brief Construct a recorder writing into a buffer
+             * 
+             * @param buffer Destination of the stream, in internal RAM
+             * @param size Size of buffer, at least HEADER_SIZE
+             */
+            Recorder(uint8_t *buffer, size_t size);
+
+            /**
+             * @brief Stops recording if this recorder is active
+             */
+            ~Recorder();
+
+            /**
+             * @brief Start a new stream and make this the active recorder
+             * 
+             * Starts the Timebase so that edges and transactions recorded on
+             * either core share one timeline.
+             * 
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if another recorder is active,
+             *         ESP_ERR_INVALID_SIZE if the buffer cannot hold the header, error code if the Timebase
+             *         could not be started
+             */
+            esp_err_t Start(void);
+
+            /**
+             * @brief Stop recording, the stream is kept
+             * 
+             * Returns once no hook can still append to this recorder, so the
+             * stream may be read or the buffer freed right after. Must not be
+             * called from an ISR.
+             * 
+             * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if this recorder is not active
+             */
+            esp_err_t Stop(void);
+
+            /**
+             * @brief Append a GPIO edge, callable from an ISR
+             * 
+             * @param pin GPIO that interrupted
+             * @param level Level of the pin
+             */
+            void IRAM_ATTR AddEdge(gpio_num_t pin, int level);
+
+            /**
+             * @brief Append a completed I2C transaction
+             * 
+             * @param port I2C port
+             * @param dev_addr 7-bit device address
+             * @param status Result of the transaction
+             * @param start_us esp_timer time the transaction was issued
+             * @param duration_us Time until it completed
+             * @param tx Segments written
+             * @param rx Segments read
+             */
+            void AddTransaction(i2c_port_t port, uint8_t dev_addr, esp_err_t status, int64_t start_us, uint32_t duration_us,
+                                std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx);
+
+            /**
+             * @brief Get the recorded stream
+             * 
+             * @return const uint8_t* Start of the stream
+             */
+            const uint8_t *GetData(void) const;
+
+            /**
+             * @brief Get the length of the recorded stream
+             * 
+             * @return size_t Bytes recorded, including the header
+             */
+            size_t GetSize(void) const;
+
+            /**
+             * @brief Get the number of events that did not fit
+             * 
+             * @return uint32_t Dropped events since Start()
+             */
+            uint32_t GetDropped(void) const;
+    };
+
+#ifdef CONFIG_TRACE_ENABLE
+    /**
+     * @brief Record a GPIO edge with the active recorder, callable from an ISR
+     * 
+     * @param pin GPIO that interrupted
+     * @param level Raw level the ISR read from the input register
+     */
+    void IRAM_ATTR RecordEdge(gpio_num_t pin, uint32_t level);
+
+    /**
+     * @brief Record an I2C transaction with the active recorder
+     * 
+     * @param port I2C port
+     * @param dev_addr 7-bit device address
+     * @param status Result of the transaction
+     * @param start_us esp_timer time the transaction was issued
+     * @param duration_us Time until it completed
+     * @param tx Segments written
+     * @param rx Segments read
+     */
+    void RecordTransaction(i2c_port_t port, uint8_t dev_addr, esp_err_t status, int64_t start_us, uint32_t duration_us,
+                           std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx);
+#else
+    inline void RecordEdge(gpio_num_t, uint32_t){}
+    inline void RecordTransaction(i2c_port_t, uint8_t, esp_err_t, int64_t, uint32_t,
+                                  std::span<const std::span<const uint8_t>>, std::span<const std::span<uint8_t>>){}
+#endif
+
+    /**
+     * @brief Decodes a recorded stream and plays it back
+     * 
+     * The decoder only depends on the stream, so recordings pulled from the
+     * field can be inspected off the device as well. Playback drives the
+     * real peripherals of a bench device through ReplayEdge() and
+     * ReplayTransaction(), there are no simulated GPIO or I2C backends.
+     */
+    class Replayer {
+        private:
+            const uint8_t *_data;
+            size_t _size;
+            size_t _position{HEADER_SIZE};
+            int64_t _timestamp_us{0};
+
+        public:
+            /**
+             * @brief Construct a replayer over a recorded stream
+             * 
+             * @param data Stream as produced by a Recorder
+             * @param size Length of the stream
+             */
+            Replayer(const uint8_t *data, size_t size);
+
+            /**
+             * @brief Check the stream header
+             * 
+             * @return esp_err_t ESP_OK if the stream is valid, ESP_ERR_INVALID_VERSION for an unknown version,
+             *         ESP_ERR_INVALID_RESPONSE otherwise
+             */
+            esp_err_t Validate(void) const;
+
+            /**
+             * @brief Decode the next event
+             * 
+             * @param event Filled with the event
+             * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND at the end of the stream,
+             *         ESP_ERR_INVALID_RESPONSE if the stream is corrupt
+             */
+            esp_err_t Next(Event &event);
+
+            /**
+             * @brief Go back to the first event
+             */
+            void Rewind(void);
+
+            /**
+             * @brief Deliver every remaining event at its recorded time
+             * 
+             * @param handler Called for every event
+             * @param context Passed to the handler
+             * @param speedup Time compression, 1 for real time, 0 to deliver without pacing
+             * @param stats Optional, filled with the timing of the replay
+             * @return esp_err_t ESP_OK once the stream is exhausted, the decoding or handler error otherwise
+             */
+            esp_err_t Run(EventHandler handler, void *context, uint32_t speedup, ReplayStats *stats = nullptr);
+    };
+
+    /**
+     * @brief Drive a recorded edge onto a pin
+     * 
+     * Used from a Replayer::Run() handler with a pin wired back to the
+     * input under test, the recorded signal then goes through the real
+     * GpioInput interrupt path at its recorded pace.
+     * 
+     * @param event EDGE event
+     * @param pin Output to drive, a loopback of the input under test
+     * @return esp_err_t Result of gpio_set_level(), ESP_ERR_INVALID_ARG for other events
+     */
+    esp_err_t ReplayEdge(const Event &event, gpio_num_t pin);
+
+    /**
+     * @brief Issue a recorded transaction again on a bus
+     * 
+     * The same bytes are written and the same number of bytes is read,
+     * so recorded field traffic can drive bench regression tests.
+     * 
+     * @param i2c Bus to issue the transaction on
+     * @param event TRANSACTION event
+     * @param rx_buffer Receives the bytes read
+     * @param rx_size Size of rx_buffer
+     * @return esp_err_t Result of the transaction, ESP_ERR_INVALID_ARG for other events,
+     *         ESP_ERR_INVALID_SIZE if rx_buffer is too small
+     */
+    esp_err_t ReplayTransaction(I2C::I2c &i2c, const Event &event, uint8_t *rx_buffer, size_t rx_size);
+}
+
+#endif
@@ -1,4 +1,12 @@
 #include "gpio.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
+#include "metrics.h"
+#include "trace.h"
+#include "timebase.h"
+#include "timer_barrier.h"
 
 namespace GPIO {
     /*================================= GpioInput ==============================*/
@@ -13,6 +21,33 @@ namespace GPIO {
      */
     portMUX_TYPE GpioInput::_eventChangeMutex = portMUX_INITIALIZER_UNLOCKED;
 
+    /**
+     * @brief Mutex for the over-budget log, shared by the ISR and readers on either core.
+     */
+    portMUX_TYPE GpioInput::_budgetLogMutex = portMUX_INITIALIZER_UNLOCKED;
+
+#ifdef CONFIG_GPIO_ISR_BUDGET
+    /**
+     * @brief Ring of over-budget interrupts, oldest entry at budget_log_head.
+     */
+    static DRAM_ATTR IsrBudgetRecord budget_log[CONFIG_GPIO_ISR_BUDGET_LOG_SIZE];
+    static DRAM_ATTR size_t budget_log_head{0};
+    static DRAM_ATTR size_t budget_log_count{0};
+#endif
+
+    /**
+     * @brief Reads the raw level of a pin from the input registers.
+     * 
+     * Cheaper than gpio_get_level() in the ISR. The registers are read by
+     * address, the GPIO struct name is taken by this namespace.
+     * 
+     * @param pin GPIO to read
+     * @return uint32_t Raw level, 0 or 1
+     */
+    static inline uint32_t IRAM_ATTR read_level(int32_t pin){
+        return pin < 32 ? (REG_READ(GPIO_IN_REG) >> pin) & 1 : (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+    }
+
     /**
      * @brief Define the event base for GPIO input events.
      */
@@ -22,12 +57,18 @@ namespace GPIO {
      * @brief ISR callback for GPIO interrupts.
      * 
      * This function is called from interrupt context when a GPIO event occurs.
-     * It performs type checking and routes the event to the appropriate handler:
-     * queue, custom event loop, or default event handler.
+     * It performs type checking, updates the pin-state bitmap if tracking and
+     * the last-edge time if monitored for liveness, and routes the event to
+     * the appropriate handler:
+     * coalescing counter, delivery lane, batch, queue, custom event loop, or
+     * default event handler.
      * 
      * @param args Pointer to interrupt_args structure
      */
     void IRAM_ATTR GpioInput::gpio_isr_callback(void *args){
+#if defined(CONFIG_METRICS_ENABLE) || defined(CONFIG_GPIO_ISR_BUDGET)
+        const uint32_t start_cycles = esp_cpu_get_cycle_count();
+#endif
         auto* typed_args = reinterpret_cast<interrupt_args*>(args);
         if (typed_args->type_tag != 0x47504941) {
             return;
@@ -36,17 +77,90 @@ namespace GPIO {
         bool custom_event_handler_set = typed_args->_custom_event_handler_set;
         bool event_handler_set = typed_args->_event_handler_set;
         bool queue_enabled = typed_args->_queue_enabled;
+        bool lane_enabled = typed_args->_lane_enabled;
         esp_event_loop_handle_t custom_event_loop_handle = typed_args->_custom_event_loop_handle;
         QueueHandle_t queue_handle = typed_args->_queue_handle;
+        GpioBatch *batch = typed_args->_batch;
+#ifdef CONFIG_TRACE_ENABLE
+        Trace::RecordEdge(static_cast<gpio_num_t>(pin), read_level(pin));
+#endif
+        if (typed_args->_state_tracking){
+            GpioState::post(static_cast<gpio_num_t>(pin), read_level(pin));
+        }
+        if (typed_args->_liveness){
+            GpioLiveness::post(static_cast<gpio_num_t>(pin));
+        }
 
-        if(queue_enabled){
-            xQueueSendFromISR(queue_handle, &pin, NULL);
+        bool delivered{true};
+        BaseType_t woken{pdFALSE};
+        if (typed_args->_coalescing){
+            // Counted only, the coalescing timer delivers once per window
+            const uint32_t level = read_level(pin);
+            const int64_t now_us = Timebase::Now();
+            taskENTER_CRITICAL_ISR(&typed_args->_coalesce_mutex);
+            typed_args->_edge_count++;
+            typed_args->_last_level = level;
+            typed_args->_last_edge_us = now_us;
+            taskEXIT_CRITICAL_ISR(&typed_args->_coalesce_mutex);
+        } else if (lane_enabled){
+            delivered = GpioLanes::post(static_cast<gpio_num_t>(pin), &woken);
+        } else if (batch != nullptr){
+            delivered = batch->post(static_cast<gpio_num_t>(pin), read_level(pin), &woken);
+        } else if(queue_enabled){
+            delivered = xQueueSendFromISR(queue_handle, &pin, &woken) == pdTRUE;
         } else if (custom_event_handler_set){
-            esp_event_isr_post_to(custom_event_loop_handle, INPUT_EVENTS, pin, nullptr, 0, nullptr);
+            delivered = esp_event_isr_post_to(custom_event_loop_handle, INPUT_EVENTS, pin, nullptr, 0, nullptr) == ESP_OK;
         } else if (event_handler_set){
-            esp_event_isr_post(INPUT_EVENTS, pin, nullptr, 0, nullptr);
+            delivered = esp_event_isr_post(INPUT_EVENTS, pin, nullptr, 0, nullptr) == ESP_OK;
+        }
+
+        if (!delivered){
+            Metrics::RecordDrop(static_cast<gpio_num_t>(pin));
+        }
+
+#if defined(CONFIG_METRICS_ENABLE) || defined(CONFIG_GPIO_ISR_BUDGET)
+        const uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+        Metrics::RecordEdge(static_cast<gpio_num_t>(pin), cycles);
+#ifdef CONFIG_GPIO_ISR_BUDGET
+        _checkIsrBudget(typed_args, cycles);
+#endif
+#endif
+
+        if (woken == pdTRUE){
+            portYIELD_FROM_ISR();
+        }
+    }
+
+#ifdef CONFIG_GPIO_ISR_BUDGET
+    /**
+     * @brief Updates the worst case of a pin and logs an over-budget invocation.
+     * 
+     * The handler of a pin only runs on the one core its interrupt is
+     * routed to, so the per-pin counters have a single writer. The log is shared
+     * with readers and only locked when the budget was exceeded.
+     * 
+     * @param args Interrupt arguments of the pin
+     * @param cycles CPU cycles the handler took
+     */
+    void IRAM_ATTR GpioInput::_checkIsrBudget(interrupt_args *args, uint32_t cycles){
+        if (cycles > args->_worst_cycles){
+            args->_worst_cycles = cycles;
+        }
+        if (args->_budget_cycles == 0 || cycles <= args->_budget_cycles){
+            return;
+        }
+        args->_over_budget++;
+
+        taskENTER_CRITICAL_ISR(&_budgetLogMutex);
+        budget_log[(budget_log_head + budget_log_count) % CONFIG_GPIO_ISR_BUDGET_LOG_SIZE] = {args->_pin, cycles, Timebase::Now()};
+        if (budget_log_count < CONFIG_GPIO_ISR_BUDGET_LOG_SIZE){
+            budget_log_count++;
+        } else {
+            budget_log_head = (budget_log_head + 1) % CONFIG_GPIO_ISR_BUDGET_LOG_SIZE;
         }
+        taskEXIT_CRITICAL_ISR(&_budgetLogMutex);
     }
+#endif
 
     /**
      * @brief Initializes the GPIO input pin with specified configuration.
@@ -61,6 +175,7 @@ namespace GPIO {
         esp_err_t status{ESP_OK};
         _active_low = activeLow;
         _pin = pin;
+        _interrupt_args._pin = pin;
         
         gpio_config_t cfg;
         cfg.pin_bit_mask = 1ULL <<pin;
@@ -100,6 +215,33 @@ namespace GPIO {
     GpioInput::GpioInput(void){
     }
 
+    /**
+     * @brief Destructor for GpioInput.
+     * 
+     * Stops the coalescing timer so it no longer references this object,
+     * takes the pin off the liveness monitor and releases and deletes the
+     * PM locks.
+     */
+    GpioInput::~GpioInput(){
+        disableCoalescing();
+        disableLivenessMonitor();
+#ifdef CONFIG_PM_ENABLE
+        if (_power_lock_held){
+            esp_pm_lock_release(_cpu_lock);
+            esp_pm_lock_release(_sleep_lock);
+            _power_lock_held = false;
+        }
+        if (_cpu_lock != nullptr){
+            esp_pm_lock_delete(_cpu_lock);
+            _cpu_lock = nullptr;
+        }
+        if (_sleep_lock != nullptr){
+            esp_pm_lock_delete(_sleep_lock);
+            _sleep_lock = nullptr;
+        }
+#endif
+    }
+
     /**
      * @brief Initializes the GPIO input pin with specified configuration.
      * 
@@ -222,23 +364,234 @@ namespace GPIO {
             }
         }
 
-        if (!_interrupt_service_installed) {
-            status = gpio_install_isr_service(0);
+        status = installInterruptService();
+
+        if (status == ESP_OK){
+            status = gpio_set_intr_type(_pin, int_type);
+        }
+
+        if (status == ESP_OK && _interrupt_core != tskNO_AFFINITY && _interrupt_core != GpioCores::getServiceCore()){
+            status = GpioCores::attach(_pin, _interrupt_core, gpio_isr_callback, &_interrupt_args);
+            _core_routed = status == ESP_OK;
+        }
+
+        if (status == ESP_OK && !_core_routed){
+            status = gpio_isr_handler_add(_pin, gpio_isr_callback, &_interrupt_args);
+        }
+
+        if (status == ESP_OK){
+            _interrupt_enabled = true;
+            status = _updatePowerLock();
+        }
+
+        return status;
+    }
+
+    /**
+     * @brief Installs the shared GPIO interrupt service once
+     * 
+     * Per-pin handlers of every GPIO class hang off this service, so it is
+     * installed by whichever of them enables an interrupt first.
+     * 
+     * @return esp_err_t Status of the operation (ESP_OK on success)
+     */
+    esp_err_t GpioInput::installInterruptService(void){
+        esp_err_t status{ESP_OK};
 
+        if (!_interrupt_service_installed) {
+            // Recorded as the service's core, so GpioCores never allocates a dispatcher there
+            status = GpioCores::installService(xPortGetCoreID());
             if(status == ESP_OK){
                 _interrupt_service_installed = true;
             }
         }
 
+        // Edge timestamps come from the cycle-counter timebase from here on
         if (status == ESP_OK){
-            status = gpio_set_intr_type(_pin, int_type);
+            status = Timebase::Start();
+        }
+
+        return status;
+    }
+
+    /**
+     * @brief Gets the core the shared GPIO interrupt service runs on
+     * 
+     * @return BaseType_t Core of the service, tskNO_AFFINITY if not installed by this library
+     */
+    BaseType_t GpioInput::getInterruptServiceCore(void){
+        return GpioCores::getServiceCore();
+    }
+
+    /**
+     * @brief Selects the core this pin interrupts
+     * 
+     * @param core Core to interrupt, tskNO_AFFINITY for the service core
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad core,
+     *         ESP_ERR_INVALID_STATE while interrupts are enabled
+     */
+    esp_err_t GpioInput::setInterruptCore(BaseType_t core){
+        if (core != tskNO_AFFINITY && (core < 0 || core >= portNUM_PROCESSORS)){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (_interrupt_enabled){
+            return ESP_ERR_INVALID_STATE;
         }
 
+        _interrupt_core = core;
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Disables interrupt functionality for the GPIO input pin
+     * 
+     * Removes the pin's handler from the interrupt service so the ISR no longer
+     * references this object. Must be called before the object is destroyed
+     * if interrupts were enabled.
+     * 
+     * @return esp_err_t Status of the operation (ESP_OK on success)
+     */
+    esp_err_t GpioInput::disableInterrupt(void){
+        esp_err_t status = gpio_set_intr_type(_pin, GPIO_INTR_DISABLE);
+
+        if (status == ESP_OK && _core_routed){
+            status = GpioCores::detach(_pin);
+            _core_routed = false;
+        } else if (status == ESP_OK && _interrupt_service_installed){
+            status = gpio_isr_handler_remove(_pin);
+        }
+
+        _interrupt_enabled = false;
+        _updatePowerLock();
+
+        return status;
+    }
+
+    /**
+     * @brief Holds CPU frequency and no-light-sleep locks while interrupts are enabled
+     * 
+     * With dynamic frequency scaling the ISR would otherwise run at whatever
+     * frequency the governor picked, and edges arriving in light sleep would
+     * be delayed by the wake-up. The locks are created on first use.
+     * 
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_SUPPORTED without CONFIG_PM_ENABLE
+     */
+    esp_err_t GpioInput::enablePowerLock(void){
+#ifdef CONFIG_PM_ENABLE
+        esp_err_t status{ESP_OK};
+
+        if (_cpu_lock == nullptr){
+            status = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "gpio_cpu", &_cpu_lock);
+        }
+        if (status == ESP_OK && _sleep_lock == nullptr){
+            status = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "gpio_sleep", &_sleep_lock);
+        }
         if (status == ESP_OK){
-            status = gpio_isr_handler_add(_pin, gpio_isr_callback, (void *)_pin);
+            _power_lock_enabled = true;
+            status = _updatePowerLock();
         }
 
         return status;
+#else
+        return ESP_ERR_NOT_SUPPORTED;
+#endif
+    }
+
+    /**
+     * @brief Stops holding power management locks for this pin
+     * 
+     * @return esp_err_t Status of the operation (ESP_OK on success)
+     */
+    esp_err_t GpioInput::disablePowerLock(void){
+        _power_lock_enabled = false;
+        return _updatePowerLock();
+    }
+
+    /**
+     * @brief Acquires or releases the PM locks to match the pin state
+     * 
+     * The locks are held only while both the power lock and interrupts are enabled.
+     * 
+     * @return esp_err_t Status of the operation (ESP_OK on success)
+     */
+    esp_err_t GpioInput::_updatePowerLock(void){
+        esp_err_t status{ESP_OK};
+#ifdef CONFIG_PM_ENABLE
+        const bool wanted = _power_lock_enabled && _interrupt_enabled;
+
+        if (wanted && !_power_lock_held){
+            status |= esp_pm_lock_acquire(_cpu_lock);
+            status |= esp_pm_lock_acquire(_sleep_lock);
+            _power_lock_held = true;
+        } else if (!wanted && _power_lock_held){
+            status |= esp_pm_lock_release(_cpu_lock);
+            status |= esp_pm_lock_release(_sleep_lock);
+            _power_lock_held = false;
+        }
+#endif
+        return status;
+    }
+
+    /**
+     * @brief Sets the cycle budget of this pin's interrupt handler
+     * 
+     * @param cycles Budget in CPU cycles, 0 to only track the worst case
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_SUPPORTED without CONFIG_GPIO_ISR_BUDGET
+     */
+    esp_err_t GpioInput::setIsrBudget(uint32_t cycles){
+#ifdef CONFIG_GPIO_ISR_BUDGET
+        _interrupt_args._budget_cycles = cycles;
+        return ESP_OK;
+#else
+        return ESP_ERR_NOT_SUPPORTED;
+#endif
+    }
+
+    /**
+     * @brief Gets the longest interrupt handler invocation of this pin
+     * 
+     * @return uint32_t Worst case in CPU cycles since the last reset
+     */
+    uint32_t GpioInput::getIsrWorstCycles(void) const{
+        return _interrupt_args._worst_cycles;
+    }
+
+    /**
+     * @brief Gets how often this pin's interrupt handler exceeded its budget
+     * 
+     * @return uint32_t Over-budget invocations since the last reset
+     */
+    uint32_t GpioInput::getIsrOverBudgetCount(void) const{
+        return _interrupt_args._over_budget;
+    }
+
+    /**
+     * @brief Clears the worst case and over-budget count of this pin
+     */
+    void GpioInput::resetIsrBudgetStats(void){
+        _interrupt_args._worst_cycles = 0;
+        _interrupt_args._over_budget = 0;
+    }
+
+    /**
+     * @brief Takes the oldest entry from the over-budget log of all pins
+     * 
+     * @param record Filled with the entry
+     * @return bool True if an entry was returned, false if the log is empty
+     */
+    bool GpioInput::readIsrBudgetLog(IsrBudgetRecord &record){
+        bool found{false};
+#ifdef CONFIG_GPIO_ISR_BUDGET
+        taskENTER_CRITICAL(&_budgetLogMutex);
+        if (budget_log_count > 0){
+            record = budget_log[budget_log_head];
+            budget_log_head = (budget_log_head + 1) % CONFIG_GPIO_ISR_BUDGET_LOG_SIZE;
+            budget_log_count--;
+            found = true;
+        }
+        taskEXIT_CRITICAL(&_budgetLogMutex);
+#endif
+        return found;
     }
 
     /**
@@ -316,10 +669,149 @@ namespace GPIO {
         taskEXIT_CRITICAL(&_eventChangeMutex);
     }
 
+    /**
+     * @brief Delivers at most one event per window, carrying the number of edges
+     * 
+     * The ISR only increments the pin's edge counter, which is never reset.
+     * The timer callback delivers the difference to what it delivered last.
+     * Both hold the pin's coalescing spinlock for the few loads and stores,
+     * so the 64-bit edge time is never read half-written.
+     * 
+     * @param window_us Window length in microseconds
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a zero window,
+     *         ESP_ERR_NOT_SUPPORTED for pins delivered through a lane or batch
+     */
+    esp_err_t GpioInput::enableCoalescing(uint32_t window_us){
+        if (window_us == 0){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (_interrupt_args._lane_enabled || _interrupt_args._batch != nullptr){
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        esp_err_t status = disableCoalescing();
+        if (status == ESP_OK){
+            esp_timer_create_args_t args{};
+            args.callback = _coalesceCallback;
+            args.arg = this;
+            args.name = "gpio_coalesce";
+            args.skip_unhandled_events = true;
+            status = esp_timer_create(&args, &_coalesce_timer);
+        }
+        if (status == ESP_OK){
+            _coalesced_edges = _interrupt_args._edge_count;
+            _interrupt_args._coalescing = true;
+            status = esp_timer_start_periodic(_coalesce_timer, window_us);
+        }
+        if (status != ESP_OK){
+            disableCoalescing();
+        }
+
+        return status;
+    }
+
+    /**
+     * @brief Delivers every edge again
+     * 
+     * A callback that esp_timer already dispatched may still be delivering,
+     * or about to start, after the timer is stopped. The timer is deleted
+     * only after a TimerBarrier, so no callback uses this object once this
+     * returns. Must not be called from the delivery path of this pin or any
+     * other esp_timer callback.
+     * 
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t GpioInput::disableCoalescing(void){
+        esp_err_t status{ESP_OK};
+        taskENTER_CRITICAL(&_interrupt_args._coalesce_mutex);
+        _interrupt_args._coalescing = false;
+        taskEXIT_CRITICAL(&_interrupt_args._coalesce_mutex);
+
+        if (_coalesce_timer != nullptr){
+            esp_timer_stop(_coalesce_timer);
+            status = TimerBarrier::Wait();
+            const esp_err_t deleted = esp_timer_delete(_coalesce_timer);
+            if (status == ESP_OK){
+                status = deleted;
+            }
+            _coalesce_timer = nullptr;
+        }
+
+        return status;
+    }
+
+    /**
+     * @brief Delivers the edges counted during the last window
+     * 
+     * Runs in the esp_timer task. Nothing is delivered for a window without
+     * edges, or once disableCoalescing() has started, which waits for a
+     * dispatched callback to return.
+     * 
+     * @param arg The coalescing GpioInput
+     */
+    void GpioInput::_coalesceCallback(void *arg){
+        auto *input = static_cast<GpioInput *>(arg);
+        interrupt_args &args = input->_interrupt_args;
+
+        taskENTER_CRITICAL(&args._coalesce_mutex);
+        const bool coalescing = args._coalescing;
+        const uint32_t count = args._edge_count;
+        const uint32_t last_level = args._last_level;
+        const int64_t last_edge_us = args._last_edge_us;
+        taskEXIT_CRITICAL(&args._coalesce_mutex);
+        if (!coalescing || count == input->_coalesced_edges){
+            return;
+        }
+
+        const uint32_t edges = count - input->_coalesced_edges;
+        input->_coalesced_edges = count;
+
+        const int level = input->_active_low ? !last_level : last_level;
+        const CoalescedEvent event{args._pin, edges, level, last_edge_us};
+        bool delivered{true};
+        if (args._queue_enabled){
+            delivered = xQueueSend(args._queue_handle, &event, 0) == pdTRUE;
+        } else if (args._custom_event_handler_set){
+            delivered = esp_event_post_to(args._custom_event_loop_handle, INPUT_EVENTS, args._pin, &event, sizeof(event), 0) == ESP_OK;
+        } else if (args._event_handler_set){
+            delivered = esp_event_post(INPUT_EVENTS, args._pin, &event, sizeof(event), 0) == ESP_OK;
+        }
+
+        if (!delivered){
+            Metrics::RecordDrop(args._pin);
+        }
+    }
+
+    /**
+     * @brief Delivers the pin's edges through the delivery lane of a priority class
+     * 
+     * Any previously set handlers are cleared before the pin is routed.
+     * 
+     * @param priority_class Lane to deliver through
+     * @param handler Handler run in the lane's dispatcher task for every edge
+     * @param context Handler argument
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad handler, ESP_ERR_NOT_SUPPORTED while coalescing
+     */
+    esp_err_t GpioInput::setLaneHandler(PriorityClass priority_class, LaneHandler handler, void *context){
+        if (_interrupt_args._coalescing){
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        taskENTER_CRITICAL(&_eventChangeMutex);
+        _clearEventHandlers();
+        taskEXIT_CRITICAL(&_eventChangeMutex);
+
+        esp_err_t status = GpioLanes::route(_pin, priority_class, handler, context);
+        if (status == ESP_OK){
+            _interrupt_args._lane_enabled = true;
+        }
+        return status;
+    }
+
     /**
      * @brief Clears all event handlers and queue settings.
      * 
-     * Unregisters any active event handlers and clears queue settings.
+     * Unregisters any active event handlers and clears queue and lane settings.
      * This ensures that only one type of event handling is active at a time.
      * 
      * @return esp_err_t ESP_OK on success, error code otherwise
@@ -337,10 +829,84 @@ namespace GPIO {
 
         _interrupt_args._queue_handle = nullptr;
         _interrupt_args._queue_enabled = false;
+        _interrupt_args._batch = nullptr;
+
+        if (_interrupt_args._lane_enabled){
+            GpioLanes::unroute(_interrupt_args._pin);
+            _interrupt_args._lane_enabled = false;
+        }
+
+        return status;
+    }
+
+    /**
+     * @brief Stages the pin's edges in a batch for block-wise delivery
+     * 
+     * @param batch Batch started with GpioBatch::start()
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for no batch, ESP_ERR_NOT_SUPPORTED while coalescing
+     */
+    esp_err_t GpioInput::setBatch(GpioBatch *batch){
+        if (batch == nullptr){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (_interrupt_args._coalescing){
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        taskENTER_CRITICAL(&_eventChangeMutex);
+        _clearEventHandlers();
+        _interrupt_args._batch = batch;
+        taskEXIT_CRITICAL(&_eventChangeMutex);
+        return ESP_OK;
+    }
 
+    /**
+     * @brief Tracks the pin's level in the GpioState bitmap
+     * 
+     * @return esp_err_t ESP_OK on success
+     */
+    esp_err_t GpioInput::enableStateTracking(void){
+        _interrupt_args._state_tracking = true;
+        GpioState::post(_pin, gpio_get_level(_pin));
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Stops tracking the pin and clears its bits in the GpioState bitmap
+     */
+    void GpioInput::disableStateTracking(void){
+        _interrupt_args._state_tracking = false;
+        GpioState::clear(_pin);
+    }
+
+    /**
+     * @brief Watches the pin for missing edges with GpioLiveness
+     * 
+     * The pin is registered before the ISR starts feeding it, so its first
+     * edges are never lost to an unwatched pin.
+     * 
+     * @param timeout_us Time without edges after which the signal is lost
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad timeout
+     */
+    esp_err_t GpioInput::enableLivenessMonitor(uint32_t timeout_us){
+        esp_err_t status = GpioLiveness::watch(_pin, timeout_us);
+        if (status == ESP_OK){
+            _interrupt_args._liveness = true;
+        }
         return status;
     }
 
+    /**
+     * @brief Stops watching the pin without posting an event
+     */
+    void GpioInput::disableLivenessMonitor(void){
+        if (!_interrupt_args._liveness){
+            return;
+        }
+        _interrupt_args._liveness = false;
+        GpioLiveness::unwatch(_pin);
+    }
+
 
     /*================================= GpioOutput ==============================*/
 
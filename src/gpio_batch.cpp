@@ -0,0 +1,225 @@
+#include "gpio_batch.h"
+#include "timebase.h"
+#include "timer_barrier.h"
+
+namespace GPIO {
+
+    /**
+     * @brief Default constructor for GpioBatch.
+     */
+    GpioBatch::GpioBatch(void){
+    }
+
+    /**
+     * @brief Stops the deadline timer so it no longer references this object.
+     */
+    GpioBatch::~GpioBatch(){
+        stop();
+    }
+
+    /**
+     * @brief Starts delivering blocks to a queue
+     * 
+     * The deadline timer runs at half the deadline and hands off a partial
+     * block once its first edge is half a deadline old, so no edge waits
+     * longer than the deadline.
+     * 
+     * @param queue Queue created with an item size of sizeof(EdgeBlock *)
+     * @param deadline_us Longest an edge waits in a partial block
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for no queue or a deadline under MIN_DEADLINE_US,
+     *         ESP_ERR_INVALID_STATE if started, error code otherwise
+     */
+    esp_err_t GpioBatch::start(QueueHandle_t queue, uint32_t deadline_us){
+        if (queue == nullptr || deadline_us < MIN_DEADLINE_US){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (_deadline_timer != nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        esp_timer_create_args_t args{};
+        args.callback = _deadlineCallback;
+        args.arg = this;
+        args.name = "gpio_batch";
+        args.skip_unhandled_events = true;
+        esp_err_t status = esp_timer_create(&args, &_deadline_timer);
+        if (status != ESP_OK){
+            _deadline_timer = nullptr;
+            return status;
+        }
+
+        _blocks = 0;
+        _edges = 0;
+        _drops = 0;
+        _flush_age_us = deadline_us / 2;
+        taskENTER_CRITICAL(&_staging_mutex);
+        _queue = queue;
+        taskEXIT_CRITICAL(&_staging_mutex);
+
+        status = esp_timer_start_periodic(_deadline_timer, deadline_us / 2);
+        if (status != ESP_OK){
+            stop();
+        }
+        return status;
+    }
+
+    /**
+     * @brief Stops the deadline timer and hands off the partial block
+     * 
+     * A deadline callback that esp_timer already dispatched may still be
+     * running after the timer is stopped, so the timer is deleted only after
+     * a TimerBarrier and no callback uses this object once this returns.
+     * 
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if not started,
+     *         error code if the barrier could not be started
+     */
+    esp_err_t GpioBatch::stop(void){
+        if (_deadline_timer == nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+        esp_timer_stop(_deadline_timer);
+        const esp_err_t status = TimerBarrier::Wait();
+        esp_timer_delete(_deadline_timer);
+        _deadline_timer = nullptr;
+
+        taskENTER_CRITICAL(&_staging_mutex);
+        EdgeBlock *partial = _staging;
+        QueueHandle_t queue = _queue;
+        _staging = nullptr;
+        _queue = nullptr;
+        taskEXIT_CRITICAL(&_staging_mutex);
+
+        if (partial != nullptr){
+            _handOff(queue, partial, nullptr);
+        }
+        return status;
+    }
+
+    /**
+     * @brief Returns a block received from the queue to the pool
+     * 
+     * @param block Block to return, ignored if it is not from this pool
+     */
+    void GpioBatch::release(EdgeBlock *block){
+        if (block != nullptr && _pool.Owns(block)){
+            _pool.Release(block);
+        }
+    }
+
+    /**
+     * @brief Stages an edge, called from the GPIO ISR
+     * 
+     * A fresh block is only taken from the pool when the first edge after a
+     * hand-off arrives, so idle consumers hold no block.
+     * 
+     * @param pin GPIO that interrupted
+     * @param level Raw level of the pin
+     * @param woken Set to pdTRUE if the consumer should run before the ISR returns
+     * @return bool True if the edge was staged
+     */
+    bool IRAM_ATTR GpioBatch::post(gpio_num_t pin, uint32_t level, BaseType_t *woken){
+        const int64_t now_us = Timebase::Now();
+        EdgeBlock *full{nullptr};
+        QueueHandle_t queue{nullptr};
+
+        taskENTER_CRITICAL_ISR(&_staging_mutex);
+        if (_staging == nullptr && _queue != nullptr){
+            _staging = _pool.Acquire();
+            if (_staging != nullptr){
+                _staging->count = 0;
+            }
+        }
+        EdgeBlock *block = _staging;
+        if (block != nullptr){
+            block->records[block->count++] = {pin, level, now_us};
+            if (block->count == EDGE_BLOCK_RECORDS){
+                full = block;
+                queue = _queue;
+                _staging = nullptr;
+            }
+        }
+        taskEXIT_CRITICAL_ISR(&_staging_mutex);
+
+        if (block == nullptr){
+            _drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (full != nullptr){
+            _handOff(queue, full, woken);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Sends a block to the consumer, or back to the pool if the queue is full
+     * 
+     * @param queue Queue of the consumer
+     * @param block Block to send
+     * @param woken Set by the ISR send, nullptr when called from a task
+     */
+    void IRAM_ATTR GpioBatch::_handOff(QueueHandle_t queue, EdgeBlock *block, BaseType_t *woken){
+        // The consumer may release the block as soon as it is sent
+        const size_t count = block->count;
+        bool sent{false};
+        if (woken != nullptr){
+            sent = xQueueSendFromISR(queue, &block, woken) == pdTRUE;
+        } else {
+            sent = xQueueSend(queue, &block, 0) == pdTRUE;
+        }
+
+        if (sent){
+            _blocks.fetch_add(1, std::memory_order_relaxed);
+            _edges.fetch_add(count, std::memory_order_relaxed);
+        } else {
+            _pool.Release(block);
+            _drops.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Hands off the partial block once it reaches the flush age
+     * 
+     * Runs in the esp_timer task.
+     * 
+     * @param arg The GpioBatch
+     */
+    void GpioBatch::_deadlineCallback(void *arg){
+        auto *batch = static_cast<GpioBatch *>(arg);
+        const int64_t now_us = Timebase::Now();
+        EdgeBlock *stale{nullptr};
+        QueueHandle_t queue{nullptr};
+
+        taskENTER_CRITICAL(&batch->_staging_mutex);
+        EdgeBlock *block = batch->_staging;
+        if (block != nullptr && now_us - block->records[0].timestamp_us >= batch->_flush_age_us){
+            stale = block;
+            queue = batch->_queue;
+            batch->_staging = nullptr;
+        }
+        taskEXIT_CRITICAL(&batch->_staging_mutex);
+
+        if (stale != nullptr){
+            batch->_handOff(queue, stale, nullptr);
+        }
+    }
+
+    /**
+     * @brief Gets the counters
+     * 
+     * @return BatchStats Counters since start()
+     */
+    BatchStats GpioBatch::getStats(void) const{
+        return {_blocks.load(std::memory_order_relaxed), _edges.load(std::memory_order_relaxed),
+                _drops.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * @brief Gets the usage counters of the block pool
+     * 
+     * @return Pool::PoolStats Capacity, blocks in use and high-water mark
+     */
+    Pool::PoolStats GpioBatch::getPoolStats(void) const{
+        return _pool.GetStats();
+    }
+
+}
@@ -0,0 +1,321 @@
+#include "gpio_cores.h"
+#include "sdkconfig.h"
+#include "esp_intr_alloc.h"
+#include "esp_ipc.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
+
+namespace GPIO {
+    namespace {
+        /**
+         * @brief Interrupt enable bits of the GPIO_PINn_INT_ENA field
+         */
+        constexpr uint32_t APP_CPU_INTR_ENA = 1 << 0;
+        constexpr uint32_t PRO_CPU_INTR_ENA = 1 << 2;
+
+        /**
+         * @brief Handler of a routed pin
+         */
+        struct Dispatch {
+            gpio_isr_t handler;
+            void *arg;
+        };
+
+        /**
+         * @brief Dispatcher of one core
+         */
+        struct CoreTable {
+            Dispatch pins[GPIO_NUM_MAX];
+            intr_handle_t handle;
+            uint32_t dispatches;
+        };
+
+        DRAM_ATTR CoreTable tables[portNUM_PROCESSORS];
+
+        /**
+         * @brief Core of each pin plus one, 0 while the pin is not routed
+         */
+        uint8_t pin_cores[GPIO_NUM_MAX];
+
+        /**
+         * @brief Owner of a core's GPIO interrupt
+         */
+        enum class Owner : uint8_t {
+            NONE,
+            SERVICE,
+            DISPATCHER
+        };
+
+        Owner owners[portNUM_PROCESSORS];
+
+        /**
+         * @brief Core of the ESP-IDF service, tskNO_AFFINITY while unknown
+         */
+        BaseType_t service_core = tskNO_AFFINITY;
+
+        /**
+         * @brief The service was installed outside installService(), on a core nobody recorded
+         */
+        bool service_elsewhere = false;
+
+        /**
+         * @brief Guards the tables, the owners and the read-modify-write of the pin registers
+         */
+        portMUX_TYPE cores_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+        /**
+         * @brief Arguments and result of a dispatcher installation on another core
+         */
+        struct InstallRequest {
+            BaseType_t core;
+            esp_err_t status;
+        };
+
+        /**
+         * @brief Address of a pin's configuration register
+         * 
+         * @param pin GPIO of the register
+         * @return uint32_t GPIO_PINn_REG of the pin
+         */
+        inline uint32_t pin_reg(gpio_num_t pin){
+            return GPIO_PIN0_REG + 4 * pin;
+        }
+
+        /**
+         * @brief Runs the handlers of the pending pins in a status word
+         * 
+         * The status bit is cleared after the handler, as the ESP-IDF service
+         * does, so level interrupts see the pin's condition handled first.
+         * 
+         * @param table Dispatch table of the core
+         * @param status Pending pins of the core in this word
+         * @param first_pin GPIO of bit 0
+         * @param clear_reg Write-one-to-clear status register of the word
+         */
+        inline void IRAM_ATTR dispatch_word(const CoreTable &table, uint32_t status, int first_pin, uint32_t clear_reg){
+            while (status != 0){
+                const int bit = __builtin_ctz(status);
+                status &= status - 1;
+
+                const Dispatch &dispatch = table.pins[first_pin + bit];
+                if (dispatch.handler != nullptr){
+                    dispatch.handler(dispatch.arg);
+                }
+                REG_WRITE(clear_reg, 1UL << bit);
+            }
+        }
+    }
+
+    /**
+     * @brief Routes a pin's interrupt to a core and dispatches it from that core's table
+     * 
+     * The handler is set before the interrupt is enabled, so the dispatcher
+     * never sees a pending pin without a handler.
+     * 
+     * @param pin GPIO to route
+     * @param core Core to interrupt
+     * @param handler Handler run on that core for every interrupt of the pin
+     * @param arg Handler argument
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin, core or handler,
+     *         ESP_ERR_INVALID_STATE if the ESP-IDF service owns the core or its core is unknown
+     */
+    esp_err_t GpioCores::attach(gpio_num_t pin, BaseType_t core, gpio_isr_t handler, void *arg){
+        if (!GPIO_IS_VALID_GPIO(pin) || core < 0 || core >= portNUM_PROCESSORS || handler == nullptr){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        taskENTER_CRITICAL(&cores_mutex);
+        const bool taken = service_elsewhere || owners[core] == Owner::SERVICE;
+        if (!taken){
+            owners[core] = Owner::DISPATCHER;
+        }
+        taskEXIT_CRITICAL(&cores_mutex);
+        if (taken){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        CoreTable &table = tables[core];
+        if (table.handle == nullptr){
+            InstallRequest request{core, ESP_FAIL};
+            esp_err_t status = _runOn(core, _install, &request);
+            if (status == ESP_OK){
+                status = request.status;
+            }
+            if (status != ESP_OK){
+                taskENTER_CRITICAL(&cores_mutex);
+                owners[core] = Owner::NONE;
+                taskEXIT_CRITICAL(&cores_mutex);
+                return status;
+            }
+        }
+
+        detach(pin);
+        taskENTER_CRITICAL(&cores_mutex);
+        table.pins[pin] = {handler, arg};
+        pin_cores[pin] = core + 1;
+        REG_SET_FIELD(pin_reg(pin), GPIO_PIN0_INT_ENA, core == 0 ? PRO_CPU_INTR_ENA : APP_CPU_INTR_ENA);
+        taskEXIT_CRITICAL(&cores_mutex);
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Disables a routed pin's interrupt and removes it from its core's table
+     * 
+     * @param pin GPIO to remove
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin, ESP_ERR_INVALID_STATE if not routed
+     */
+    esp_err_t GpioCores::detach(gpio_num_t pin){
+        if (!GPIO_IS_VALID_GPIO(pin)){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        taskENTER_CRITICAL(&cores_mutex);
+        const uint8_t routed = pin_cores[pin];
+        if (routed != 0){
+            REG_SET_FIELD(pin_reg(pin), GPIO_PIN0_INT_ENA, 0);
+            tables[routed - 1].pins[pin] = {nullptr, nullptr};
+            pin_cores[pin] = 0;
+        }
+        taskEXIT_CRITICAL(&cores_mutex);
+
+        return routed != 0 ? ESP_OK : ESP_ERR_INVALID_STATE;
+    }
+
+    /**
+     * @brief Gets the number of interrupts a core's dispatcher has served
+     * 
+     * @param core Core to read
+     * @return uint32_t Dispatcher invocations since boot
+     */
+    uint32_t GpioCores::getDispatchCount(BaseType_t core){
+        if (core < 0 || core >= portNUM_PROCESSORS){
+            return 0;
+        }
+        return tables[core].dispatches;
+    }
+
+    /**
+     * @brief Installs the ESP-IDF GPIO interrupt service on a core and records the core as its own
+     * 
+     * The core is claimed before the installation, so a concurrent attach()
+     * cannot allocate a dispatcher there in between.
+     * 
+     * @param core Core to install the service on
+     * @return esp_err_t ESP_OK on success or if already installed, ESP_ERR_INVALID_ARG for a bad core,
+     *         ESP_ERR_INVALID_STATE if a dispatcher owns the core
+     */
+    esp_err_t GpioCores::installService(BaseType_t core){
+        if (core < 0 || core >= portNUM_PROCESSORS){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        taskENTER_CRITICAL(&cores_mutex);
+        // A racing caller's installation counts as installed, its core is recorded when it returns
+        bool installed = service_core != tskNO_AFFINITY || service_elsewhere;
+        for (BaseType_t other = 0; other < portNUM_PROCESSORS; other++){
+            installed = installed || owners[other] == Owner::SERVICE;
+        }
+        const bool taken = owners[core] == Owner::DISPATCHER;
+        if (!installed && !taken){
+            owners[core] = Owner::SERVICE;
+        }
+        taskEXIT_CRITICAL(&cores_mutex);
+        if (installed){
+            return ESP_OK;
+        }
+        if (taken){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        InstallRequest request{core, ESP_FAIL};
+        esp_err_t status = _runOn(core, _installService, &request);
+        if (status == ESP_OK){
+            status = request.status;
+        }
+
+        taskENTER_CRITICAL(&cores_mutex);
+        if (status == ESP_OK){
+            service_core = core;
+        } else {
+            owners[core] = Owner::NONE;
+            // Installed elsewhere in the application, its core cannot be known
+            service_elsewhere = status == ESP_ERR_INVALID_STATE;
+        }
+        taskEXIT_CRITICAL(&cores_mutex);
+
+        return status == ESP_ERR_INVALID_STATE ? ESP_OK : status;
+    }
+
+    /**
+     * @brief Gets the core that owns the ESP-IDF service
+     * 
+     * @return BaseType_t Core of the service, tskNO_AFFINITY if not installed through installService()
+     */
+    BaseType_t GpioCores::getServiceCore(void){
+        return service_core;
+    }
+
+    /**
+     * @brief Runs an interrupt allocation on a core
+     * 
+     * Interrupts are allocated on the core that calls esp_intr_alloc(), so
+     * the function runs there through esp_ipc.
+     * 
+     * @param core Core to run on
+     * @param function Function to run
+     * @param arg Function argument
+     * @return esp_err_t ESP_OK once the function ran, ESP_FAIL if esp_ipc could not run it
+     */
+    esp_err_t GpioCores::_runOn(BaseType_t core, void (*function)(void *), void *arg){
+#if CONFIG_FREERTOS_UNICORE
+        function(arg);
+        return ESP_OK;
+#else
+        return esp_ipc_call_blocking(core, function, arg) == ESP_OK ? ESP_OK : ESP_FAIL;
+#endif
+    }
+
+    /**
+     * @brief Installs the ESP-IDF service on the calling core, run there through esp_ipc
+     * 
+     * @param arg InstallRequest of the core
+     */
+    void GpioCores::_installService(void *arg){
+        auto *request = static_cast<InstallRequest *>(arg);
+        request->status = gpio_install_isr_service(0);
+    }
+
+    /**
+     * @brief Allocates the GPIO interrupt on the calling core, run there through esp_ipc
+     * 
+     * Uses the flags of the ESP-IDF service, a level 1 interrupt outside IRAM.
+     * 
+     * @param arg InstallRequest of the core
+     */
+    void GpioCores::_install(void *arg){
+        auto *request = static_cast<InstallRequest *>(arg);
+        CoreTable &table = tables[request->core];
+        request->status = esp_intr_alloc(ETS_GPIO_INTR_SOURCE, 0, _dispatch, &table, &table.handle);
+        if (request->status != ESP_OK){
+            table.handle = nullptr;
+        }
+    }
+
+    /**
+     * @brief Interrupt of one core, runs the handlers of the pins pending on it
+     * 
+     * Reads the core's own interrupt status, which only has the pins whose
+     * interrupt is enabled for that core.
+     * 
+     * @param arg CoreTable of the core
+     */
+    void IRAM_ATTR GpioCores::_dispatch(void *arg){
+        auto *table = static_cast<CoreTable *>(arg);
+        const bool pro_cpu = table == &tables[0];
+        table->dispatches++;
+
+        dispatch_word(*table, REG_READ(pro_cpu ? GPIO_PCPU_INT_REG : GPIO_ACPU_INT_REG), 0, GPIO_STATUS_W1TC_REG);
+        dispatch_word(*table, REG_READ(pro_cpu ? GPIO_PCPU_INT1_REG : GPIO_ACPU_INT1_REG) & 0xFF, 32, GPIO_STATUS1_W1TC_REG);
+    }
+
+}
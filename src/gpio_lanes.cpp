@@ -0,0 +1,236 @@
+#include "gpio_lanes.h"
+#include <atomic>
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "timebase.h"
+
+namespace GPIO {
+    namespace {
+        /**
+         * @brief Handler of a routed pin
+         */
+        struct Route {
+            LaneHandler handler;
+            void *context;
+        };
+
+        /**
+         * @brief Ring and dispatcher of one priority class
+         * 
+         * With GpioCores the GPIO ISR runs on both cores, so producers
+         * serialize on the lane's spinlock. The dispatcher is the only
+         * consumer and reads without it.
+         */
+        struct Lane {
+            LaneEvent ring[GpioLanes::RING_SIZE];
+            portMUX_TYPE producer_mutex = portMUX_INITIALIZER_UNLOCKED;    ///< Serializes ISRs posting to this lane
+            std::atomic<uint32_t> head;         ///< Next slot an ISR writes
+            std::atomic<uint32_t> tail;         ///< Next slot the dispatcher reads
+            TaskHandle_t task;
+            volatile bool running;
+            StaticSemaphore_t stopped_buffer;
+            SemaphoreHandle_t stopped;
+            uint32_t delivered;
+            uint32_t drops;
+            uint32_t high_water;
+        };
+
+        DRAM_ATTR Lane lanes[PRIORITY_CLASSES];
+
+        /**
+         * @brief Lane of each pin plus one, 0 while the pin is not routed
+         */
+        DRAM_ATTR uint8_t pin_lanes[GPIO_NUM_MAX];
+        Route routes[GPIO_NUM_MAX];
+
+        /**
+         * @brief Guards dispatcher handles against a lane being stopped while the ISR notifies it
+         */
+        portMUX_TYPE lanes_mutex = portMUX_INITIALIZER_UNLOCKED;
+    }
+
+    /**
+     * @brief Creates the dispatcher task of a lane
+     * 
+     * @param priority_class Lane to start
+     * @param task_priority FreeRTOS priority of the dispatcher, handlers run at it
+     * @param core Core of the dispatcher, tskNO_AFFINITY for either
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if running,
+     *         ESP_ERR_NO_MEM if the task could not be created
+     */
+    esp_err_t GpioLanes::start(PriorityClass priority_class, UBaseType_t task_priority, BaseType_t core){
+        Lane &lane = lanes[static_cast<size_t>(priority_class)];
+        if (lane.task != nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        if (lane.stopped == nullptr){
+            lane.stopped = xSemaphoreCreateBinaryStatic(&lane.stopped_buffer);
+        }
+        lane.head.store(0, std::memory_order_relaxed);
+        lane.tail.store(0, std::memory_order_relaxed);
+        lane.delivered = 0;
+        taskENTER_CRITICAL(&lane.producer_mutex);
+        lane.drops = 0;
+        lane.high_water = 0;
+        taskEXIT_CRITICAL(&lane.producer_mutex);
+        lane.running = true;
+
+        TaskHandle_t task{nullptr};
+        if (xTaskCreatePinnedToCore(_dispatcherTask, "gpio_lane", 3072, &lane, task_priority, &task, core) != pdPASS){
+            lane.running = false;
+            return ESP_ERR_NO_MEM;
+        }
+        taskENTER_CRITICAL(&lanes_mutex);
+        lane.task = task;
+        taskEXIT_CRITICAL(&lanes_mutex);
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Stops the dispatcher task of a lane, events still in its ring are discarded
+     * 
+     * @param priority_class Lane to stop
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if not running
+     */
+    esp_err_t GpioLanes::stop(PriorityClass priority_class){
+        Lane &lane = lanes[static_cast<size_t>(priority_class)];
+
+        taskENTER_CRITICAL(&lanes_mutex);
+        TaskHandle_t task = lane.task;
+        lane.task = nullptr;
+        taskEXIT_CRITICAL(&lanes_mutex);
+        if (task == nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        lane.running = false;
+        xTaskNotifyGive(task);
+        xSemaphoreTake(lane.stopped, portMAX_DELAY);
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Routes the edges of a pin to a lane
+     * 
+     * The handler is set before the lane, so the ISR never queues an edge
+     * the dispatcher has no handler for.
+     * 
+     * @param pin GPIO to route
+     * @param priority_class Lane of the pin
+     * @param handler Handler run for every edge
+     * @param context Handler argument
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin or handler
+     */
+    esp_err_t GpioLanes::route(gpio_num_t pin, PriorityClass priority_class, LaneHandler handler, void *context){
+        if (!GPIO_IS_VALID_GPIO(pin) || handler == nullptr || static_cast<size_t>(priority_class) >= PRIORITY_CLASSES){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        unroute(pin);
+        taskENTER_CRITICAL(&lanes_mutex);
+        routes[pin] = {handler, context};
+        pin_lanes[pin] = static_cast<uint8_t>(priority_class) + 1;
+        taskEXIT_CRITICAL(&lanes_mutex);
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Stops routing a pin, its edges are counted as undelivered
+     * 
+     * Edges of the pin still in a ring are skipped by the dispatcher.
+     * 
+     * @param pin GPIO to unroute
+     */
+    void GpioLanes::unroute(gpio_num_t pin){
+        if (!GPIO_IS_VALID_GPIO(pin)){
+            return;
+        }
+        taskENTER_CRITICAL(&lanes_mutex);
+        pin_lanes[pin] = 0;
+        routes[pin] = {nullptr, nullptr};
+        taskEXIT_CRITICAL(&lanes_mutex);
+    }
+
+    /**
+     * @brief Queues an edge of a routed pin on its lane, called from the GPIO ISR
+     * 
+     * @param pin GPIO that interrupted
+     * @param woken Set to pdTRUE if the dispatcher should run before the ISR returns
+     * @return bool True if the edge was queued
+     */
+    bool IRAM_ATTR GpioLanes::post(gpio_num_t pin, BaseType_t *woken){
+        if (pin < 0 || pin >= GPIO_NUM_MAX || pin_lanes[pin] == 0){
+            return false;
+        }
+        Lane &lane = lanes[pin_lanes[pin] - 1];
+        const int64_t now_us = Timebase::Now();
+
+        taskENTER_CRITICAL_ISR(&lane.producer_mutex);
+        const uint32_t head = lane.head.load(std::memory_order_relaxed);
+        const uint32_t waiting = head - lane.tail.load(std::memory_order_acquire);
+        const bool queued = waiting < RING_SIZE && lane.task != nullptr;
+        if (queued){
+            lane.ring[head & (RING_SIZE - 1)] = {pin, now_us};
+            lane.head.store(head + 1, std::memory_order_release);
+            if (waiting + 1 > lane.high_water){
+                lane.high_water = waiting + 1;
+            }
+        } else {
+            lane.drops++;
+        }
+        taskEXIT_CRITICAL_ISR(&lane.producer_mutex);
+        if (!queued){
+            return false;
+        }
+
+        taskENTER_CRITICAL_ISR(&lanes_mutex);
+        if (lane.task != nullptr){
+            vTaskNotifyGiveFromISR(lane.task, woken);
+        }
+        taskEXIT_CRITICAL_ISR(&lanes_mutex);
+        return true;
+    }
+
+    /**
+     * @brief Gets the counters of a lane
+     * 
+     * @param priority_class Lane to read
+     * @return LaneStats Counters since the lane was started
+     */
+    LaneStats GpioLanes::getStats(PriorityClass priority_class){
+        const Lane &lane = lanes[static_cast<size_t>(priority_class)];
+        return {lane.delivered, lane.drops, lane.high_water};
+    }
+
+    /**
+     * @brief Drains a lane whenever the ISR notifies it
+     * 
+     * @param arg Lane to serve
+     */
+    void GpioLanes::_dispatcherTask(void *arg){
+        Lane &lane = *static_cast<Lane *>(arg);
+
+        while (lane.running){
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+            uint32_t tail = lane.tail.load(std::memory_order_relaxed);
+            while (lane.running && tail != lane.head.load(std::memory_order_acquire)){
+                const LaneEvent event = lane.ring[tail & (RING_SIZE - 1)];
+                lane.tail.store(++tail, std::memory_order_release);
+
+                taskENTER_CRITICAL(&lanes_mutex);
+                const Route route = routes[event.pin];
+                taskEXIT_CRITICAL(&lanes_mutex);
+                if (route.handler != nullptr){
+                    route.handler(event, route.context);
+                    lane.delivered++;
+                }
+            }
+        }
+
+        xSemaphoreGive(lane.stopped);
+        vTaskDelete(nullptr);
+    }
+
+}
@@ -0,0 +1,382 @@
+#include "gpio_liveness.h"
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "timebase.h"
+
+namespace GPIO {
+    ESP_EVENT_DEFINE_BASE(LIVENESS_EVENTS);
+
+    namespace {
+        constexpr int8_t NO_PIN = -1;
+
+        /**
+         * @brief Word of each mask holding GPIO 0 to 31 and 32 to 39
+         */
+        constexpr size_t MASK_WORDS = 2;
+
+        /**
+         * @brief Wheel state of a pin, only touched under liveness_mutex
+         */
+        struct Watch {
+            uint32_t timeout_us;
+            uint32_t lost_edge_us;  ///< Last edge before the pin was lost
+            int8_t prev;            ///< Neighbours in the pin's wheel slot
+            int8_t next;
+            uint8_t slot;
+            bool watched;
+            bool lost;
+        };
+
+        /**
+         * @brief Event collected under the lock and posted after it
+         */
+        struct Pending {
+            int32_t id;
+            LivenessEvent event;
+        };
+
+        DRAM_ATTR std::atomic<uint32_t> last_edge_us[GPIO_NUM_MAX];
+        DRAM_ATTR std::atomic<uint32_t> lost_pins[MASK_WORDS];
+        DRAM_ATTR std::atomic<uint32_t> restored_pins[MASK_WORDS];
+
+        Watch watches[GPIO_NUM_MAX];
+        int8_t wheel[GpioLiveness::WHEEL_SLOTS];
+        bool wheel_ready{false};
+        uint32_t cursor{0};
+        uint32_t wheel_tick_us{GpioLiveness::MIN_TICK_US};
+
+        esp_timer_handle_t wheel_timer{nullptr};
+        esp_event_loop_handle_t event_loop{nullptr};
+        std::atomic<uint32_t> drops{0};
+
+        // A pin posts at most one event per tick, restored pins are never due in the current slot
+        Pending pending[GPIO_NUM_MAX];
+
+        portMUX_TYPE liveness_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+        /**
+         * @brief Low 32 bits of the timebase, edge ages are taken modulo 2^32
+         * 
+         * @return uint32_t Microseconds
+         */
+        inline uint32_t IRAM_ATTR now_us(void){
+            return static_cast<uint32_t>(Timebase::Now());
+        }
+
+        /**
+         * @brief Time since a pin's last edge
+         * 
+         * @param pin GPIO to check
+         * @param now Current time
+         * @return int32_t Microseconds, negative for an edge after now
+         */
+        inline int32_t edge_age(int8_t pin, uint32_t now){
+            return static_cast<int32_t>(now - last_edge_us[pin].load(std::memory_order_seq_cst));
+        }
+
+        void clear_wheel(void){
+            for (int8_t &head : wheel){
+                head = NO_PIN;
+            }
+            wheel_ready = true;
+        }
+
+        /**
+         * @brief Puts a pin in the slot of its deadline
+         * 
+         * Deadlines beyond one turn land in the last slot and are
+         * rescheduled from there.
+         * 
+         * @param pin GPIO to schedule
+         * @param delay_us Time until the deadline
+         */
+        void schedule(int8_t pin, uint32_t delay_us){
+            uint32_t ticks = (delay_us + wheel_tick_us - 1) / wheel_tick_us;
+            if (ticks == 0){
+                ticks = 1;
+            } else if (ticks >= GpioLiveness::WHEEL_SLOTS){
+                ticks = GpioLiveness::WHEEL_SLOTS - 1;
+            }
+
+            Watch &watch = watches[pin];
+            watch.slot = (cursor + ticks) % GpioLiveness::WHEEL_SLOTS;
+            watch.prev = NO_PIN;
+            watch.next = wheel[watch.slot];
+            if (watch.next != NO_PIN){
+                watches[watch.next].prev = pin;
+            }
+            wheel[watch.slot] = pin;
+        }
+
+        /**
+         * @brief Schedules a pin for the end of its timeout after its last edge
+         * 
+         * @param pin GPIO to schedule
+         * @param now Current time
+         */
+        void schedule_from_edge(int8_t pin, uint32_t now){
+            const int32_t age = edge_age(pin, now);
+            const uint32_t timeout = watches[pin].timeout_us;
+            if (age < 0){
+                schedule(pin, timeout);
+            } else {
+                schedule(pin, static_cast<uint32_t>(age) < timeout ? timeout - age : 0);
+            }
+        }
+
+        void unschedule(int8_t pin){
+            Watch &watch = watches[pin];
+            if (watch.prev != NO_PIN){
+                watches[watch.prev].next = watch.next;
+            } else {
+                wheel[watch.slot] = watch.next;
+            }
+            if (watch.next != NO_PIN){
+                watches[watch.next].prev = watch.prev;
+            }
+        }
+
+        void post_event(const Pending &pending_event){
+            esp_err_t status;
+            if (event_loop != nullptr){
+                status = esp_event_post_to(event_loop, LIVENESS_EVENTS, pending_event.id, &pending_event.event, sizeof(LivenessEvent), 0);
+            } else {
+                status = esp_event_post(LIVENESS_EVENTS, pending_event.id, &pending_event.event, sizeof(LivenessEvent), 0);
+            }
+            if (status != ESP_OK){
+                drops.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Starts the wheel timer
+     * 
+     * Pins watched before the start are rescheduled for the new tick.
+     * 
+     * @param tick_us Wheel resolution
+     * @param loop Custom event loop, nullptr to post to the default loop
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a tick below MIN_TICK_US,
+     *         ESP_ERR_INVALID_STATE if already started
+     */
+    esp_err_t GpioLiveness::start(uint32_t tick_us, esp_event_loop_handle_t loop){
+        if (tick_us < MIN_TICK_US){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (wheel_timer != nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        esp_timer_create_args_t args{};
+        args.callback = _tick;
+        args.name = "gpio_liveness";
+        args.skip_unhandled_events = true;
+        esp_err_t status = esp_timer_create(&args, &wheel_timer);
+        if (status != ESP_OK){
+            wheel_timer = nullptr;
+            return status;
+        }
+
+        taskENTER_CRITICAL(&liveness_mutex);
+        event_loop = loop;
+        wheel_tick_us = tick_us;
+        cursor = 0;
+        clear_wheel();
+        const uint32_t now = now_us();
+        for (int8_t pin = 0; pin < GPIO_NUM_MAX; pin++){
+            if (watches[pin].watched && !watches[pin].lost){
+                schedule_from_edge(pin, now);
+            }
+        }
+        taskEXIT_CRITICAL(&liveness_mutex);
+
+        status = esp_timer_start_periodic(wheel_timer, tick_us);
+        if (status != ESP_OK){
+            stop();
+        }
+        return status;
+    }
+
+    /**
+     * @brief Stops the wheel timer, watched pins stay registered
+     */
+    void GpioLiveness::stop(void){
+        if (wheel_timer == nullptr){
+            return;
+        }
+        esp_timer_stop(wheel_timer);
+        esp_timer_delete(wheel_timer);
+        wheel_timer = nullptr;
+    }
+
+    /**
+     * @brief Starts watching a pin, counted as alive from now
+     * 
+     * @param pin GPIO to watch
+     * @param timeout_us Time without edges after which the pin is lost
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin or timeout
+     */
+    esp_err_t GpioLiveness::watch(gpio_num_t pin, uint32_t timeout_us){
+        if (pin < 0 || pin >= GPIO_NUM_MAX || timeout_us == 0 || timeout_us > MAX_TIMEOUT_US){
+            return ESP_ERR_INVALID_ARG;
+        }
+        const size_t word = pin >> 5;
+        const uint32_t bit = 1UL << (pin & 31);
+
+        taskENTER_CRITICAL(&liveness_mutex);
+        if (!wheel_ready){
+            clear_wheel();
+        }
+        Watch &watch = watches[pin];
+        if (watch.watched && !watch.lost){
+            unschedule(pin);
+        }
+        const uint32_t now = now_us();
+        last_edge_us[pin].store(now, std::memory_order_seq_cst);
+        lost_pins[word].fetch_and(~bit, std::memory_order_seq_cst);
+        watch.timeout_us = timeout_us;
+        watch.watched = true;
+        watch.lost = false;
+        schedule(pin, timeout_us);
+        taskEXIT_CRITICAL(&liveness_mutex);
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Stops watching a pin without posting an event
+     * 
+     * @param pin GPIO to forget
+     */
+    void GpioLiveness::unwatch(gpio_num_t pin){
+        if (pin < 0 || pin >= GPIO_NUM_MAX){
+            return;
+        }
+        const size_t word = pin >> 5;
+        const uint32_t bit = 1UL << (pin & 31);
+
+        taskENTER_CRITICAL(&liveness_mutex);
+        Watch &watch = watches[pin];
+        if (watch.watched && !watch.lost){
+            unschedule(pin);
+        }
+        watch.watched = false;
+        watch.lost = false;
+        lost_pins[word].fetch_and(~bit, std::memory_order_seq_cst);
+        taskEXIT_CRITICAL(&liveness_mutex);
+    }
+
+    /**
+     * @brief Records an edge of a watched pin, called from the GPIO ISR
+     * 
+     * The edge time is stored before the lost mask is read, and the wheel
+     * sets the lost bit before it reads the edge time again, so either
+     * this edge flags a restore or the wheel sees it and keeps the pin alive.
+     * 
+     * @param pin GPIO that interrupted
+     */
+    void IRAM_ATTR GpioLiveness::post(gpio_num_t pin){
+        if (pin < 0 || pin >= GPIO_NUM_MAX){
+            return;
+        }
+        const size_t word = pin >> 5;
+        const uint32_t bit = 1UL << (pin & 31);
+
+        last_edge_us[pin].store(now_us(), std::memory_order_seq_cst);
+        if (lost_pins[word].load(std::memory_order_seq_cst) & bit){
+            restored_pins[word].fetch_or(bit, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Checks whether a pin is currently reported lost
+     * 
+     * @param pin GPIO to check
+     * @return true if SIGNAL_LOST was the pin's last event
+     */
+    bool GpioLiveness::isLost(gpio_num_t pin){
+        if (pin < 0 || pin >= GPIO_NUM_MAX){
+            return false;
+        }
+        taskENTER_CRITICAL(&liveness_mutex);
+        const bool lost = watches[pin].lost;
+        taskEXIT_CRITICAL(&liveness_mutex);
+        return lost;
+    }
+
+    /**
+     * @brief Gets the number of events the event loop had no room for
+     * 
+     * @return uint32_t Dropped events since boot
+     */
+    uint32_t GpioLiveness::getDropCount(void){
+        return drops.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Advances the wheel by one slot, run by the esp_timer task every tick
+     * 
+     * Restores are handled first so a restored pin is rescheduled before
+     * the slot is checked. Events are posted after the lock is released.
+     * 
+     * @param arg Unused
+     */
+    void GpioLiveness::_tick(void *arg){
+        size_t count{0};
+
+        taskENTER_CRITICAL(&liveness_mutex);
+        const uint32_t now = now_us();
+        cursor = (cursor + 1) % WHEEL_SLOTS;
+
+        for (size_t word = 0; word < MASK_WORDS; word++){
+            uint32_t restored = restored_pins[word].exchange(0, std::memory_order_acquire);
+            while (restored != 0){
+                const int8_t pin = static_cast<int8_t>(32 * word + __builtin_ctz(restored));
+                const uint32_t bit = restored & -restored;
+                restored &= restored - 1;
+
+                Watch &watch = watches[pin];
+                if (!watch.watched || !watch.lost){
+                    continue;
+                }
+                watch.lost = false;
+                lost_pins[word].fetch_and(~bit, std::memory_order_seq_cst);
+                const uint32_t edge = last_edge_us[pin].load(std::memory_order_relaxed);
+                pending[count++] = {SIGNAL_RESTORED, {static_cast<gpio_num_t>(pin), edge - watch.lost_edge_us}};
+                schedule_from_edge(pin, now);
+            }
+        }
+
+        int8_t pin = wheel[cursor];
+        wheel[cursor] = NO_PIN;
+        while (pin != NO_PIN){
+            Watch &watch = watches[pin];
+            const int8_t next = watch.next;
+            const int32_t age = edge_age(pin, now);
+
+            if (age < 0 || static_cast<uint32_t>(age) < watch.timeout_us){
+                schedule_from_edge(pin, now);
+            } else {
+                const size_t word = pin >> 5;
+                const uint32_t bit = 1UL << (pin & 31);
+                lost_pins[word].fetch_or(bit, std::memory_order_seq_cst);
+                if (edge_age(pin, now) != age){
+                    // An edge raced the check and did not see the lost bit
+                    lost_pins[word].fetch_and(~bit, std::memory_order_seq_cst);
+                    schedule_from_edge(pin, now);
+                } else {
+                    watch.lost = true;
+                    watch.lost_edge_us = now - age;
+                    pending[count++] = {SIGNAL_LOST, {static_cast<gpio_num_t>(pin), static_cast<uint32_t>(age)}};
+                }
+            }
+            pin = next;
+        }
+        taskEXIT_CRITICAL(&liveness_mutex);
+
+        for (size_t i = 0; i < count; i++){
+            post_event(pending[i]);
+        }
+    }
+
+}
@@ -0,0 +1,85 @@
+#include "gpio_state.h"
+#include <atomic>
+
+namespace GPIO {
+    namespace {
+        /**
+         * @brief Word of each mask holding GPIO 0 to 31 and 32 to 39
+         */
+        constexpr size_t MASK_WORDS = 2;
+
+        DRAM_ATTR std::atomic<uint32_t> levels[MASK_WORDS];
+        DRAM_ATTR std::atomic<uint32_t> changed[MASK_WORDS];
+    }
+
+    /**
+     * @brief Records an edge of a tracked pin, called from the GPIO ISR
+     * 
+     * @param pin GPIO that interrupted
+     * @param level Raw level of the pin
+     */
+    void IRAM_ATTR GpioState::post(gpio_num_t pin, uint32_t level){
+        if (pin < 0 || pin >= GPIO_NUM_MAX){
+            return;
+        }
+        const size_t word = pin >> 5;
+        const uint32_t bit = 1UL << (pin & 31);
+
+        if (level){
+            levels[word].fetch_or(bit, std::memory_order_relaxed);
+        } else {
+            levels[word].fetch_and(~bit, std::memory_order_relaxed);
+        }
+        changed[word].fetch_or(bit, std::memory_order_release);
+    }
+
+    /**
+     * @brief Gets the current levels
+     * 
+     * @return uint64_t Raw level of each tracked pin
+     */
+    uint64_t GpioState::getLevels(void){
+        return static_cast<uint64_t>(levels[1].load(std::memory_order_acquire)) << 32 |
+               levels[0].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Gets and clears the pins that changed
+     * 
+     * @return uint64_t Pins with an edge since the previous fetch
+     */
+    uint64_t GpioState::fetchChanged(void){
+        return static_cast<uint64_t>(changed[1].exchange(0, std::memory_order_acquire)) << 32 |
+               changed[0].exchange(0, std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Fetches the changed pins, then reads the levels
+     * 
+     * An edge between the two steps shows up in the levels now and as a
+     * change on the next poll.
+     * 
+     * @return PinStates Levels no older than the changes they are returned with
+     */
+    PinStates GpioState::poll(void){
+        const uint64_t changed_pins = fetchChanged();
+        return {getLevels(), changed_pins};
+    }
+
+    /**
+     * @brief Stops tracking a pin and clears its bits
+     * 
+     * @param pin GPIO to forget
+     */
+    void GpioState::clear(gpio_num_t pin){
+        if (pin < 0 || pin >= GPIO_NUM_MAX){
+            return;
+        }
+        const size_t word = pin >> 5;
+        const uint32_t bit = 1UL << (pin & 31);
+
+        levels[word].fetch_and(~bit, std::memory_order_relaxed);
+        changed[word].fetch_and(~bit, std::memory_order_release);
+    }
+
+}
@@ -0,0 +1,258 @@
+#include "gpio_trigger.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
+
+namespace GPIO {
+
+    /**
+     * @brief Define the event base for compound trigger events.
+     */
+    ESP_EVENT_DEFINE_BASE(TRIGGER_EVENTS);
+
+    /**
+     * @brief Default constructor for GpioTrigger.
+     */
+    GpioTrigger::GpioTrigger(void){
+    }
+
+    /**
+     * @brief Disables the interrupts of the edge pins so no ISR references this object.
+     */
+    GpioTrigger::~GpioTrigger(){
+        disable();
+    }
+
+    /**
+     * @brief ISR of an edge pin.
+     * 
+     * Takes one snapshot of the input registers (GPIO.in, and GPIO.in1 only
+     * when a trigger cares about GPIO 32 and up) and checks the triggers of
+     * the pin against it. The registers are read by address, the GPIO
+     * struct name is taken by this namespace.
+     * 
+     * @param arg Pointer to the _edge_args of the pin
+     */
+    void IRAM_ATTR GpioTrigger::_isr(void *arg){
+        auto *edge = static_cast<_edge_args *>(arg);
+        if (edge->type_tag != 0x47505447) {
+            return;
+        }
+        GpioTrigger *owner = edge->owner;
+
+        uint64_t levels = REG_READ(GPIO_IN_REG);
+        if (owner->_high_pins){
+            levels |= static_cast<uint64_t>(REG_READ(GPIO_IN1_REG) & 0xFF) << 32;
+        }
+        owner->_edges++;
+
+        BaseType_t woken{pdFALSE};
+        for (size_t i = edge->first; i < edge->first + edge->count; i++){
+            const _trigger &trigger = owner->_triggers[i];
+            if ((levels & trigger.care_mask) != trigger.value_mask){
+                continue;
+            }
+
+            owner->_matches++;
+            const TriggerEvent event{trigger.id, edge->pin, levels};
+            bool delivered{false};
+            if (owner->_queue_handle != nullptr){
+                delivered = xQueueSendFromISR(owner->_queue_handle, &event, &woken) == pdTRUE;
+            } else if (owner->_event_loop_handle != nullptr){
+                delivered = esp_event_isr_post_to(owner->_event_loop_handle, TRIGGER_EVENTS, trigger.id, &event, sizeof(event), &woken) == ESP_OK;
+            } else {
+                delivered = esp_event_isr_post(TRIGGER_EVENTS, trigger.id, &event, sizeof(event), &woken) == ESP_OK;
+            }
+            if (!delivered){
+                owner->_drops++;
+            }
+        }
+
+        if (woken == pdTRUE){
+            portYIELD_FROM_ISR();
+        }
+    }
+
+    /**
+     * @brief Adds a trigger
+     * 
+     * @param definition Condition of the trigger
+     * @param id Id delivered when the trigger matches
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad pin or a value bit outside care_mask,
+     *         ESP_ERR_NO_MEM when full, ESP_ERR_INVALID_STATE while enabled
+     */
+    esp_err_t GpioTrigger::addTrigger(const TriggerDefinition &definition, int32_t id){
+        if (_enabled){
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (!GPIO_IS_VALID_GPIO(definition.edge_pin) || (definition.value_mask & ~definition.care_mask) != 0 ||
+            (definition.care_mask >> GPIO_NUM_MAX) != 0){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (_trigger_count >= MAX_TRIGGERS){
+            return ESP_ERR_NO_MEM;
+        }
+
+        _triggers[_trigger_count++] = {definition.care_mask, definition.value_mask, definition.edge_pin, id};
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Removes every trigger
+     * 
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE while enabled
+     */
+    esp_err_t GpioTrigger::clearTriggers(void){
+        if (_enabled){
+            return ESP_ERR_INVALID_STATE;
+        }
+        _trigger_count = 0;
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Delivers matches as TriggerEvent items to a queue
+     * 
+     * @param queue Queue created with an item size of sizeof(TriggerEvent)
+     */
+    void GpioTrigger::setQueueHandle(QueueHandle_t queue){
+        _queue_handle = queue;
+        _event_loop_set = false;
+        _event_loop_handle = nullptr;
+    }
+
+    /**
+     * @brief Posts matches as TRIGGER_EVENTS to an event loop
+     * 
+     * @param loop Event loop to post to, nullptr for the default loop
+     */
+    void GpioTrigger::setEventLoop(esp_event_loop_handle_t loop){
+        _queue_handle = nullptr;
+        _event_loop_set = true;
+        _event_loop_handle = loop;
+    }
+
+    /**
+     * @brief Groups the triggers by edge pin
+     * 
+     * Triggers keep the order they were added in within their pin, so the
+     * ISR delivers matches of one edge in that order.
+     * 
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM for more than MAX_EDGE_PINS edge pins
+     */
+    esp_err_t GpioTrigger::_compile(void){
+        // Stable insertion sort, the table is small
+        for (size_t i = 1; i < _trigger_count; i++){
+            const _trigger trigger = _triggers[i];
+            size_t j = i;
+            while (j > 0 && _triggers[j - 1].edge_pin > trigger.edge_pin){
+                _triggers[j] = _triggers[j - 1];
+                j--;
+            }
+            _triggers[j] = trigger;
+        }
+
+        _edge_pin_count = 0;
+        _high_pins = false;
+        for (size_t i = 0; i < _trigger_count; i++){
+            _high_pins |= (_triggers[i].care_mask >> 32) != 0;
+            if (_edge_pin_count > 0 && _edge_pins[_edge_pin_count - 1].pin == _triggers[i].edge_pin){
+                _edge_pins[_edge_pin_count - 1].count++;
+                continue;
+            }
+            if (_edge_pin_count >= MAX_EDGE_PINS){
+                return ESP_ERR_NO_MEM;
+            }
+            _edge_args &edge = _edge_pins[_edge_pin_count++];
+            edge.owner = this;
+            edge.pin = _triggers[i].edge_pin;
+            edge.first = i;
+            edge.count = 1;
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Compiles the triggers and enables interrupts on every edge pin
+     * 
+     * Edge pins interrupt on both edges, the rising or falling direction is
+     * part of each trigger's condition on its own edge pin.
+     * 
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if no triggers, no delivery target or already enabled,
+     *         ESP_ERR_NO_MEM for too many edge pins, error code otherwise
+     */
+    esp_err_t GpioTrigger::enable(void){
+        if (_enabled || _trigger_count == 0 || (_queue_handle == nullptr && !_event_loop_set)){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        esp_err_t status = _compile();
+        if (status == ESP_OK){
+            status = GpioInput::installInterruptService();
+        }
+        if (status != ESP_OK){
+            return status;
+        }
+
+        _edges = 0;
+        _matches = 0;
+        _drops = 0;
+        _enabled = true;
+        for (size_t i = 0; i < _edge_pin_count && status == ESP_OK; i++){
+            status = gpio_set_intr_type(_edge_pins[i].pin, GPIO_INTR_ANYEDGE);
+            if (status == ESP_OK){
+                status = gpio_isr_handler_add(_edge_pins[i].pin, _isr, &_edge_pins[i]);
+            }
+        }
+        if (status != ESP_OK){
+            disable();
+        }
+        return status;
+    }
+
+    /**
+     * @brief Disables interrupts on every edge pin
+     * 
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t GpioTrigger::disable(void){
+        if (!_enabled){
+            return ESP_OK;
+        }
+
+        esp_err_t status{ESP_OK};
+        for (size_t i = 0; i < _edge_pin_count; i++){
+            status |= gpio_set_intr_type(_edge_pins[i].pin, GPIO_INTR_DISABLE);
+            status |= gpio_isr_handler_remove(_edge_pins[i].pin);
+        }
+        _enabled = false;
+        return status;
+    }
+
+    /**
+     * @brief Gets the number of edges evaluated
+     * 
+     * @return uint32_t Edges on the edge pins since enable()
+     */
+    uint32_t GpioTrigger::getEdgeCount(void) const{
+        return _edges;
+    }
+
+    /**
+     * @brief Gets the number of matches delivered or dropped
+     * 
+     * @return uint32_t Matching triggers since enable()
+     */
+    uint32_t GpioTrigger::getMatchCount(void) const{
+        return _matches;
+    }
+
+    /**
+     * @brief Gets the number of matches the queue or event loop had no room for
+     * 
+     * @return uint32_t Dropped matches since enable()
+     */
+    uint32_t GpioTrigger::getDropCount(void) const{
+        return _drops;
+    }
+
+}
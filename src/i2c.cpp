@@ -1,6 +1,40 @@
 #include "i2c.h"
+#include <cstring>
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_private/esp_clk.h"
+#include "i2c_crc.h"
+#include "metrics.h"
+#include "trace.h"
+#include "timebase.h"
 
 namespace I2C {
+    namespace {
+        /**
+         * @brief Command link storage large enough for any transfer
+         */
+        struct LinkBlock {
+            alignas(4) uint8_t buffer[I2c::LinkSize(I2c::MAX_SEGMENTS, I2c::MAX_SEGMENTS)];
+        };
+
+#ifdef CONFIG_I2C_POOL_FAIL_FAST
+        constexpr TickType_t POOL_WAIT = 0;
+#else
+        constexpr TickType_t POOL_WAIT = pdMS_TO_TICKS(CONFIG_I2C_POOL_WAIT_MS) > 0 ? pdMS_TO_TICKS(CONFIG_I2C_POOL_WAIT_MS) : 1;
+#endif
+
+        /**
+         * @brief Command link buffers of each port
+         */
+        LockFreePool<LinkBlock, CONFIG_I2C_LINK_POOL_BLOCKS> link_pools[I2C_NUM_MAX];
+
+        /**
+         * @brief Transaction descriptors of each port
+         */
+        LockFreePool<Transaction, CONFIG_I2C_DESCRIPTOR_POOL_SIZE> descriptor_pools[I2C_NUM_MAX];
+    }
+
     /**
      * @brief Construct a new I2c object
      * 
@@ -17,6 +51,8 @@ namespace I2C {
         _slv_rx_buf_len = slv_rx_buf_len;
         _slv_tx_buf_len = slv_tx_buf_len;
         _intr_alloc_flags = intr_alloc_flags;
+        memset(_device_index, NO_DEVICE, sizeof(_device_index));
+        _bus_lock = xSemaphoreCreateMutexStatic(&_bus_lock_buffer);
     }
 
     /**
@@ -26,6 +62,11 @@ namespace I2C {
      */
     I2c::~I2c(){
         i2c_driver_delete(_port);
+#ifdef CONFIG_I2C_PM_LOCK
+        if (_pm_lock != nullptr){
+            esp_pm_lock_delete(_pm_lock);
+        }
+#endif
     }
 
     /**
@@ -45,7 +86,6 @@ namespace I2C {
      */
     esp_err_t I2c::InitMaster(int sda_io_num, int scl_io_num, uint32_t clk_speed, bool sda_pullup_en, bool scl_pullup_en, uint32_t clk_flags){
         esp_err_t status{ESP_OK};
-        i2c_config_t _config{};
         _mode = I2C_MODE_MASTER;
 
         _config.mode = I2C_MODE_MASTER;
@@ -57,7 +97,13 @@ namespace I2C {
         _config.clk_flags = clk_flags;
 
         status |= i2c_param_config(_port, &_config);
-        status |= i2c_driver_install(_port, _mode, _slv_rx_buf_len, _slv_tx_buf_len, 0);
+        status |= i2c_driver_install(_port, _mode, _slv_rx_buf_len, _slv_tx_buf_len, _intr_alloc_flags);
+        _active_timing = {clk_speed, 0, 0};
+#ifdef CONFIG_I2C_PM_LOCK
+        if (_pm_lock == nullptr){
+            status |= esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "i2c", &_pm_lock);
+        }
+#endif
         return status;
     }
             
@@ -65,7 +111,7 @@ namespace I2C {
      * @brief Read a single byte from an I2C register
      * 
      * Performs a read operation from a single register on the I2C device.
-     * Uses a 1-second timeout for the operation.
+     * Uses the device deadline, or a 1-second timeout if none was configured.
      * 
      * @param dev_addr I2C device address
      * @param reg_addr Register address to read from
@@ -73,7 +119,7 @@ namespace I2C {
      */
     uint8_t I2c::ReadRegister(uint8_t dev_addr, uint8_t reg_addr){
         uint8_t rxBuf{};
-        i2c_master_write_read_device(_port, dev_addr, &reg_addr, 1, &rxBuf, 1, pdMS_TO_TICKS(1000));
+        _transfer(dev_addr, &reg_addr, 1, &rxBuf, 1);
         return rxBuf;
     }
     
@@ -81,7 +127,7 @@ namespace I2C {
      * @brief Write a single byte to an I2C register
      * 
      * Performs a write operation to a single register on the I2C device.
-     * Uses a 1-second timeout for the operation.
+     * Uses the device deadline, or a 1-second timeout if none was configured.
      * 
      * @param dev_addr I2C device address
      * @param reg_addr Register address to write to
@@ -90,14 +136,15 @@ namespace I2C {
      */
     esp_err_t I2c::WriteRegister(uint8_t dev_addr, uint8_t reg_addr, uint8_t txData){
         const uint8_t txBuf[2] {reg_addr, txData};
-        return i2c_master_write_to_device(_port, dev_addr, txBuf, 2, pdMS_TO_TICKS(1000));
+        return _transfer(dev_addr, txBuf, 2, nullptr, 0);
     }
 
     /**
      * @brief Read multiple bytes from an I2C register
      * 
      * Performs a read operation from multiple consecutive registers on the I2C device.
-     * Uses a 1-second timeout for the operation.
+     * Uses the device deadline, or a 1-second timeout if none was configured.
+     * Verifies the SMBus PEC if the device policy enables it.
      * 
      * @param dev_addr I2C device address
      * @param reg_addr Starting register address to read from
@@ -106,14 +153,15 @@ namespace I2C {
      * @return esp_err_t ESP_OK on success, error code otherwise
      */
     esp_err_t I2c::ReadRegisterMultipleBytes(uint8_t dev_addr, uint8_t reg_addr, uint8_t *rx_data, int length){
-        return i2c_master_write_read_device(_port, dev_addr, &reg_addr, 1, rx_data, length, pdMS_TO_TICKS(1000));
+        return _transfer(dev_addr, &reg_addr, 1, rx_data, length);
     }
     
     /**
      * @brief Write multiple bytes to an I2C register
      * 
      * Performs a write operation to multiple consecutive registers on the I2C device.
-     * Uses a static command link for better performance and a 1-second timeout.
+     * Uses a pooled static command link and the device deadline.
+     * Appends the SMBus PEC if the device policy enables it.
      * 
      * @param dev_addr I2C device address
      * @param reg_addr Starting register address to write to
@@ -122,17 +170,1014 @@ namespace I2C {
      * @return esp_err_t ESP_OK on success, error code otherwise
      */
     esp_err_t I2c::WriteRegisterMultipleBytes(uint8_t dev_addr, uint8_t reg_addr, uint8_t *tx_data, int length){
+        return WriteRegisterMultipleBytes(dev_addr, reg_addr, std::span<const uint8_t>(tx_data, length));
+    }
+
+    /**
+     * @brief Read multiple bytes from an I2C register into a span
+     * 
+     * @param dev_addr I2C device address
+     * @param reg_addr Starting register address to read from
+     * @param rx_data Destination, its size is the number of bytes read
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t I2c::ReadRegisterMultipleBytes(uint8_t dev_addr, uint8_t reg_addr, std::span<uint8_t> rx_data){
+        return _transfer(dev_addr, &reg_addr, 1, rx_data.data(), rx_data.size());
+    }
+
+    /**
+     * @brief Write multiple bytes from a span to an I2C register
+     * 
+     * The register address and the payload are chained as two segments, the
+     * payload is never copied.
+     * 
+     * @param dev_addr I2C device address
+     * @param reg_addr Starting register address to write to
+     * @param tx_data Source, its size is the number of bytes written
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t I2c::WriteRegisterMultipleBytes(uint8_t dev_addr, uint8_t reg_addr, std::span<const uint8_t> tx_data){
+        return Write(dev_addr, {std::span<const uint8_t>(&reg_addr, 1), tx_data});
+    }
+
+    /**
+     * @brief Write several buffers as one transaction
+     * 
+     * @param dev_addr I2C device address
+     * @param tx Segments written back to back, at most MAX_SEGMENTS
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for too many segments,
+     *         ESP_ERR_NO_MEM if no link buffer became free, error code otherwise
+     */
+    esp_err_t I2c::Write(uint8_t dev_addr, std::span<const std::span<const uint8_t>> tx){
+        return WriteRead(dev_addr, tx, {});
+    }
+
+    /**
+     * @brief Write several buffers, then read into several buffers after a repeated start
+     * 
+     * @param dev_addr I2C device address
+     * @param tx Segments written back to back, at most MAX_SEGMENTS
+     * @param rx Segments filled in order, at most MAX_SEGMENTS
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for too many segments,
+     *         ESP_ERR_NO_MEM if no link buffer became free, error code otherwise
+     */
+    esp_err_t I2c::WriteRead(uint8_t dev_addr, std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx){
+        if (tx.size() > MAX_SEGMENTS || rx.size() > MAX_SEGMENTS){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        return _transfer(dev_addr, tx, rx);
+    }
+
+    /**
+     * @brief Read bytes without addressing a register first
+     * 
+     * @param dev_addr I2C device address
+     * @param rx_data Destination, its size is the number of bytes read
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an empty buffer,
+     *         ESP_ERR_NO_MEM if no link buffer became free, error code otherwise
+     */
+    esp_err_t I2c::Read(uint8_t dev_addr, std::span<uint8_t> rx_data){
+        if (rx_data.empty()){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        const std::span<uint8_t> rx[1]{rx_data};
+        return _transfer(dev_addr, {}, rx);
+    }
+
+    /**
+     * @brief Read 16-bit words that each carry a Sensirion CRC-8
+     * 
+     * @param dev_addr I2C device address
+     * @param reg_addr Register or command to read from
+     * @param words Output for the words
+     * @param count Number of words, at most MAX_CRC_WORDS
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_CRC if a word CRC does not match
+     */
+    esp_err_t I2c::ReadWords(uint8_t dev_addr, uint8_t reg_addr, uint16_t *words, size_t count){
+        if (count == 0 || count > MAX_CRC_WORDS){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        uint8_t frame[MAX_CRC_WORDS * 3];
+        esp_err_t status = _transfer(dev_addr, &reg_addr, 1, frame, count * 3);
+        if (status == ESP_OK && !Crc::UnpackSensirionWords(frame, words, count)){
+            status = _crcFailure();
+        }
+        return status;
+    }
+
+    /**
+     * @brief Write 16-bit words, adding a Sensirion CRC-8 after each
+     * 
+     * @param dev_addr I2C device address
+     * @param reg_addr Register or command to write to
+     * @param words Words to write
+     * @param count Number of words, at most MAX_CRC_WORDS
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t I2c::WriteWords(uint8_t dev_addr, uint8_t reg_addr, const uint16_t *words, size_t count){
+        if (count == 0 || count > MAX_CRC_WORDS){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        uint8_t frame[1 + MAX_CRC_WORDS * 3];
+        frame[0] = reg_addr;
+        Crc::PackSensirionWords(words, &frame[1], count);
+        return _transfer(dev_addr, frame, 1 + count * 3, nullptr, 0);
+    }
+
+    /**
+     * @brief Take a transaction descriptor from this port's pool
+     * 
+     * @return Transaction* Reset descriptor, or nullptr if the pool stayed exhausted
+     */
+    Transaction* I2c::AcquireTransaction(void){
+        Transaction *transaction = descriptor_pools[_port].Acquire(POOL_WAIT);
+        if (transaction != nullptr){
+            *transaction = Transaction{};
+        }
+        return transaction;
+    }
+
+    /**
+     * @brief Return a descriptor obtained from AcquireTransaction()
+     * 
+     * @param transaction Descriptor to release
+     */
+    void I2c::ReleaseTransaction(Transaction *transaction){
+        if (transaction != nullptr && descriptor_pools[_port].Owns(transaction)){
+            descriptor_pools[_port].Release(transaction);
+        }
+    }
+
+    /**
+     * @brief Get the usage counters of this port's command link pool
+     * 
+     * @return PoolStats Capacity, current use and high-water mark
+     */
+    PoolStats I2c::GetLinkPoolStats(void){
+        return link_pools[_port].GetStats();
+    }
+
+    /**
+     * @brief Get the usage counters of this port's descriptor pool
+     * 
+     * @return PoolStats Capacity, current use and high-water mark
+     */
+    PoolStats I2c::GetDescriptorPoolStats(void){
+        return descriptor_pools[_port].GetStats();
+    }
+
+    /**
+     * @brief Build the command links of a repeated register transfer
+     * 
+     * Address, register and PEC bytes are chained by pointer from the
+     * transaction itself, so a link never has to change after it is built.
+     * 
+     * @param prepared Transaction to build, must not move afterwards
+     * @param dev_addr I2C device address
+     * @param reg_addr Register address
+     * @param length Bytes per transfer
+     * @param read true to read into the buffers, false to write from them
+     * @param buffers Data buffers of at least length bytes, at most PreparedTransaction::MAX_BUFFERS
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for bad parameters, error code otherwise
+     */
+    esp_err_t I2c::Prepare(PreparedTransaction &prepared, uint8_t dev_addr, uint8_t reg_addr, size_t length, bool read,
+                           std::span<uint8_t *const> buffers){
+        if (dev_addr >= sizeof(_device_index) || length == 0 || buffers.empty() || buffers.size() > PreparedTransaction::MAX_BUFFERS){
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (uint8_t *buffer : buffers){
+            if (buffer == nullptr){
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+
+        for (size_t i = 0; i < prepared._buffer_count; i++){
+            i2c_cmd_link_delete_static(prepared._handles[i]);
+        }
+        prepared._buffer_count = 0;
+        prepared._dev_addr = dev_addr;
+        prepared._length = length;
+        prepared._read = read;
+        prepared._use_pec = _pecEnabled(dev_addr);
+        prepared._header[0] = (dev_addr << 1) | I2C_MASTER_WRITE;
+        prepared._header[1] = reg_addr;
+        prepared._read_addr = (dev_addr << 1) | I2C_MASTER_READ;
+        prepared._pec_seed = Crc::Smbus(prepared._header, sizeof(prepared._header));
+        if (read){
+            prepared._pec_seed = Crc::Smbus(&prepared._read_addr, 1, prepared._pec_seed);
+        }
+
+        esp_err_t status{ESP_OK};
+        size_t built{0};
+        for (; built < buffers.size() && status == ESP_OK; built++){
+            memset(prepared._link[built], 0, sizeof(prepared._link[built]));
+            i2c_cmd_handle_t handle = i2c_cmd_link_create_static(prepared._link[built], sizeof(prepared._link[built]));
+            prepared._handles[built] = handle;
+            prepared._buffers[built] = buffers[built];
+
+            status |= i2c_master_start(handle);
+            status |= i2c_master_write(handle, prepared._header, sizeof(prepared._header), true);
+            if (read){
+                status |= i2c_master_start(handle);
+                status |= i2c_master_write(handle, &prepared._read_addr, 1, true);
+                if (prepared._use_pec){
+                    status |= i2c_master_read(handle, buffers[built], length, I2C_MASTER_ACK);
+                    status |= i2c_master_read_byte(handle, &prepared._pec, I2C_MASTER_NACK);
+                } else {
+                    status |= i2c_master_read(handle, buffers[built], length, I2C_MASTER_LAST_NACK);
+                }
+            } else {
+                status |= i2c_master_write(handle, buffers[built], length, true);
+                if (prepared._use_pec){
+                    status |= i2c_master_write(handle, &prepared._pec, 1, true);
+                }
+            }
+            status |= i2c_master_stop(handle);
+        }
+
+        if (status != ESP_OK){
+            for (size_t i = 0; i < built; i++){
+                i2c_cmd_link_delete_static(prepared._handles[i]);
+            }
+            return status;
+        }
+        prepared._buffer_count = built;
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Run a prepared transfer
+     * 
+     * @param prepared Transaction built by Prepare()
+     * @param buffer Index of the bound buffer to transfer
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if not prepared, error code otherwise
+     */
+    esp_err_t I2c::Execute(PreparedTransaction &prepared, size_t buffer){
+        if (!prepared.IsPrepared()){
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (buffer >= prepared._buffer_count){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        uint8_t *data = prepared._buffers[buffer];
+        if (prepared._use_pec && !prepared._read){
+            prepared._pec = Crc::Smbus(data, prepared._length, prepared._pec_seed);
+        }
+        const int64_t start = Timebase::Now();
+        esp_err_t status = _run(prepared._dev_addr, prepared._handles[buffer]);
+        if (status == ESP_OK && prepared._use_pec && prepared._read &&
+            Crc::Smbus(data, prepared._length, prepared._pec_seed) != prepared._pec){
+            status = _crcFailure();
+        }
+
+        const std::span<const uint8_t> tx[2] {{&prepared._header[1], 1}, {data, prepared._length}};
+        const std::span<uint8_t> rx[1] {{data, prepared._length}};
+        Trace::RecordTransaction(_port, prepared._dev_addr, status, start, static_cast<uint32_t>(Timebase::Now() - start),
+                                 std::span(tx, prepared._read ? 1 : 2), std::span(rx, prepared._read ? 1 : 0));
+        return status;
+    }
+
+    /**
+     * @brief Set the transaction policy for a device
+     * 
+     * @param dev_addr I2C device address
+     * @param config Deadline and circuit breaker settings
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the device table is full
+     */
+    esp_err_t I2c::ConfigureDevice(uint8_t dev_addr, const DeviceConfig &config){
+        if (dev_addr >= sizeof(_device_index)){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        esp_err_t status{ESP_OK};
+        taskENTER_CRITICAL(&_stateMutex);
+        _device_state* device = _findDevice(dev_addr);
+        if (device == nullptr && _device_count < MAX_DEVICES){
+            _device_index[dev_addr] = _device_count;
+            device = &_devices[_device_count++];
+            device->addr = dev_addr;
+        }
+        if (device != nullptr){
+            device->config = config;
+        } else {
+            status = ESP_ERR_NO_MEM;
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        return status;
+    }
+
+    /**
+     * @brief Get the transaction policy of a device
+     * 
+     * @param dev_addr I2C device address
+     * @param config Output policy
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the device has no policy
+     */
+    esp_err_t I2c::GetDeviceConfig(uint8_t dev_addr, DeviceConfig &config){
+        esp_err_t status{ESP_ERR_NOT_FOUND};
+        taskENTER_CRITICAL(&_stateMutex);
+        const _device_state* device = _findDevice(dev_addr);
+        if (device != nullptr){
+            config = device->config;
+            status = ESP_OK;
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        return status;
+    }
+
+    /**
+     * @brief Check whether SDA or SCL is held low while the bus should be idle
+     * 
+     * @return true if a line is stuck low
+     */
+    bool I2c::IsBusStuck(void){
+        xSemaphoreTake(_bus_lock, portMAX_DELAY);
+        bool stuck = !_linesReleased();
+        xSemaphoreGive(_bus_lock);
+        return stuck;
+    }
+
+    /**
+     * @brief Release a stuck bus and reset the driver
+     * 
+     * @return esp_err_t ESP_OK if both lines are released afterwards, ESP_FAIL otherwise
+     */
+    esp_err_t I2c::RecoverBus(void){
+        _pmAcquire();
+        xSemaphoreTake(_bus_lock, portMAX_DELAY);
+        esp_err_t status = _recover();
+        xSemaphoreGive(_bus_lock);
+        _pmRelease();
+        return status;
+    }
+
+    /**
+     * @brief Check whether the circuit breaker currently isolates a device
+     * 
+     * @param dev_addr I2C device address
+     * @return true if transactions to the device are being refused
+     */
+    bool I2c::IsQuarantined(uint8_t dev_addr){
+        const int64_t now = esp_timer_get_time();
+        taskENTER_CRITICAL(&_stateMutex);
+        const _device_state* device = _findDevice(dev_addr);
+        bool quarantined = device != nullptr && device->quarantined_until_us > now;
+        taskEXIT_CRITICAL(&_stateMutex);
+        return quarantined;
+    }
+
+    /**
+     * @brief Get a copy of the bus health counters
+     * 
+     * @return I2cMetrics Current counter values
+     */
+    I2cMetrics I2c::GetMetrics(void){
+        taskENTER_CRITICAL(&_stateMutex);
+        I2cMetrics metrics = _metrics;
+        taskEXIT_CRITICAL(&_stateMutex);
+        return metrics;
+    }
+
+    /**
+     * @brief Run a list of register accesses, grouped by bus timing
+     * 
+     * Each pass runs every pending transaction whose device uses the timing of
+     * the pass and remembers the first other timing it sees for the next pass.
+     * Speed, sample and hold point all count, any difference reprograms the bus.
+     * Pending entries are marked with ESP_ERR_NOT_FINISHED so no extra storage
+     * is needed.
+     * 
+     * @param transactions Transactions to run
+     * @param count Number of transactions
+     * @return esp_err_t ESP_OK if every transaction succeeded, otherwise the first error
+     */
+    esp_err_t I2c::ExecuteBatch(Transaction *transactions, size_t count){
+        for (size_t i = 0; i < count; i++){
+            transactions[i].status = ESP_ERR_NOT_FINISHED;
+        }
+
+        // One lock across the batch keeps the APB clock up between transactions
+        _pmAcquire();
+        xSemaphoreTake(_bus_lock, portMAX_DELAY);
+        _bus_timing timing = _active_timing;
+        xSemaphoreGive(_bus_lock);
+
+        size_t remaining = count;
+        while (remaining > 0){
+            _bus_timing next_timing{};
+            bool next_found{false};
+            for (size_t i = 0; i < count; i++){
+                Transaction &transaction = transactions[i];
+                if (transaction.status != ESP_ERR_NOT_FINISHED){
+                    continue;
+                }
+                const _bus_timing device_timing = _timing(transaction.dev_addr);
+                if (device_timing != timing){
+                    if (!next_found){
+                        next_timing = device_timing;
+                        next_found = true;
+                    }
+                    continue;
+                }
+                if (transaction.read){
+                    transaction.status = ReadRegisterMultipleBytes(transaction.dev_addr, transaction.reg_addr, transaction.data, transaction.length);
+                } else {
+                    transaction.status = WriteRegisterMultipleBytes(transaction.dev_addr, transaction.reg_addr, transaction.data, transaction.length);
+                }
+                remaining--;
+            }
+            timing = next_timing;
+        }
+        _pmRelease();
+
+        for (size_t i = 0; i < count; i++){
+            if (transactions[i].status != ESP_OK){
+                return transactions[i].status;
+            }
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Find the highest SCL frequency a device handles reliably
+     * 
+     * The breaker is disabled while candidates are tried so that failing
+     * speeds do not quarantine the device. Each speed above the current one is
+     * tried with the default sample/hold points first, then with earlier and
+     * later points, and the search stops at the first speed where no setting
+     * passes. A device without a policy starts from the unconfigured
+     * behaviour, the default deadline and no breaker.
+     * 
+     * @param dev_addr I2C device address
+     * @param reg_addr First register of a block whose contents do not change
+     * @param length Number of bytes to compare, at most 16
+     * @param iterations Reads per speed and timing setting
+     * @param max_clk_speed Optional output for the speed that was selected
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the reference read fails
+     */
+    esp_err_t I2c::CalibrateDevice(uint8_t dev_addr, uint8_t reg_addr, size_t length, uint32_t iterations, uint32_t *max_clk_speed){
+        static constexpr uint32_t speeds[] = {100000, 200000, 400000, 600000, 800000, MAX_CLK_SPEED};
+        // Sample and hold points in quarters of the half SCL period
+        static constexpr uint8_t timing_quarters[][2] = {{2, 2}, {1, 1}, {3, 1}, {1, 3}};
+
+        uint8_t reference[16];
+        uint8_t sample[16];
+        if (length == 0 || length > sizeof(reference)){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (ReadRegisterMultipleBytes(dev_addr, reg_addr, reference, length) != ESP_OK){
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        // Candidate speeds are compared at a fixed APB clock
+        _pmAcquire();
+        DeviceConfig best{};
+        best.timeout_ms = DEFAULT_TIMEOUT_MS;
+        best.breaker_threshold = 0;
+        taskENTER_CRITICAL(&_stateMutex);
+        const _device_state* device = _findDevice(dev_addr);
+        if (device != nullptr){
+            best = device->config;
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        if (best.clk_speed == 0){
+            best.clk_speed = _config.master.clk_speed;
+        }
+
+        esp_err_t status{ESP_OK};
+        DeviceConfig candidate = best;
+        candidate.breaker_threshold = 0;
+
+        for (const uint32_t speed : speeds){
+            if (speed <= best.clk_speed){
+                continue;
+            }
+
+            bool passed{false};
+            const uint16_t half_cycle = esp_clk_apb_freq() / speed / 2;
+            for (const auto &quarters : timing_quarters){
+                candidate.clk_speed = speed;
+                candidate.sda_sample_cycles = half_cycle * quarters[0] / 4;
+                candidate.sda_hold_cycles = half_cycle * quarters[1] / 4;
+                status = ConfigureDevice(dev_addr, candidate);
+                if (status != ESP_OK){
+                    _pmRelease();
+                    return status;
+                }
+
+                passed = true;
+                for (uint32_t i = 0; i < iterations && passed; i++){
+                    passed = ReadRegisterMultipleBytes(dev_addr, reg_addr, sample, length) == ESP_OK
+                        && memcmp(sample, reference, length) == 0;
+                }
+                if (passed){
+                    best.clk_speed = candidate.clk_speed;
+                    best.sda_sample_cycles = candidate.sda_sample_cycles;
+                    best.sda_hold_cycles = candidate.sda_hold_cycles;
+                    break;
+                }
+            }
+            if (!passed){
+                break;
+            }
+        }
+
+        _pmRelease();
+        status = ConfigureDevice(dev_addr, best);
+
+        // Failures of rejected candidates must not keep the breaker armed
+        if (status == ESP_OK){
+            taskENTER_CRITICAL(&_stateMutex);
+            _device_state* calibrated = _findDevice(dev_addr);
+            if (calibrated != nullptr){
+                calibrated->consecutive_failures = 0;
+                calibrated->quarantine_count = 0;
+                calibrated->quarantined_until_us = 0;
+            }
+            taskEXIT_CRITICAL(&_stateMutex);
+        }
+        if (max_clk_speed != nullptr){
+            *max_clk_speed = best.clk_speed;
+        }
+        return status;
+    }
+
+    /**
+     * @brief Look up the state of a configured device
+     * 
+     * @param dev_addr I2C device address
+     * @return _device_state* Device state, or nullptr if the device has no policy
+     */
+    I2c::_device_state* I2c::_findDevice(uint8_t dev_addr){
+        if (dev_addr >= sizeof(_device_index) || _device_index[dev_addr] == NO_DEVICE){
+            return nullptr;
+        }
+        return &_devices[_device_index[dev_addr]];
+    }
+
+    /**
+     * @brief Sample SDA and SCL to see whether the bus is idle
+     * 
+     * Both lines must read high at least once within a few microseconds.
+     * A line that stays low across all samples is held by a slave or shorted.
+     * The caller must hold the bus lock so no transaction is in progress.
+     * 
+     * @return true if both lines are high
+     */
+    bool I2c::_linesReleased(void){
+        const gpio_num_t sda = static_cast<gpio_num_t>(_config.sda_io_num);
+        const gpio_num_t scl = static_cast<gpio_num_t>(_config.scl_io_num);
+        for (int sample = 0; sample < 4; sample++){
+            if (gpio_get_level(sda) && gpio_get_level(scl)){
+                return true;
+            }
+            esp_rom_delay_us(2);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Run the bus recovery sequence
+     * 
+     * Detaches the pins from the controller, clocks SCL up to nine times until SDA
+     * is released, generates a STOP condition and reinstalls the driver.
+     * Only a line sampled low beforehand counts as a stuck bus detection.
+     * The caller must hold the bus lock.
+     * 
+     * @return esp_err_t ESP_OK if both lines are released afterwards, ESP_FAIL otherwise
+     */
+    esp_err_t I2c::_recover(void){
+        const int64_t start = esp_timer_get_time();
+        const gpio_num_t sda = static_cast<gpio_num_t>(_config.sda_io_num);
+        const gpio_num_t scl = static_cast<gpio_num_t>(_config.scl_io_num);
+        esp_err_t status{ESP_OK};
+        const bool stuck = !_linesReleased();
+
+        i2c_driver_delete(_port);
+
+        gpio_config_t cfg{};
+        cfg.pin_bit_mask = (1ULL << sda) | (1ULL << scl);
+        cfg.mode = GPIO_MODE_INPUT_OUTPUT_OD;
+        cfg.pull_up_en = GPIO_PULLUP_DISABLE;
+        cfg.pull_down_en = GPIO_PULLDOWN_DISABLE;
+        cfg.intr_type = GPIO_INTR_DISABLE;
+        gpio_config(&cfg);
+        gpio_set_pull_mode(sda, _config.sda_pullup_en ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+        gpio_set_pull_mode(scl, _config.scl_pullup_en ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+        gpio_set_level(sda, 1);
+        gpio_set_level(scl, 1);
+        esp_rom_delay_us(5);
+
+        for (int clock = 0; clock < 9 && !gpio_get_level(sda); clock++){
+            gpio_set_level(scl, 0);
+            esp_rom_delay_us(5);
+            gpio_set_level(scl, 1);
+            esp_rom_delay_us(5);
+        }
+
+        gpio_set_level(scl, 0);
+        esp_rom_delay_us(5);
+        gpio_set_level(sda, 0);
+        esp_rom_delay_us(5);
+        gpio_set_level(scl, 1);
+        esp_rom_delay_us(5);
+        gpio_set_level(sda, 1);
+        esp_rom_delay_us(5);
+
+        const bool released = _linesReleased();
+
+        status |= i2c_param_config(_port, &_config);
+        status |= i2c_driver_install(_port, _mode, _slv_rx_buf_len, _slv_tx_buf_len, _intr_alloc_flags);
+        _active_timing = {_config.master.clk_speed, 0, 0};
+        if (!released){
+            status = ESP_FAIL;
+        }
+
+        const uint32_t elapsed = static_cast<uint32_t>(esp_timer_get_time() - start);
+        taskENTER_CRITICAL(&_stateMutex);
+        if (stuck){
+            _metrics.stuck_bus_detections++;
+        }
+        if (status == ESP_OK){
+            _metrics.recoveries++;
+        } else {
+            _metrics.recovery_failures++;
+        }
+        _metrics.recovery_time_us += elapsed;
+        if (elapsed > _metrics.recovery_time_max_us){
+            _metrics.recovery_time_max_us = elapsed;
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        return status;
+    }
+
+    /**
+     * @brief Circuit breaker check before a transaction
+     * 
+     * @param dev_addr I2C device address
+     * @return esp_err_t ESP_OK if the transaction may proceed, ESP_ERR_INVALID_STATE while quarantined
+     */
+    esp_err_t I2c::_admit(uint8_t dev_addr){
+        esp_err_t status{ESP_OK};
+        const int64_t now = esp_timer_get_time();
+        taskENTER_CRITICAL(&_stateMutex);
+        const _device_state* device = _findDevice(dev_addr);
+        if (device != nullptr && device->quarantined_until_us > now){
+            _metrics.quarantine_rejections++;
+            status = ESP_ERR_INVALID_STATE;
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        return status;
+    }
+
+    /**
+     * @brief Record the outcome of a transaction
+     * 
+     * Updates the bus counters and the device circuit breaker. After
+     * breaker_threshold consecutive failures the device is quarantined for
+     * backoff_base_ms, doubling on every further quarantine up to backoff_max_ms.
+     * A single success closes the breaker again, a threshold of 0 never opens it.
+     * 
+     * @param dev_addr I2C device address
+     * @param status Result of the transaction
+     */
+    void I2c::_complete(uint8_t dev_addr, esp_err_t status){
+        const int64_t now = esp_timer_get_time();
+        taskENTER_CRITICAL(&_stateMutex);
+        _metrics.transactions++;
+        if (status != ESP_OK){
+            _metrics.errors++;
+        }
+        if (status == ESP_ERR_TIMEOUT){
+            _metrics.timeouts++;
+        }
+
+        _device_state* device = _findDevice(dev_addr);
+        if (device != nullptr){
+            if (status == ESP_OK){
+                device->consecutive_failures = 0;
+                device->quarantine_count = 0;
+            } else if (device->config.breaker_threshold != 0
+                       && ++device->consecutive_failures >= device->config.breaker_threshold){
+                const uint8_t shift = device->quarantine_count < 16 ? device->quarantine_count : 16;
+                uint64_t backoff_ms = static_cast<uint64_t>(device->config.backoff_base_ms) << shift;
+                if (backoff_ms > device->config.backoff_max_ms){
+                    backoff_ms = device->config.backoff_max_ms;
+                }
+                device->quarantined_until_us = now + static_cast<int64_t>(backoff_ms) * 1000;
+                device->consecutive_failures = 0;
+                if (device->quarantine_count < UINT8_MAX){
+                    device->quarantine_count++;
+                }
+                _metrics.quarantines++;
+            }
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+    }
+
+    /**
+     * @brief Get the transaction deadline for a device
+     * 
+     * @param dev_addr I2C device address
+     * @return TickType_t Timeout in ticks, at least one tick
+     */
+    TickType_t I2c::_deadline(uint8_t dev_addr){
+        uint32_t timeout_ms = DEFAULT_TIMEOUT_MS;
+        taskENTER_CRITICAL(&_stateMutex);
+        const _device_state* device = _findDevice(dev_addr);
+        if (device != nullptr){
+            timeout_ms = device->config.timeout_ms;
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        const TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+        return ticks > 0 ? ticks : 1;
+    }
+
+    /**
+     * @brief Get the bus timing a device needs
+     * 
+     * @param dev_addr I2C device address
+     * @return _bus_timing Device timing, or the port speed if the device has none
+     */
+    I2c::_bus_timing I2c::_timing(uint8_t dev_addr){
+        _bus_timing timing{_config.master.clk_speed, 0, 0};
+        taskENTER_CRITICAL(&_stateMutex);
+        const _device_state* device = _findDevice(dev_addr);
+        if (device != nullptr && device->config.clk_speed != 0){
+            timing = {device->config.clk_speed, device->config.sda_sample_cycles, device->config.sda_hold_cycles};
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        return timing;
+    }
+
+    /**
+     * @brief Check whether a device uses SMBus packet error checking
+     * 
+     * @param dev_addr I2C device address
+     * @return true if transactions carry a PEC byte
+     */
+    bool I2c::_pecEnabled(uint8_t dev_addr){
+        bool pec{false};
+        taskENTER_CRITICAL(&_stateMutex);
+        const _device_state* device = _findDevice(dev_addr);
+        if (device != nullptr){
+            pec = device->config.pec;
+        }
+        taskEXIT_CRITICAL(&_stateMutex);
+        return pec;
+    }
+
+    /**
+     * @brief Count a checksum mismatch
+     * 
+     * @return esp_err_t ESP_ERR_INVALID_CRC
+     */
+    esp_err_t I2c::_crcFailure(void){
+        taskENTER_CRITICAL(&_stateMutex);
+        _metrics.crc_errors++;
+        taskEXIT_CRITICAL(&_stateMutex);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    /**
+     * @brief Take a command link buffer from this port's pool
+     * 
+     * The buffer is not cleared, i2c_cmd_link_create_static() resets the
+     * link header and every appended command is written in full.
+     * 
+     * @param size Output for the buffer size
+     * @return uint8_t* Buffer, or nullptr if the pool stayed exhausted
+     */
+    uint8_t* I2c::_acquireLink(size_t &size){
+        LinkBlock *block = link_pools[_port].Acquire(POOL_WAIT);
+        if (block == nullptr){
+            return nullptr;
+        }
+        size = sizeof(block->buffer);
+        return block->buffer;
+    }
+
+    /**
+     * @brief Return a buffer obtained from _acquireLink()
+     * 
+     * @param link Buffer to release
+     */
+    void I2c::_releaseLink(uint8_t *link){
+        link_pools[_port].Release(reinterpret_cast<LinkBlock*>(link));
+    }
+
+    /**
+     * @brief Keep the APB clock at its maximum while an operation is pending
+     * 
+     * The lock counts nested holds, so an operation made of several
+     * transactions keeps the clock up between them. Does nothing unless
+     * CONFIG_I2C_PM_LOCK is enabled.
+     */
+    void I2c::_pmAcquire(void){
+#ifdef CONFIG_I2C_PM_LOCK
+        if (_pm_lock != nullptr){
+            esp_pm_lock_acquire(_pm_lock);
+        }
+#endif
+    }
+
+    /**
+     * @brief Release one hold taken by _pmAcquire()
+     */
+    void I2c::_pmRelease(void){
+#ifdef CONFIG_I2C_PM_LOCK
+        if (_pm_lock != nullptr){
+            esp_pm_lock_release(_pm_lock);
+        }
+#endif
+    }
+
+    /**
+     * @brief Reprogram the SCL timing if it differs from the active one
+     * 
+     * Uses the same split of the SCL period as the driver does in
+     * i2c_param_config(). The caller must hold the bus lock.
+     * 
+     * @param timing Timing the next transaction needs
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t I2c::_applyTiming(const _bus_timing &timing){
+        if (timing == _active_timing || timing.clk_speed == 0){
+            return ESP_OK;
+        }
+
+        esp_err_t status{ESP_OK};
+        const int half_cycle = esp_clk_apb_freq() / timing.clk_speed / 2;
+        status |= i2c_set_period(_port, half_cycle, half_cycle);
+        status |= i2c_set_start_timing(_port, half_cycle, half_cycle);
+        status |= i2c_set_stop_timing(_port, half_cycle, half_cycle);
+        status |= i2c_set_data_timing(_port,
+                                      timing.sda_sample ? timing.sda_sample : half_cycle / 2,
+                                      timing.sda_hold ? timing.sda_hold : half_cycle / 2);
+        status |= i2c_set_timeout(_port, half_cycle * 20);
+
+        if (status == ESP_OK){
+            _active_timing = timing;
+            taskENTER_CRITICAL(&_stateMutex);
+            _metrics.speed_switches++;
+            taskEXIT_CRITICAL(&_stateMutex);
+        }
+        return status;
+    }
+
+    /**
+     * @brief Execute a command link with fault handling
+     * 
+     * Refuses quarantined devices, recovers a stuck bus before starting and
+     * again if the transaction times out with a line held low, switches the
+     * bus timing when the device runs at a different speed than the previous
+     * one, and feeds the result into the circuit breaker.
+     * 
+     * @param dev_addr I2C device address the link talks to
+     * @param handle Fully built command link
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t I2c::_run(uint8_t dev_addr, i2c_cmd_handle_t handle){
+        esp_err_t status = _admit(dev_addr);
+        if (status != ESP_OK){
+            return status;
+        }
+
+        const int64_t start = esp_timer_get_time();
+        const TickType_t deadline = _deadline(dev_addr);
+        const _bus_timing timing = _timing(dev_addr);
+        _pmAcquire();
+        xSemaphoreTake(_bus_lock, portMAX_DELAY);
+        if (!_linesReleased()){
+            status = _recover();
+        }
+        if (status == ESP_OK){
+            status = _applyTiming(timing);
+        }
+        if (status == ESP_OK){
+            status = i2c_master_cmd_begin(_port, handle, deadline);
+            if (status == ESP_ERR_TIMEOUT && !_linesReleased()){
+                _recover();
+            }
+        }
+        xSemaphoreGive(_bus_lock);
+        _pmRelease();
+
+        _complete(dev_addr, status);
+        Metrics::RecordTransaction(_port, dev_addr, status, static_cast<uint32_t>(esp_timer_get_time() - start));
+        return status;
+    }
+
+    /**
+     * @brief Run a write or write-then-read transaction with fault handling
+     * 
+     * @param dev_addr I2C device address
+     * @param tx_data Bytes to write
+     * @param tx_length Number of bytes to write
+     * @param rx_data Buffer for the read phase, nullptr for write-only transactions
+     * @param rx_length Number of bytes to read
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_CRC on a PEC mismatch, error code otherwise
+     */
+    esp_err_t I2c::_transfer(uint8_t dev_addr, const uint8_t *tx_data, size_t tx_length, uint8_t *rx_data, size_t rx_length){
+        const std::span<const uint8_t> tx[1] {{tx_data, tx_length}};
+        const std::span<uint8_t> rx[1] {{rx_data, rx_length}};
+        return _transfer(dev_addr, tx, std::span(rx, rx_length > 0 ? 1 : 0));
+    }
+
+    /**
+     * @brief Run a scatter-gather transaction with fault handling
+     * 
+     * The command link is built in a buffer from the port's pool. Every
+     * segment is chained into it directly. Empty segments
+     * are skipped, and without write segments a read starts straight with
+     * the read address. For devices with PEC enabled, a PEC byte covering every
+     * address and data byte of the transaction is appended to writes, and
+     * read back and checked after the data of reads.
+     * 
+     * @param dev_addr I2C device address
+     * @param tx Segments to write
+     * @param rx Segments to read into, empty for write-only transactions
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_CRC on a PEC mismatch,
+     *         ESP_ERR_NO_MEM if no link buffer became free, error code otherwise
+     */
+    esp_err_t I2c::_transfer(uint8_t dev_addr, std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx){
+        size_t link_size{};
+        uint8_t *link = _acquireLink(link_size);
+        if (link == nullptr){
+            return ESP_ERR_NO_MEM;
+        }
+
         esp_err_t status{ESP_OK};
-        uint8_t buffer[I2C_LINK_RECOMMENDED_SIZE(3)] = { 0 };
-        i2c_cmd_handle_t _handle = i2c_cmd_link_create_static(buffer, sizeof(buffer));
-        
-        status |= i2c_master_start(_handle);
-        status |= i2c_master_write_byte(_handle, (dev_addr << 1) | I2C_MASTER_WRITE, true);
-        status |= i2c_master_write_byte(_handle, reg_addr, true);
-        status |= i2c_master_write(_handle, tx_data, length, true);
+        i2c_cmd_handle_t _handle = i2c_cmd_link_create_static(link, link_size);
+        const bool pec = _pecEnabled(dev_addr);
+        const uint8_t write_addr = (dev_addr << 1) | I2C_MASTER_WRITE;
+        const uint8_t read_addr = (dev_addr << 1) | I2C_MASTER_READ;
+        uint8_t pec_byte{};
+
+        size_t last_rx{rx.size()};
+        for (size_t i = 0; i < rx.size(); i++){
+            if (!rx[i].empty()){
+                last_rx = i;
+            }
+        }
+
+        // A pure read skips the write phase and starts with the read address
+        const bool write_phase = !tx.empty() || last_rx == rx.size();
+        if (write_phase){
+            status |= i2c_master_start(_handle);
+            status |= i2c_master_write_byte(_handle, write_addr, true);
+            for (const auto &segment : tx){
+                if (!segment.empty()){
+                    status |= i2c_master_write(_handle, segment.data(), segment.size(), true);
+                }
+            }
+        }
+        if (last_rx < rx.size()){
+            status |= i2c_master_start(_handle);
+            status |= i2c_master_write_byte(_handle, read_addr, true);
+            for (size_t i = 0; i <= last_rx; i++){
+                if (!rx[i].empty()){
+                    const i2c_ack_type_t ack = (i == last_rx && !pec) ? I2C_MASTER_LAST_NACK : I2C_MASTER_ACK;
+                    status |= i2c_master_read(_handle, rx[i].data(), rx[i].size(), ack);
+                }
+            }
+            if (pec){
+                status |= i2c_master_read_byte(_handle, &pec_byte, I2C_MASTER_NACK);
+            }
+        } else if (pec){
+            uint8_t crc = Crc::Smbus(&write_addr, 1);
+            for (const auto &segment : tx){
+                crc = Crc::Smbus(segment.data(), segment.size(), crc);
+            }
+            status |= i2c_master_write_byte(_handle, crc, true);
+        }
         status |= i2c_master_stop(_handle);
-        status |= i2c_master_cmd_begin(_port, _handle, pdMS_TO_TICKS(1000));
+        const int64_t start = Timebase::Now();
+        if (status == ESP_OK){
+            status = _run(dev_addr, _handle);
+        }
         i2c_cmd_link_delete_static(_handle);
+        _releaseLink(link);
+
+        if (status == ESP_OK && pec && last_rx < rx.size()){
+            uint8_t expected = write_phase ? Crc::Smbus(&write_addr, 1) : Crc::SMBUS_INIT;
+            for (const auto &segment : tx){
+                expected = Crc::Smbus(segment.data(), segment.size(), expected);
+            }
+            expected = Crc::Smbus(&read_addr, 1, expected);
+            for (const auto &segment : rx){
+                expected = Crc::Smbus(segment.data(), segment.size(), expected);
+            }
+            if (expected != pec_byte){
+                status = _crcFailure();
+            }
+        }
+        Trace::RecordTransaction(_port, dev_addr, status, start, static_cast<uint32_t>(Timebase::Now() - start), tx, rx);
         return status;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,281 @@
+#include "i2c_alert.h"
+
+namespace I2C {
+    /**
+     * @brief Construct a router for an initialized master bus
+     * 
+     * @param bus Bus the devices are on
+     * @param alert_pin GPIO of the shared active-low alert line
+     */
+    AlertRouter::AlertRouter(I2c &bus, gpio_num_t alert_pin)
+        : _bus(bus), _alert(alert_pin, true){
+        _queue = xQueueCreateStatic(QUEUE_LENGTH, sizeof(int32_t), _queue_storage, &_queue_buffer);
+        _stopped = xSemaphoreCreateBinaryStatic(&_stopped_buffer);
+    }
+
+    /**
+     * @brief Stop the router task and release the alert interrupt
+     */
+    AlertRouter::~AlertRouter(){
+        Stop();
+    }
+
+    /**
+     * @brief Add a device identified by an Alert Response Address read
+     * 
+     * @param dev_addr 7-bit device address
+     * @param handler Handler run when the device answers the ARA read
+     * @param context Handler argument
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad address or handler,
+     *         ESP_ERR_NO_MEM if MAX_ROUTES devices are registered, ESP_ERR_INVALID_STATE if running
+     */
+    esp_err_t AlertRouter::AddDevice(uint8_t dev_addr, AlertHandler handler, void *context){
+        return _addRoute({dev_addr, true, 0, 0, handler, context});
+    }
+
+    /**
+     * @brief Add a device identified by reading its status register
+     * 
+     * @param dev_addr 7-bit device address
+     * @param status_reg Register read to check the device
+     * @param status_mask Bits that signal an alert, the handler runs if any is set
+     * @param handler Handler run with the register value
+     * @param context Handler argument
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad address, mask or handler,
+     *         ESP_ERR_NO_MEM if MAX_ROUTES devices are registered, ESP_ERR_INVALID_STATE if running
+     */
+    esp_err_t AlertRouter::AddDevice(uint8_t dev_addr, uint8_t status_reg, uint8_t status_mask, AlertHandler handler, void *context){
+        if (status_mask == 0){
+            return ESP_ERR_INVALID_ARG;
+        }
+        return _addRoute({dev_addr, false, status_reg, status_mask, handler, context});
+    }
+
+    /**
+     * @brief Enable the alert interrupt and start the router task
+     * 
+     * The line is armed on its falling edge. An open-drain line needs a
+     * pull-up, the internal one is enabled in case the board has none.
+     * 
+     * @param priority FreeRTOS priority of the router task, device handlers run at it
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if already running,
+     *         ESP_ERR_NO_MEM if the task could not be created, error code otherwise
+     */
+    esp_err_t AlertRouter::Start(UBaseType_t priority){
+        if (_task != nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        xQueueReset(_queue);
+        _alert.setQueueHandle(_queue);
+        esp_err_t status = _alert.enablePullup();
+        if (status == ESP_OK){
+            // Active low, so the assertion of the line is its falling edge
+            status = _alert.enableInterrupt(GPIO_INTR_POSEDGE);
+        }
+        if (status != ESP_OK){
+            return status;
+        }
+
+        if (xTaskCreate(_routerTask, "i2c_alert", 3072, this, priority, &_task) != pdPASS){
+            _task = nullptr;
+            _alert.disableInterrupt();
+            return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Disable the alert interrupt and stop the router task
+     * 
+     * The task is asked to exit instead of being deleted so it never dies
+     * while holding the bus lock or inside a handler.
+     */
+    void AlertRouter::Stop(void){
+        if (_task == nullptr){
+            return;
+        }
+        _alert.disableInterrupt();
+        const int32_t stop = STOP_SIGNAL;
+        xQueueSend(_queue, &stop, portMAX_DELAY);
+        xSemaphoreTake(_stopped, portMAX_DELAY);
+        _task = nullptr;
+    }
+
+    /**
+     * @brief Find the device behind the alert and run its handler
+     * 
+     * ARA devices are asked first, a device that answers releases its alert
+     * output. When none answers, the status registers are read in the order
+     * the devices were added. Rounds repeat while the line stays low so
+     * alerts raised during servicing are not lost.
+     * 
+     * @return esp_err_t ESP_OK if a device claimed the alert, ESP_ERR_NOT_FOUND otherwise
+     */
+    esp_err_t AlertRouter::Service(void){
+        AlertStats stats{};
+        bool claimed{false};
+
+        for (uint8_t round = 0; round < MAX_ROUNDS; round++){
+            uint8_t status{};
+            const _route *route = _serviceAra(status, stats);
+            if (route == nullptr){
+                route = _serviceStatus(status, stats);
+            }
+            if (route == nullptr){
+                stats.unclaimed++;
+                break;
+            }
+
+            route->handler(route->dev_addr, status, route->context);
+            stats.serviced++;
+            claimed = true;
+
+            if (!_alert.read()){
+                break;
+            }
+        }
+
+        taskENTER_CRITICAL(&_mutex);
+        _stats.serviced += stats.serviced;
+        _stats.ara_reads += stats.ara_reads;
+        _stats.status_reads += stats.status_reads;
+        _stats.unclaimed += stats.unclaimed;
+        taskEXIT_CRITICAL(&_mutex);
+
+        return claimed ? ESP_OK : ESP_ERR_NOT_FOUND;
+    }
+
+    /**
+     * @brief Get the router counters
+     * 
+     * @return AlertStats Counters since construction
+     */
+    AlertStats AlertRouter::GetStats(void){
+        taskENTER_CRITICAL(&_mutex);
+        const AlertStats stats = _stats;
+        taskEXIT_CRITICAL(&_mutex);
+        return stats;
+    }
+
+    /**
+     * @brief Router task, sleeps on the edge queue until notified to stop
+     * 
+     * Edges that queued up while servicing are drained first so one burst
+     * causes one service pass. A line held low by no known device is
+     * retried every RETRY_MS instead of waiting for an edge that never comes.
+     * 
+     * @param arg Pointer to the AlertRouter
+     */
+    void AlertRouter::_routerTask(void *arg){
+        auto* router = static_cast<AlertRouter*>(arg);
+        const TickType_t retry = pdMS_TO_TICKS(RETRY_MS) > 0 ? pdMS_TO_TICKS(RETRY_MS) : 1;
+        bool running{true};
+
+        while (running){
+            const TickType_t wait = router->_alert.read() ? retry : portMAX_DELAY;
+            uint32_t edges{};
+            int32_t item{};
+            if (xQueueReceive(router->_queue, &item, wait) == pdTRUE){
+                do {
+                    if (item == STOP_SIGNAL){
+                        running = false;
+                    } else {
+                        edges++;
+                    }
+                } while (xQueueReceive(router->_queue, &item, 0) == pdTRUE);
+            }
+
+            if (edges > 0){
+                taskENTER_CRITICAL(&router->_mutex);
+                router->_stats.interrupts += edges;
+                taskEXIT_CRITICAL(&router->_mutex);
+            }
+            // Pulsed INT outputs may already be released, so an edge is serviced regardless of the level
+            if (running && (edges > 0 || router->_alert.read())){
+                router->Service();
+            }
+        }
+
+        xSemaphoreGive(router->_stopped);
+        vTaskDelete(nullptr);
+    }
+
+    /**
+     * @brief Register a device
+     * 
+     * @param route Device to add
+     * @return esp_err_t ESP_OK on success, error code otherwise
+     */
+    esp_err_t AlertRouter::_addRoute(const _route &route){
+        if (_task != nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (route.dev_addr > 0x7F || route.dev_addr == ALERT_RESPONSE_ADDR || route.handler == nullptr){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (_route_count >= MAX_ROUTES){
+            return ESP_ERR_NO_MEM;
+        }
+
+        _routes[_route_count++] = route;
+        _has_ara |= route.ara;
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Identify the alerting device with an Alert Response Address read
+     * 
+     * The device with the lowest address wins arbitration and answers with
+     * its address in the upper seven bits.
+     * 
+     * @param status Set to the raw response byte
+     * @param stats Counters of the current service pass
+     * @return const _route* Device that answered, nullptr if none of the registered ARA devices did
+     */
+    const AlertRouter::_route *AlertRouter::_serviceAra(uint8_t &status, AlertStats &stats){
+        if (!_has_ara){
+            return nullptr;
+        }
+
+        uint8_t response{};
+        stats.ara_reads++;
+        if (_bus.Read(ALERT_RESPONSE_ADDR, std::span<uint8_t>(&response, 1)) != ESP_OK){
+            return nullptr;
+        }
+
+        const uint8_t dev_addr = response >> 1;
+        for (size_t i = 0; i < _route_count; i++){
+            if (_routes[i].ara && _routes[i].dev_addr == dev_addr){
+                status = response;
+                return &_routes[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Identify the alerting device by reading status registers
+     * 
+     * @param status Set to the status register value of the device found
+     * @param stats Counters of the current service pass
+     * @return const _route* First device with an alert bit set, nullptr if none
+     */
+    const AlertRouter::_route *AlertRouter::_serviceStatus(uint8_t &status, AlertStats &stats){
+        for (size_t i = 0; i < _route_count; i++){
+            const _route &route = _routes[i];
+            if (route.ara){
+                continue;
+            }
+
+            uint8_t value{};
+            stats.status_reads++;
+            if (_bus.ReadRegisterMultipleBytes(route.dev_addr, route.status_reg, std::span<uint8_t>(&value, 1)) == ESP_OK
+                && (value & route.status_mask) != 0){
+                status = value;
+                return &route;
+            }
+        }
+        return nullptr;
+    }
+}
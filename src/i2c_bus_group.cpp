@@ -0,0 +1,326 @@
+#include "i2c_bus_group.h"
+#include <cstring>
+#include "esp_timer.h"
+
+namespace I2C {
+    /**
+     * @brief Construct a group over two initialized master ports
+     * 
+     * @param first Bus on the first controller
+     * @param second Bus on the second controller
+     */
+    I2cBusGroup::I2cBusGroup(I2c &first, I2c &second){
+        I2c *buses[PORTS] = {&first, &second};
+        for (size_t i = 0; i < PORTS; i++){
+            _ports[i].group = this;
+            _ports[i].bus = buses[i];
+            _ports[i].index = i;
+            _ports[i].queue = xQueueCreateStatic(QUEUE_LENGTH, sizeof(_job), _ports[i].queue_storage, &_ports[i].queue_buffer);
+            _ports[i].stopped = xSemaphoreCreateBinaryStatic(&_ports[i].stopped_buffer);
+        }
+        memset(_placement, 0, sizeof(_placement));
+        _window_start_us = esp_timer_get_time();
+    }
+
+    /**
+     * @brief Stop the port workers
+     * 
+     * Submit() must not be in progress when the group is destroyed.
+     */
+    I2cBusGroup::~I2cBusGroup(){
+        Stop();
+    }
+
+    /**
+     * @brief Stop the port workers, waiting for the jobs already queued
+     * 
+     * Workers are asked to exit with a job behind the queued ones instead of
+     * being deleted, so none dies in a transaction holding the bus lock.
+     */
+    void I2cBusGroup::Stop(void){
+        const _job stop{nullptr, 0, nullptr, nullptr};
+        for (_port &port : _ports){
+            if (port.task != nullptr){
+                xQueueSend(port.queue, &stop, portMAX_DELAY);
+            }
+        }
+        for (_port &port : _ports){
+            if (port.task != nullptr){
+                xSemaphoreTake(port.stopped, portMAX_DELAY);
+                port.task = nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Start one worker per port, pinned to core 0 and core 1
+     * 
+     * @param priority FreeRTOS priority of the workers
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if a worker could not be created
+     */
+    esp_err_t I2cBusGroup::Start(UBaseType_t priority){
+        static const char* names[PORTS] = {"i2c_port0", "i2c_port1"};
+        for (size_t i = 0; i < PORTS; i++){
+            if (_ports[i].task != nullptr){
+                continue;
+            }
+            if (xTaskCreatePinnedToCore(_worker, names[i], 4096, &_ports[i], priority, &_ports[i].task, i) != pdPASS){
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Assign a device to a port
+     * 
+     * @param dev_addr I2C device address
+     * @param port Port index, 0 or 1
+     * @param mirrored true if the device is wired to both buses and may be moved by Rebalance()
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad address or port
+     */
+    esp_err_t I2cBusGroup::AssignDevice(uint8_t dev_addr, uint8_t port, bool mirrored){
+        if (dev_addr >= sizeof(_placement) || port >= PORTS){
+            return ESP_ERR_INVALID_ARG;
+        }
+        taskENTER_CRITICAL(&_statsMutex);
+        _placement[dev_addr] = port;
+        _mirrored[dev_addr] = mirrored;
+        taskEXIT_CRITICAL(&_statsMutex);
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Run transactions on both ports concurrently
+     * 
+     * The placement is copied once so both workers agree on the route of
+     * every transaction even if a rebalance happens meanwhile.
+     * 
+     * @param transactions Transactions to run, each status is filled in
+     * @param count Number of transactions
+     * @return esp_err_t ESP_OK if every transaction succeeded, ESP_ERR_INVALID_STATE if a port the
+     *         transactions route to has no worker, otherwise the first error
+     */
+    esp_err_t I2cBusGroup::Submit(Transaction *transactions, size_t count){
+        uint8_t routes[sizeof(_placement)];
+        taskENTER_CRITICAL(&_statsMutex);
+        memcpy(routes, _placement, sizeof(routes));
+        taskEXIT_CRITICAL(&_statsMutex);
+
+        bool used[PORTS]{};
+        for (size_t i = 0; i < count; i++){
+            used[routes[transactions[i].dev_addr & 0x7F]] = true;
+        }
+        for (size_t i = 0; i < PORTS; i++){
+            if (used[i] && _ports[i].task == nullptr){
+                return ESP_ERR_INVALID_STATE;
+            }
+        }
+        for (size_t i = 0; i < count; i++){
+            transactions[i].status = ESP_ERR_NOT_FINISHED;
+        }
+
+        StaticSemaphore_t done_buffer;
+        SemaphoreHandle_t done = xSemaphoreCreateCountingStatic(PORTS, 0, &done_buffer);
+        const _job job{transactions, count, routes, done};
+
+        size_t dispatched{0};
+        for (size_t i = 0; i < PORTS; i++){
+            if (used[i]){
+                xQueueSend(_ports[i].queue, &job, portMAX_DELAY);
+                dispatched++;
+            }
+        }
+        for (size_t i = 0; i < dispatched; i++){
+            xSemaphoreTake(done, portMAX_DELAY);
+        }
+
+        for (size_t i = 0; i < count; i++){
+            if (transactions[i].status != ESP_OK){
+                return transactions[i].status;
+            }
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Get the load counters of a port
+     * 
+     * @param port Port index, 0 or 1
+     * @return PortStats Counters and utilization since the last reset
+     */
+    PortStats I2cBusGroup::GetPortStats(uint8_t port){
+        PortStats stats{};
+        if (port >= PORTS){
+            return stats;
+        }
+        const int64_t now = esp_timer_get_time();
+        taskENTER_CRITICAL(&_statsMutex);
+        stats = _ports[port].stats;
+        stats.window_us = now - _window_start_us;
+        taskEXIT_CRITICAL(&_statsMutex);
+        stats.utilization = stats.window_us > 0 ? static_cast<float>(stats.busy_us) / stats.window_us : 0.0f;
+        return stats;
+    }
+
+    /**
+     * @brief Start a new statistics window
+     */
+    void I2cBusGroup::ResetStats(void){
+        const int64_t now = esp_timer_get_time();
+        taskENTER_CRITICAL(&_statsMutex);
+        for (_port &port : _ports){
+            port.stats = {};
+        }
+        memset(_device_busy_us, 0, sizeof(_device_busy_us));
+        _window_start_us = now;
+        taskEXIT_CRITICAL(&_statsMutex);
+    }
+
+    /**
+     * @brief Propose a device placement that balances measured bus time
+     * 
+     * Greedy longest-processing-time assignment: fixed devices are counted
+     * first, then mirrored devices are taken in order of decreasing load and
+     * put on the port with the smaller projected total.
+     * 
+     * @param placement Output placement and projected load
+     */
+    void I2cBusGroup::SuggestPlacement(PortPlacement &placement){
+        uint64_t load[sizeof(_placement)];
+        bool mirrored[sizeof(_placement)];
+        taskENTER_CRITICAL(&_statsMutex);
+        memcpy(placement.port, _placement, sizeof(placement.port));
+        memcpy(load, _device_busy_us, sizeof(load));
+        memcpy(mirrored, _mirrored, sizeof(mirrored));
+        taskEXIT_CRITICAL(&_statsMutex);
+
+        placement.projected_busy_us[0] = 0;
+        placement.projected_busy_us[1] = 0;
+        for (size_t addr = 0; addr < sizeof(load); addr++){
+            if (!mirrored[addr]){
+                placement.projected_busy_us[placement.port[addr]] += load[addr];
+            }
+        }
+
+        while (true){
+            size_t heaviest = sizeof(load);
+            for (size_t addr = 0; addr < sizeof(load); addr++){
+                if (mirrored[addr] && (heaviest == sizeof(load) || load[addr] > load[heaviest])){
+                    heaviest = addr;
+                }
+            }
+            if (heaviest == sizeof(load)){
+                break;
+            }
+            const uint8_t port = placement.projected_busy_us[0] <= placement.projected_busy_us[1] ? 0 : 1;
+            placement.port[heaviest] = port;
+            placement.projected_busy_us[port] += load[heaviest];
+            mirrored[heaviest] = false;
+        }
+    }
+
+    /**
+     * @brief Apply the suggested placement to mirrored devices
+     * 
+     * The policy is copied before the placement changes, so no transaction
+     * runs on the target bus without it.
+     * 
+     * @return size_t Number of devices that changed port
+     */
+    size_t I2cBusGroup::Rebalance(void){
+        PortPlacement placement;
+        SuggestPlacement(placement);
+
+        size_t moved{0};
+        for (size_t addr = 0; addr < sizeof(_placement); addr++){
+            const uint8_t to = placement.port[addr];
+            taskENTER_CRITICAL(&_statsMutex);
+            const uint8_t from = _placement[addr];
+            const bool move = _mirrored[addr] && from != to;
+            taskEXIT_CRITICAL(&_statsMutex);
+            if (!move || _moveDeviceConfig(addr, from, to) != ESP_OK){
+                continue;
+            }
+
+            taskENTER_CRITICAL(&_statsMutex);
+            _placement[addr] = to;
+            taskEXIT_CRITICAL(&_statsMutex);
+            moved++;
+        }
+        return moved;
+    }
+
+    /**
+     * @brief Copy a device's policy to the bus it is moved to
+     * 
+     * @param dev_addr I2C device address
+     * @param from Port the device is on
+     * @param to Port the device moves to
+     * @return esp_err_t ESP_OK if the device behaves the same on the target bus, ESP_ERR_INVALID_STATE if only
+     *         the target bus has a policy for it, error code of ConfigureDevice() otherwise
+     */
+    esp_err_t I2cBusGroup::_moveDeviceConfig(uint8_t dev_addr, uint8_t from, uint8_t to){
+        DeviceConfig config;
+        if (_ports[from].bus->GetDeviceConfig(dev_addr, config) == ESP_OK){
+            return _ports[to].bus->ConfigureDevice(dev_addr, config);
+        }
+        return _ports[to].bus->GetDeviceConfig(dev_addr, config) == ESP_OK ? ESP_ERR_INVALID_STATE : ESP_OK;
+    }
+
+    /**
+     * @brief Port worker task body, runs jobs until it receives the stop job
+     * 
+     * @param arg Pointer to the _port this worker serves
+     */
+    void I2cBusGroup::_worker(void *arg){
+        auto* port = static_cast<_port*>(arg);
+        _job job;
+        while (true){
+            if (xQueueReceive(port->queue, &job, portMAX_DELAY) != pdTRUE){
+                continue;
+            }
+            if (job.transactions == nullptr){
+                break;
+            }
+            port->group->_run(*port, job);
+            xSemaphoreGive(job.done);
+        }
+
+        xSemaphoreGive(port->stopped);
+        vTaskDelete(nullptr);
+    }
+
+    /**
+     * @brief Run the share of a job that is routed to one port
+     * 
+     * @param port Port context
+     * @param job Submitted job
+     */
+    void I2cBusGroup::_run(_port &port, const _job &job){
+        for (size_t i = 0; i < job.count; i++){
+            Transaction &transaction = job.transactions[i];
+            const uint8_t addr = transaction.dev_addr & 0x7F;
+            if (job.routes[addr] != port.index){
+                continue;
+            }
+
+            const int64_t start = esp_timer_get_time();
+            if (transaction.read){
+                transaction.status = port.bus->ReadRegisterMultipleBytes(transaction.dev_addr, transaction.reg_addr, transaction.data, transaction.length);
+            } else {
+                transaction.status = port.bus->WriteRegisterMultipleBytes(transaction.dev_addr, transaction.reg_addr, transaction.data, transaction.length);
+            }
+            const uint64_t elapsed = esp_timer_get_time() - start;
+
+            taskENTER_CRITICAL(&_statsMutex);
+            port.stats.transactions++;
+            if (transaction.status != ESP_OK){
+                port.stats.errors++;
+            }
+            port.stats.busy_us += elapsed;
+            _device_busy_us[addr] += elapsed;
+            taskEXIT_CRITICAL(&_statsMutex);
+        }
+    }
+}
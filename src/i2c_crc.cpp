@@ -0,0 +1,120 @@
+#include "i2c_crc.h"
+#include "esp_attr.h"
+
+namespace I2C {
+    namespace Crc {
+        namespace {
+            using Tables = std::array<std::array<uint8_t, 256>, 4>;
+
+            /**
+             * @brief Slicing tables, kept in DRAM so lookups never miss the flash cache
+             */
+            DRAM_ATTR constexpr Tables smbus_tables = MakeTables(SMBUS_POLY);
+            DRAM_ATTR constexpr Tables sensirion_tables = MakeTables(SENSIRION_POLY);
+
+            /**
+             * @brief Inputs shorter than this use the single table, longer ones slice by 4
+             */
+            constexpr size_t SLICING_THRESHOLD = 16;
+
+            /**
+             * @brief Table-driven CRC-8 with a slicing-by-4 main loop
+             * 
+             * @param tables Slicing tables of the polynomial
+             * @param data Input bytes
+             * @param length Number of bytes
+             * @param crc Initial value
+             * @return uint8_t CRC
+             */
+            inline uint8_t compute(const Tables &tables, const uint8_t *data, size_t length, uint8_t crc){
+                if (length >= SLICING_THRESHOLD){
+                    for (; length >= 4; data += 4, length -= 4){
+                        crc = tables[3][data[0] ^ crc] ^ tables[2][data[1]] ^ tables[1][data[2]] ^ tables[0][data[3]];
+                    }
+                }
+                for (; length > 0; data++, length--){
+                    crc = tables[0][*data ^ crc];
+                }
+                return crc;
+            }
+        }
+
+        /**
+         * @brief Bit-by-bit CRC-8
+         * 
+         * @param data Input bytes
+         * @param length Number of bytes
+         * @param poly Generator polynomial
+         * @param crc Initial value
+         * @return uint8_t CRC
+         */
+        uint8_t Bitwise(const uint8_t *data, size_t length, uint8_t poly, uint8_t crc){
+            for (size_t i = 0; i < length; i++){
+                crc ^= data[i];
+                for (int bit = 0; bit < 8; bit++){
+                    crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ poly) : static_cast<uint8_t>(crc << 1);
+                }
+            }
+            return crc;
+        }
+
+        /**
+         * @brief SMBus packet error code
+         * 
+         * @param data Input bytes
+         * @param length Number of bytes
+         * @param crc Initial value
+         * @return uint8_t PEC
+         */
+        uint8_t Smbus(const uint8_t *data, size_t length, uint8_t crc){
+            return compute(smbus_tables, data, length, crc);
+        }
+
+        /**
+         * @brief Sensirion CRC-8
+         * 
+         * @param data Input bytes
+         * @param length Number of bytes
+         * @param crc Initial value
+         * @return uint8_t CRC
+         */
+        uint8_t Sensirion(const uint8_t *data, size_t length, uint8_t crc){
+            return compute(sensirion_tables, data, length, crc);
+        }
+
+        /**
+         * @brief Check and strip Sensirion word CRCs
+         * 
+         * @param frame Raw bytes, 3 per word
+         * @param words Output for the words
+         * @param count Number of words
+         * @return true if every CRC matched
+         */
+        bool UnpackSensirionWords(const uint8_t *frame, uint16_t *words, size_t count){
+            const auto &table = sensirion_tables[0];
+            bool valid{true};
+            for (size_t i = 0; i < count; i++, frame += 3){
+                const uint8_t crc = table[table[frame[0] ^ SENSIRION_INIT] ^ frame[1]];
+                valid &= crc == frame[2];
+                words[i] = static_cast<uint16_t>((frame[0] << 8) | frame[1]);
+            }
+            return valid;
+        }
+
+        /**
+         * @brief Add Sensirion word CRCs
+         * 
+         * @param words Words to send
+         * @param frame Output, 3 bytes per word
+         * @param count Number of words
+         */
+        void PackSensirionWords(const uint16_t *words, uint8_t *frame, size_t count){
+            const auto &table = sensirion_tables[0];
+            for (size_t i = 0; i < count; i++, frame += 3){
+                frame[0] = static_cast<uint8_t>(words[i] >> 8);
+                frame[1] = static_cast<uint8_t>(words[i]);
+                frame[2] = table[table[frame[0] ^ SENSIRION_INIT] ^ frame[1]];
+            }
+        }
+    }
+}
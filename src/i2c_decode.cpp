@@ -0,0 +1,157 @@
+#include "i2c_decode.h"
+#include <bit>
+#include <cstring>
+
+namespace I2C {
+    namespace Decode {
+        static_assert(std::endian::native == std::endian::little, "Word kernels assume a little-endian CPU");
+
+        namespace {
+            /**
+             * @brief Load four bytes as a big-endian word without alignment requirements
+             * 
+             * @param bytes First byte
+             * @return uint32_t Word with bytes[0] as the most significant byte
+             */
+            inline uint32_t loadBigEndian(const uint8_t *bytes){
+                uint32_t word;
+                memcpy(&word, bytes, sizeof(word));
+                return __builtin_bswap32(word);
+            }
+
+            /**
+             * @brief Swap the bytes within both 16-bit halves of a word
+             * 
+             * @param word Two little-endian loaded big-endian samples
+             * @return uint32_t Two native samples
+             */
+            inline uint32_t swapHalves(uint32_t word){
+                return ((word & 0x00FF00FFu) << 8) | ((word >> 8) & 0x00FF00FFu);
+            }
+
+            /**
+             * @brief Sign-extend a 24-bit value
+             * 
+             * @param value Value in the low 24 bits
+             * @return int32_t Sign-extended value
+             */
+            inline int32_t signExtend24(uint32_t value){
+                return static_cast<int32_t>(value << 8) >> 8;
+            }
+        }
+
+        /**
+         * @brief Extract every field of a runtime layout from a frame
+         * 
+         * @param frame Raw frame
+         * @param layout Field locations
+         * @param count Number of fields
+         * @param out One value per field
+         */
+        void ExtractFields(const uint8_t *frame, const PackedField *layout, size_t count, int32_t *out){
+            for (size_t i = 0; i < count; i++){
+                out[i] = ExtractField(frame, layout[i]);
+            }
+        }
+
+        /**
+         * @brief Convert big-endian int16 samples to native order
+         * 
+         * @param src Raw bytes, 2 per sample
+         * @param dst Output samples
+         * @param count Number of samples
+         */
+        void SwapInt16(const uint8_t *src, int16_t *dst, size_t count){
+            size_t i{0};
+            for (; i + 2 <= count; i += 2){
+                uint32_t word;
+                memcpy(&word, src + 2 * i, sizeof(word));
+                word = swapHalves(word);
+                memcpy(dst + i, &word, sizeof(word));
+            }
+            if (i < count){
+                dst[i] = static_cast<int16_t>((src[2 * i] << 8) | src[2 * i + 1]);
+            }
+        }
+
+        /**
+         * @brief Convert big-endian 24-bit samples to sign-extended int32
+         * 
+         * @param src Raw bytes, 3 per sample
+         * @param dst Output samples
+         * @param count Number of samples
+         */
+        void UnpackInt24(const uint8_t *src, int32_t *dst, size_t count){
+            size_t i{0};
+            for (; i + 4 <= count; i += 4){
+                const uint8_t *bytes = src + 3 * i;
+                const uint32_t w0 = loadBigEndian(bytes);
+                const uint32_t w1 = loadBigEndian(bytes + 4);
+                const uint32_t w2 = loadBigEndian(bytes + 8);
+                dst[i] = signExtend24(w0 >> 8);
+                dst[i + 1] = signExtend24(((w0 & 0xFF) << 16) | (w1 >> 16));
+                dst[i + 2] = signExtend24(((w1 & 0xFFFF) << 8) | (w2 >> 24));
+                dst[i + 3] = signExtend24(w2 & 0xFFFFFF);
+            }
+            for (; i < count; i++){
+                const uint8_t *bytes = src + 3 * i;
+                dst[i] = signExtend24((bytes[0] << 16) | (bytes[1] << 8) | bytes[2]);
+            }
+        }
+
+        /**
+         * @brief Convert left-justified 12-bit samples to int16
+         * 
+         * @param src Raw bytes, 2 per sample
+         * @param dst Output samples
+         * @param count Number of samples
+         * @param is_signed Sign-extend the samples
+         */
+        void UnpackInt12(const uint8_t *src, int16_t *dst, size_t count, bool is_signed){
+            SwapInt16(src, dst, count);
+            if (is_signed){
+                for (size_t i = 0; i < count; i++){
+                    dst[i] = static_cast<int16_t>(dst[i] >> 4);
+                }
+            } else {
+                for (size_t i = 0; i < count; i++){
+                    dst[i] = static_cast<int16_t>(static_cast<uint16_t>(dst[i]) >> 4);
+                }
+            }
+        }
+
+        /**
+         * @brief Apply a fixed-point scale to int16 samples
+         * 
+         * @param raw Raw samples
+         * @param out Scaled values
+         * @param count Number of samples
+         * @param scale Precomputed scale
+         */
+        void ApplyScale(const int16_t *raw, int32_t *out, size_t count, const Scale &scale){
+            const int32_t multiplier = scale.multiplier;
+            const uint8_t shift = scale.shift;
+            const int32_t offset = scale.offset;
+            for (size_t i = 0; i < count; i++){
+                out[i] = static_cast<int32_t>((static_cast<int64_t>(raw[i]) * multiplier) >> shift) + offset;
+            }
+        }
+
+        /**
+         * @brief Apply a fixed-point scale to int32 samples
+         * 
+         * @param raw Raw samples, may alias out
+         * @param out Scaled values
+         * @param count Number of samples
+         * @param scale Precomputed scale
+         */
+        void ApplyScale(const int32_t *raw, int32_t *out, size_t count, const Scale &scale){
+            const int32_t multiplier = scale.multiplier;
+            const uint8_t shift = scale.shift;
+            const int32_t offset = scale.offset;
+            for (size_t i = 0; i < count; i++){
+                out[i] = static_cast<int32_t>((static_cast<int64_t>(raw[i]) * multiplier) >> shift) + offset;
+            }
+        }
+    }
+}
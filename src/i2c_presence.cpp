@@ -0,0 +1,146 @@
+#include "i2c_presence.h"
+
+namespace I2C {
+    /**
+     * @brief Define the event base for I2C presence events.
+     */
+    ESP_EVENT_DEFINE_BASE(I2C_EVENTS);
+
+    /**
+     * @brief Construct a monitor for an initialized master bus
+     * 
+     * @param bus Bus to watch
+     * @param first_addr First address to scan
+     * @param last_addr Last address to scan
+     * @param miss_threshold Consecutive missed scans before a device is reported removed
+     */
+    PresenceMonitor::PresenceMonitor(I2c &bus, uint8_t first_addr, uint8_t last_addr, uint8_t miss_threshold)
+        : _bus(bus), _first_addr(first_addr), _last_addr(last_addr), _miss_threshold(miss_threshold > 0 ? miss_threshold : 1){
+        _stopped = xSemaphoreCreateBinaryStatic(&_stopped_buffer);
+    }
+
+    /**
+     * @brief Stop the monitor task
+     */
+    PresenceMonitor::~PresenceMonitor(){
+        Stop();
+    }
+
+    /**
+     * @brief Start scanning in the background
+     * 
+     * @param period_ms Time between scans
+     * @param priority FreeRTOS priority of the monitor task
+     * @param loop Custom event loop, nullptr to post to the default loop
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if already running, ESP_ERR_NO_MEM if the task could not be created
+     */
+    esp_err_t PresenceMonitor::Start(uint32_t period_ms, UBaseType_t priority, esp_event_loop_handle_t loop){
+        if (_task != nullptr){
+            return ESP_ERR_INVALID_STATE;
+        }
+        _period_ms = period_ms;
+        _loop = loop;
+        if (xTaskCreate(_monitorTask, "i2c_presence", 3072, this, priority, &_task) != pdPASS){
+            _task = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Stop scanning, waiting for a scan in progress to finish
+     * 
+     * The task is asked to exit instead of being deleted so it never dies
+     * while holding the bus lock.
+     */
+    void PresenceMonitor::Stop(void){
+        if (_task == nullptr){
+            return;
+        }
+        xTaskNotifyGive(_task);
+        xSemaphoreTake(_stopped, portMAX_DELAY);
+        _task = nullptr;
+    }
+
+    /**
+     * @brief Run one scan and post events for changes
+     * 
+     * @return esp_err_t ESP_OK on success, error code if the scan failed
+     */
+    esp_err_t PresenceMonitor::Poll(void){
+        ScanResult scan;
+        const esp_err_t status = _bus.Scan(scan, _first_addr, _last_addr);
+        if (status != ESP_OK){
+            return status;
+        }
+
+        for (unsigned addr = _first_addr; addr <= _last_addr; addr++){
+            const bool answered = scan.Contains(addr);
+            const bool known = _present.Contains(addr);
+            if (answered){
+                _misses[addr] = 0;
+                if (!known){
+                    taskENTER_CRITICAL(&_mutex);
+                    _present.Add(addr);
+                    taskEXIT_CRITICAL(&_mutex);
+                    _post(DEVICE_ADDED, addr);
+                }
+            } else if (known && ++_misses[addr] >= _miss_threshold){
+                _misses[addr] = 0;
+                taskENTER_CRITICAL(&_mutex);
+                _present.present[addr / 32] &= ~(1u << (addr % 32));
+                _present.count--;
+                taskEXIT_CRITICAL(&_mutex);
+                _post(DEVICE_REMOVED, addr);
+            }
+        }
+
+        taskENTER_CRITICAL(&_mutex);
+        _present.elapsed_us = scan.elapsed_us;
+        taskEXIT_CRITICAL(&_mutex);
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Get the devices currently considered present
+     * 
+     * @return ScanResult Present addresses as of the last scan
+     */
+    ScanResult PresenceMonitor::GetPresent(void){
+        taskENTER_CRITICAL(&_mutex);
+        const ScanResult present = _present;
+        taskEXIT_CRITICAL(&_mutex);
+        return present;
+    }
+
+    /**
+     * @brief Monitor task, scans every period until notified to stop
+     * 
+     * @param arg Pointer to the PresenceMonitor
+     */
+    void PresenceMonitor::_monitorTask(void *arg){
+        auto* monitor = static_cast<PresenceMonitor*>(arg);
+        const TickType_t period = pdMS_TO_TICKS(monitor->_period_ms) > 0 ? pdMS_TO_TICKS(monitor->_period_ms) : 1;
+        do {
+            monitor->Poll();
+        } while (ulTaskNotifyTake(pdTRUE, period) == 0);
+
+        xSemaphoreGive(monitor->_stopped);
+        vTaskDelete(nullptr);
+    }
+
+    /**
+     * @brief Post a presence event
+     * 
+     * @param id DEVICE_ADDED or DEVICE_REMOVED
+     * @param dev_addr 7-bit device address
+     */
+    void PresenceMonitor::_post(int32_t id, uint8_t dev_addr){
+        const PresenceEvent event{_bus.GetPort(), dev_addr};
+        if (_loop != nullptr){
+            esp_event_post_to(_loop, I2C_EVENTS, id, &event, sizeof(event), 0);
+        } else {
+            esp_event_post(I2C_EVENTS, id, &event, sizeof(event), 0);
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#include "i2c.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+namespace I2C {
+    namespace {
+        /**
+         * @brief Work handed to the helper task of a two-port scan
+         */
+        struct ParallelScan {
+            I2c *bus;                       ///< Bus to scan
+            ScanResult *result;             ///< Result for that bus
+            esp_err_t status;               ///< Result of the scan
+            SemaphoreHandle_t done;         ///< Given when the scan has finished
+        };
+
+        /**
+         * @brief Helper task that scans one bus of a two-port scan
+         * 
+         * @param arg Pointer to a ParallelScan
+         */
+        void parallelScanTask(void *arg){
+            auto* work = static_cast<ParallelScan*>(arg);
+            work->status = work->bus->Scan(*work->result);
+            xSemaphoreGive(work->done);
+            vTaskDelete(nullptr);
+        }
+
+        /**
+         * @brief Bit periods of a probe on the wire, START, address, ACK and STOP
+         */
+        constexpr uint32_t PROBE_BITS = 11;
+
+        /**
+         * @brief Margin over the probe's wire time for clock stretching and driver overhead
+         */
+        constexpr uint32_t PROBE_MARGIN = 4;
+
+        /**
+         * @brief Shortest probe deadline, covers the setup of the command
+         */
+        constexpr uint32_t PROBE_FLOOR_US = 1000;
+
+        /**
+         * @brief Get the probe deadline at a bus speed
+         * 
+         * One tick is added because the tick the probe starts in is already
+         * partly over, so the deadline is never shorter than the wire time.
+         * 
+         * @param clk_speed Bus speed in Hz
+         * @return TickType_t Timeout in ticks, at least two ticks
+         */
+        TickType_t probeDeadline(uint32_t clk_speed){
+            const uint32_t speed = clk_speed > 0 ? clk_speed : 1;
+            const uint64_t wire_us = (PROBE_MARGIN * PROBE_BITS * 1000000ULL + speed - 1) / speed;
+            const uint64_t deadline_us = wire_us > PROBE_FLOOR_US ? wire_us : PROBE_FLOOR_US;
+            const uint64_t tick_us = portTICK_PERIOD_MS * 1000ULL;
+            return static_cast<TickType_t>((deadline_us + tick_us - 1) / tick_us) + 1;
+        }
+    }
+
+    /**
+     * @brief Check whether a device acknowledges its address
+     * 
+     * @param dev_addr 7-bit address
+     * @return esp_err_t ESP_OK if the address was acknowledged, ESP_ERR_NOT_FOUND if not, error code otherwise
+     */
+    esp_err_t I2c::Probe(uint8_t dev_addr){
+        if (dev_addr >= sizeof(_device_index)){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        size_t link_size{};
+        uint8_t *link = _acquireLink(link_size);
+        if (link == nullptr){
+            return ESP_ERR_NO_MEM;
+        }
+
+        esp_err_t status{ESP_OK};
+        i2c_cmd_handle_t _handle = i2c_cmd_link_create_static(link, link_size);
+        status |= i2c_master_start(_handle);
+        status |= i2c_master_write_byte(_handle, (dev_addr << 1) | I2C_MASTER_WRITE, true);
+        status |= i2c_master_stop(_handle);
+
+        if (status == ESP_OK){
+            _pmAcquire();
+            xSemaphoreTake(_bus_lock, portMAX_DELAY);
+            if (!_linesReleased()){
+                status = _recover();
+            }
+            if (status == ESP_OK){
+                status = _applyTiming({_config.master.clk_speed, 0, 0});
+            }
+            if (status == ESP_OK){
+                status = i2c_master_cmd_begin(_port, _handle, probeDeadline(_config.master.clk_speed));
+                if (status == ESP_ERR_TIMEOUT && !_linesReleased()){
+                    _recover();
+                }
+            }
+            xSemaphoreGive(_bus_lock);
+            _pmRelease();
+        }
+        i2c_cmd_link_delete_static(_handle);
+        _releaseLink(link);
+
+        return status == ESP_FAIL ? ESP_ERR_NOT_FOUND : status;
+    }
+
+    /**
+     * @brief Probe a range of addresses
+     * 
+     * A missing device costs one address byte on the wire, so a full 7-bit
+     * scan takes a few milliseconds at 100 kHz.
+     * 
+     * @param result Addresses that answered and the scan time
+     * @param first_addr First address to probe
+     * @param last_addr Last address to probe
+     * @return esp_err_t ESP_OK on success, error code if the bus failed during the scan
+     */
+    esp_err_t I2c::Scan(ScanResult &result, uint8_t first_addr, uint8_t last_addr){
+        if (last_addr >= sizeof(_device_index) || first_addr > last_addr){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        const int64_t start = esp_timer_get_time();
+        result = ScanResult{};
+        esp_err_t status{ESP_OK};
+        _pmAcquire();
+        for (unsigned addr = first_addr; addr <= last_addr && (status == ESP_OK || status == ESP_ERR_NOT_FOUND); addr++){
+            status = Probe(addr);
+            if (status == ESP_OK){
+                result.Add(addr);
+            }
+        }
+        _pmRelease();
+        result.elapsed_us = static_cast<uint32_t>(esp_timer_get_time() - start);
+        return status == ESP_ERR_NOT_FOUND ? ESP_OK : status;
+    }
+
+    /**
+     * @brief Scan two ports concurrently
+     * 
+     * @param first First bus
+     * @param first_result Result for the first bus
+     * @param second Second bus
+     * @param second_result Result for the second bus
+     * @return esp_err_t ESP_OK if both scans succeeded, otherwise the first error
+     */
+    esp_err_t I2c::Scan(I2c &first, ScanResult &first_result, I2c &second, ScanResult &second_result){
+        StaticSemaphore_t done_buffer;
+        ParallelScan work{&second, &second_result, ESP_OK, nullptr};
+        work.done = xSemaphoreCreateBinaryStatic(&done_buffer);
+
+        const BaseType_t other_core = xPortGetCoreID() == 0 ? 1 : 0;
+        if (xTaskCreatePinnedToCore(parallelScanTask, "i2c_scan", 3072, &work, uxTaskPriorityGet(nullptr), nullptr, other_core) != pdPASS){
+            return ESP_ERR_NO_MEM;
+        }
+
+        const esp_err_t first_status = first.Scan(first_result);
+        xSemaphoreTake(work.done, portMAX_DELAY);
+        return first_status != ESP_OK ? first_status : work.status;
+    }
+}
@@ -0,0 +1,308 @@
+#include "i2c.h"
+#include <climits>
+#include <cstring>
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+
+namespace I2C {
+    namespace {
+        /**
+         * @brief Interval between reads of a POLL step
+         */
+        constexpr int64_t POLL_INTERVAL_US = 1000;
+
+        /**
+         * @brief Longest wait that is busy-waited instead of slept
+         */
+        constexpr int64_t SPIN_MAX_US = 50;
+
+        /**
+         * @brief Largest burst the executor builds, matches the controller FIFO
+         */
+        constexpr size_t MAX_BURST = 32;
+
+        /**
+         * @brief Work item for the helper task of the two-port executor
+         */
+        struct ParallelInit {
+            I2c *bus;                       ///< Bus to run on
+            InitSequence *sequences;        ///< Sequences for that bus
+            size_t count;                   ///< Number of sequences
+            InitReport report;              ///< Summary of the run
+            esp_err_t status;               ///< Result of the run
+            SemaphoreHandle_t done;         ///< Given when the run has finished
+        };
+
+        /**
+         * @brief Wait until the next sequence is ready
+         * 
+         * Only waits of a few tens of microseconds are busy-waited. Anything
+         * longer is rounded up to whole ticks and slept, so lower-priority
+         * tasks keep running during boot init even with a 10 ms tick. A
+         * vTaskDelay() that returns early is caught by the executor, which
+         * waits again until the sequence is ready.
+         * 
+         * @param us Time to wait in microseconds
+         */
+        void waitUs(int64_t us){
+            if (us <= 0){
+                return;
+            }
+            if (us <= SPIN_MAX_US){
+                esp_rom_delay_us(static_cast<uint32_t>(us));
+                return;
+            }
+            const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+            vTaskDelay((us + tick_us - 1) / tick_us);
+        }
+
+        /**
+         * @brief Helper task body of the two-port executor
+         * 
+         * @param arg Pointer to a ParallelInit
+         */
+        void parallelInitTask(void *arg){
+            auto* work = static_cast<ParallelInit*>(arg);
+            work->status = work->bus->RunInitSequences(work->sequences, work->count, &work->report);
+            xSemaphoreGive(work->done);
+            vTaskDelete(nullptr);
+        }
+    }
+
+    /**
+     * @brief Run device init programs, interleaving independent devices
+     * 
+     * Every pass runs one step of each sequence that is ready. When no
+     * sequence is ready the executor waits for the earliest one.
+     * 
+     * @param sequences Sequences to run, their status and elapsed_us are filled in
+     * @param count Number of sequences
+     * @param report Optional summary including the total init time
+     * @return esp_err_t ESP_OK if every sequence succeeded, otherwise the first error
+     */
+    esp_err_t I2c::RunInitSequences(InitSequence *sequences, size_t count, InitReport *report){
+        InitReport summary{};
+        const int64_t start = esp_timer_get_time();
+
+        for (size_t i = 0; i < count; i++){
+            sequences[i].status = ESP_ERR_NOT_FINISHED;
+            sequences[i].elapsed_us = 0;
+            sequences[i].pc = 0;
+            sequences[i].ready_at_us = start;
+            sequences[i].poll_deadline_us = 0;
+        }
+
+        size_t remaining = count;
+        while (remaining > 0){
+            int64_t now = esp_timer_get_time();
+            int64_t next_ready = INT64_MAX;
+
+            for (size_t i = 0; i < count; i++){
+                InitSequence &sequence = sequences[i];
+                if (sequence.status != ESP_ERR_NOT_FINISHED){
+                    continue;
+                }
+                if (sequence.ready_at_us <= now){
+                    _stepInitSequence(sequence, now, summary);
+                    now = esp_timer_get_time();
+                }
+                if (sequence.status != ESP_ERR_NOT_FINISHED){
+                    sequence.elapsed_us = static_cast<uint32_t>(now - start);
+                    if (sequence.status != ESP_OK){
+                        summary.failed_sequences++;
+                    }
+                    remaining--;
+                } else if (sequence.ready_at_us < next_ready){
+                    next_ready = sequence.ready_at_us;
+                }
+            }
+
+            if (remaining > 0){
+                waitUs(next_ready - esp_timer_get_time());
+            }
+        }
+
+        summary.total_us = static_cast<uint32_t>(esp_timer_get_time() - start);
+        if (report != nullptr){
+            *report = summary;
+        }
+
+        for (size_t i = 0; i < count; i++){
+            if (sequences[i].status != ESP_OK){
+                return sequences[i].status;
+            }
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Run device init programs on two ports in parallel
+     * 
+     * @param first First bus
+     * @param first_sequences Sequences for devices on the first bus
+     * @param first_count Number of sequences for the first bus
+     * @param second Second bus
+     * @param second_sequences Sequences for devices on the second bus
+     * @param second_count Number of sequences for the second bus
+     * @param report Optional combined summary, total_us is the wall time of both
+     * @return esp_err_t ESP_OK if every sequence succeeded, otherwise the first error
+     */
+    esp_err_t I2c::RunInitSequences(I2c &first, InitSequence *first_sequences, size_t first_count,
+                                    I2c &second, InitSequence *second_sequences, size_t second_count,
+                                    InitReport *report){
+        const int64_t start = esp_timer_get_time();
+        StaticSemaphore_t done_buffer;
+        ParallelInit work{&second, second_sequences, second_count, {}, ESP_OK, nullptr};
+        work.done = xSemaphoreCreateBinaryStatic(&done_buffer);
+
+        const BaseType_t other_core = xPortGetCoreID() == 0 ? 1 : 0;
+        if (xTaskCreatePinnedToCore(parallelInitTask, "i2c_init", 4096, &work, uxTaskPriorityGet(nullptr), nullptr, other_core) != pdPASS){
+            return ESP_ERR_NO_MEM;
+        }
+
+        InitReport first_report{};
+        const esp_err_t first_status = first.RunInitSequences(first_sequences, first_count, &first_report);
+        xSemaphoreTake(work.done, portMAX_DELAY);
+
+        if (report != nullptr){
+            report->total_us = static_cast<uint32_t>(esp_timer_get_time() - start);
+            report->transactions = first_report.transactions + work.report.transactions;
+            report->merged_writes = first_report.merged_writes + work.report.merged_writes;
+            report->failed_sequences = first_report.failed_sequences + work.report.failed_sequences;
+        }
+        return first_status != ESP_OK ? first_status : work.status;
+    }
+
+    /**
+     * @brief Execute the next step of one init sequence
+     * 
+     * WRITE and BURST steps are collected into one burst as long as each step
+     * continues at the register following the previous one. DELAY and an
+     * unsatisfied POLL only move ready_at_us forward so the executor can serve
+     * other devices in the meantime. On completion or error the sequence
+     * status is set.
+     * 
+     * @param sequence Sequence to advance
+     * @param now Current esp_timer time
+     * @param report Summary to update
+     */
+    void I2c::_stepInitSequence(InitSequence &sequence, int64_t now, InitReport &report){
+        const uint8_t *program = sequence.program;
+        const size_t length = sequence.length;
+        size_t pc = sequence.pc;
+
+        if (program == nullptr || pc >= length){
+            sequence.status = ESP_ERR_INVALID_ARG;
+            return;
+        }
+
+        switch (static_cast<InitOp>(program[pc])){
+        case InitOp::END:
+            sequence.status = ESP_OK;
+            break;
+
+        case InitOp::WRITE:
+        case InitOp::BURST: {
+            uint8_t buffer[MAX_BURST];
+            uint8_t reg{};
+            size_t collected{0};
+            uint32_t steps{0};
+
+            while (pc < length){
+                const InitOp op = static_cast<InitOp>(program[pc]);
+                if (op != InitOp::WRITE && op != InitOp::BURST){
+                    break;
+                }
+                const size_t header = op == InitOp::WRITE ? 2 : 3;
+                if (pc + header > length){
+                    sequence.status = ESP_ERR_INVALID_ARG;
+                    return;
+                }
+                const uint8_t step_reg = program[pc + 1];
+                const size_t data_length = op == InitOp::WRITE ? 1 : program[pc + 2];
+                if (pc + header + data_length > length || data_length == 0 || data_length > MAX_BURST){
+                    sequence.status = ESP_ERR_INVALID_ARG;
+                    return;
+                }
+                if (steps > 0 && (!sequence.auto_increment
+                                  || step_reg != static_cast<uint8_t>(reg + collected)
+                                  || collected + data_length > MAX_BURST)){
+                    break;
+                }
+                if (steps == 0){
+                    reg = step_reg;
+                }
+                memcpy(&buffer[collected], &program[pc + header], data_length);
+                collected += data_length;
+                pc += header + data_length;
+                steps++;
+            }
+
+            report.transactions++;
+            report.merged_writes += steps - 1;
+            const esp_err_t status = WriteRegisterMultipleBytes(sequence.dev_addr, reg, buffer, collected);
+            if (status != ESP_OK){
+                sequence.status = status;
+                return;
+            }
+            sequence.pc = pc;
+            break;
+        }
+
+        case InitOp::DELAY:
+            if (pc + 3 > length){
+                sequence.status = ESP_ERR_INVALID_ARG;
+                return;
+            }
+            sequence.ready_at_us = now + static_cast<int64_t>(program[pc + 1] | (program[pc + 2] << 8)) * 1000;
+            sequence.pc = pc + 3;
+            break;
+
+        case InitOp::POLL: {
+            if (pc + 6 > length){
+                sequence.status = ESP_ERR_INVALID_ARG;
+                return;
+            }
+            if (sequence.poll_deadline_us == 0){
+                sequence.poll_deadline_us = now + static_cast<int64_t>(program[pc + 4] | (program[pc + 5] << 8)) * 1000;
+            }
+
+            uint8_t value{};
+            report.transactions++;
+            const esp_err_t status = ReadRegisterMultipleBytes(sequence.dev_addr, program[pc + 1], &value, 1);
+            if (status == ESP_OK && (value & program[pc + 2]) == program[pc + 3]){
+                sequence.poll_deadline_us = 0;
+                sequence.pc = pc + 6;
+            } else if (now >= sequence.poll_deadline_us){
+                sequence.status = status != ESP_OK ? status : ESP_ERR_TIMEOUT;
+            } else {
+                sequence.ready_at_us = now + POLL_INTERVAL_US;
+            }
+            break;
+        }
+
+        case InitOp::VERIFY: {
+            if (pc + 4 > length){
+                sequence.status = ESP_ERR_INVALID_ARG;
+                return;
+            }
+            uint8_t value{};
+            report.transactions++;
+            const esp_err_t status = ReadRegisterMultipleBytes(sequence.dev_addr, program[pc + 1], &value, 1);
+            if (status != ESP_OK){
+                sequence.status = status;
+            } else if ((value & program[pc + 2]) != program[pc + 3]){
+                sequence.status = ESP_ERR_INVALID_RESPONSE;
+            } else {
+                sequence.pc = pc + 4;
+            }
+            break;
+        }
+
+        default:
+            sequence.status = ESP_ERR_INVALID_ARG;
+            break;
+        }
+    }
+}
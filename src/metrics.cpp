@@ -0,0 +1,394 @@
+#include "metrics.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+namespace Metrics {
+    namespace {
+        /**
+         * @brief Counters of one GPIO on one core
+         */
+        struct PinShard {
+            std::atomic<uint32_t> edges;
+            std::atomic<uint32_t> drops;
+            std::atomic<uint32_t> isr_cycles_total;
+            std::atomic<uint32_t> isr_cycles_max;
+        };
+
+        /**
+         * @brief Counters of one I2C device on one core
+         */
+        struct DeviceShard {
+            std::atomic<uint32_t> transactions;
+            std::atomic<uint32_t> errors;
+            std::atomic<uint32_t> latency_total_us;
+            std::atomic<uint32_t> latency_max_us;
+            std::atomic<uint32_t> latency_histogram[LATENCY_BUCKETS];
+        };
+
+        /**
+         * @brief Everything one core increments, on its own cache lines
+         */
+        struct alignas(64) CoreShard {
+            PinShard pins[MAX_PINS];
+            DeviceShard devices[MAX_DEVICES];
+        };
+
+        /**
+         * @brief Identity of a tracked device
+         */
+        struct DeviceId {
+            uint8_t port;
+            uint8_t dev_addr;
+        };
+
+        DRAM_ATTR CoreShard shards[portNUM_PROCESSORS];
+
+        /**
+         * @brief Slot of each port and address plus one, 0 while the device is unknown
+         */
+        std::atomic<uint8_t> device_slots[I2C_NUM_MAX][128];
+        DeviceId device_ids[MAX_DEVICES];
+        std::atomic<size_t> device_count{0};
+        portMUX_TYPE device_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+        /**
+         * @brief Append little-endian values to a byte buffer
+         */
+        struct Writer {
+            uint8_t *buffer;
+            size_t size;
+            size_t position;
+
+            void put(uint64_t value, size_t bytes){
+                for (size_t i = 0; i < bytes; i++){
+                    buffer[position++] = static_cast<uint8_t>(value >> (8 * i));
+                }
+            }
+        };
+
+        /**
+         * @brief Append formatted text, remembering whether it was truncated
+         */
+        struct TextWriter {
+            char *buffer;
+            size_t size;
+            size_t length;
+            bool truncated;
+
+            template<typename... Args>
+            void line(const char *format, Args... args){
+                const size_t space = length < size ? size - length : 0;
+                const int needed = snprintf(buffer + length, space, format, args...);
+                if (needed < 0 || static_cast<size_t>(needed) >= space){
+                    truncated = true;
+                    length = size > 0 ? size - 1 : 0;
+                } else {
+                    length += needed;
+                }
+            }
+        };
+    }
+
+#ifdef CONFIG_METRICS_ENABLE
+    namespace {
+        /**
+         * @brief Find or assign the slot of a device
+         * 
+         * @param port I2C port
+         * @param dev_addr 7-bit device address
+         * @return int Slot, or -1 if MAX_DEVICES devices are already tracked
+         */
+        int deviceSlot(i2c_port_t port, uint8_t dev_addr){
+            if (port < 0 || port >= I2C_NUM_MAX || dev_addr >= 128){
+                return -1;
+            }
+
+            uint8_t slot = device_slots[port][dev_addr].load(std::memory_order_acquire);
+            if (slot == 0){
+                taskENTER_CRITICAL(&device_mutex);
+                slot = device_slots[port][dev_addr].load(std::memory_order_relaxed);
+                const size_t count = device_count.load(std::memory_order_relaxed);
+                if (slot == 0 && count < MAX_DEVICES){
+                    device_ids[count] = {static_cast<uint8_t>(port), dev_addr};
+                    slot = static_cast<uint8_t>(count + 1);
+                    device_count.store(count + 1, std::memory_order_release);
+                    device_slots[port][dev_addr].store(slot, std::memory_order_release);
+                }
+                taskEXIT_CRITICAL(&device_mutex);
+            }
+            return static_cast<int>(slot) - 1;
+        }
+
+        /**
+         * @brief Raise a maximum shared by the tasks of one core
+         * 
+         * @param max Counter to raise
+         * @param value Candidate value
+         */
+        void raise(std::atomic<uint32_t> &max, uint32_t value){
+            uint32_t current = max.load(std::memory_order_relaxed);
+            while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)){
+            }
+        }
+    }
+
+    /**
+     * @brief Count a handled GPIO interrupt, callable from an ISR
+     * 
+     * The GPIO interrupt does not nest on a core, so the core's shard has a
+     * single writer and plain loads and stores are enough.
+     * 
+     * @param pin GPIO that interrupted
+     * @param isr_cycles CPU cycles the ISR took
+     */
+    void IRAM_ATTR RecordEdge(gpio_num_t pin, uint32_t isr_cycles){
+        if (pin < 0 || pin >= static_cast<int>(MAX_PINS)){
+            return;
+        }
+        PinShard &shard = shards[xPortGetCoreID()].pins[pin];
+        shard.edges.store(shard.edges.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        shard.isr_cycles_total.store(shard.isr_cycles_total.load(std::memory_order_relaxed) + isr_cycles, std::memory_order_relaxed);
+        if (isr_cycles > shard.isr_cycles_max.load(std::memory_order_relaxed)){
+            shard.isr_cycles_max.store(isr_cycles, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Count an edge that could not be delivered, callable from an ISR or a task
+     * 
+     * Coalesced deliveries fail in the esp_timer task, which the GPIO ISR
+     * can preempt on the same core, so drops use an atomic increment.
+     * 
+     * @param pin GPIO that interrupted
+     */
+    void IRAM_ATTR RecordDrop(gpio_num_t pin){
+        if (pin < 0 || pin >= static_cast<int>(MAX_PINS)){
+            return;
+        }
+        PinShard &shard = shards[xPortGetCoreID()].pins[pin];
+        shard.drops.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Count a completed I2C transaction
+     * 
+     * Tasks on one core may preempt each other, so these counters use
+     * atomic read-modify-write. They never contend with the other core.
+     * 
+     * @param port I2C port
+     * @param dev_addr 7-bit device address
+     * @param status Result of the transaction
+     * @param latency_us Time from queueing for the bus to completion
+     */
+    void RecordTransaction(i2c_port_t port, uint8_t dev_addr, esp_err_t status, uint32_t latency_us){
+        const int slot = deviceSlot(port, dev_addr);
+        if (slot < 0){
+            return;
+        }
+
+        size_t bucket{0};
+        for (uint32_t bound = FIRST_BUCKET_US; bucket < LATENCY_BUCKETS - 1 && latency_us >= bound; bound <<= 1){
+            bucket++;
+        }
+
+        DeviceShard &shard = shards[xPortGetCoreID()].devices[slot];
+        shard.transactions.fetch_add(1, std::memory_order_relaxed);
+        if (status != ESP_OK){
+            shard.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.latency_total_us.fetch_add(latency_us, std::memory_order_relaxed);
+        raise(shard.latency_max_us, latency_us);
+        shard.latency_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+
+    /**
+     * @brief Sum the per-core counters into a snapshot
+     * 
+     * @param snapshot Filled with the current totals
+     */
+    void TakeSnapshot(MetricsSnapshot &snapshot){
+        snapshot = MetricsSnapshot{};
+        snapshot.timestamp_us = esp_timer_get_time();
+        snapshot.device_count = device_count.load(std::memory_order_acquire);
+
+        for (const CoreShard &core : shards){
+            for (size_t pin = 0; pin < MAX_PINS; pin++){
+                const PinShard &shard = core.pins[pin];
+                PinMetrics &total = snapshot.pins[pin];
+                total.edges += shard.edges.load(std::memory_order_relaxed);
+                total.drops += shard.drops.load(std::memory_order_relaxed);
+                total.isr_cycles_total += shard.isr_cycles_total.load(std::memory_order_relaxed);
+                const uint32_t isr_max = shard.isr_cycles_max.load(std::memory_order_relaxed);
+                total.isr_cycles_max = isr_max > total.isr_cycles_max ? isr_max : total.isr_cycles_max;
+            }
+
+            for (size_t slot = 0; slot < snapshot.device_count; slot++){
+                const DeviceShard &shard = core.devices[slot];
+                DeviceMetrics &total = snapshot.devices[slot];
+                total.transactions += shard.transactions.load(std::memory_order_relaxed);
+                total.errors += shard.errors.load(std::memory_order_relaxed);
+                total.latency_total_us += shard.latency_total_us.load(std::memory_order_relaxed);
+                const uint32_t latency_max = shard.latency_max_us.load(std::memory_order_relaxed);
+                total.latency_max_us = latency_max > total.latency_max_us ? latency_max : total.latency_max_us;
+                for (size_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++){
+                    total.latency_histogram[bucket] += shard.latency_histogram[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        for (size_t slot = 0; slot < snapshot.device_count; slot++){
+            snapshot.devices[slot].port = device_ids[slot].port;
+            snapshot.devices[slot].dev_addr = device_ids[slot].dev_addr;
+        }
+    }
+
+    /**
+     * @brief Clear every counter and forget the known devices
+     */
+    void Reset(void){
+        taskENTER_CRITICAL(&device_mutex);
+        for (CoreShard &core : shards){
+            for (PinShard &shard : core.pins){
+                shard.edges.store(0, std::memory_order_relaxed);
+                shard.drops.store(0, std::memory_order_relaxed);
+                shard.isr_cycles_total.store(0, std::memory_order_relaxed);
+                shard.isr_cycles_max.store(0, std::memory_order_relaxed);
+            }
+            for (DeviceShard &shard : core.devices){
+                shard.transactions.store(0, std::memory_order_relaxed);
+                shard.errors.store(0, std::memory_order_relaxed);
+                shard.latency_total_us.store(0, std::memory_order_relaxed);
+                shard.latency_max_us.store(0, std::memory_order_relaxed);
+                for (auto &bucket : shard.latency_histogram){
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+        for (auto &port : device_slots){
+            for (auto &slot : port){
+                slot.store(0, std::memory_order_relaxed);
+            }
+        }
+        device_count.store(0, std::memory_order_release);
+        taskEXIT_CRITICAL(&device_mutex);
+    }
+
+    /**
+     * @brief Encode a snapshot into a compact little-endian byte stream
+     * 
+     * @param snapshot Snapshot to encode
+     * @param buffer Destination
+     * @param size Size of buffer
+     * @param written Set to the number of bytes written
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the buffer is too small
+     */
+    esp_err_t ExportBinary(const MetricsSnapshot &snapshot, uint8_t *buffer, size_t size, size_t &written){
+        static constexpr size_t HEADER_SIZE = 16;
+        static constexpr size_t PIN_SIZE = 1 + 4 * 4;
+        static constexpr size_t DEVICE_SIZE = 2 + 4 * (4 + LATENCY_BUCKETS);
+
+        size_t pin_count{0};
+        for (const PinMetrics &pin : snapshot.pins){
+            pin_count += pin.edges != 0 ? 1 : 0;
+        }
+
+        written = 0;
+        const size_t needed = HEADER_SIZE + pin_count * PIN_SIZE + snapshot.device_count * DEVICE_SIZE;
+        if (buffer == nullptr || size < needed){
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        Writer out{buffer, size, 0};
+        out.put(BINARY_MAGIC, 4);
+        out.put(BINARY_VERSION, 1);
+        out.put(pin_count, 1);
+        out.put(snapshot.device_count, 1);
+        out.put(0, 1);
+        out.put(static_cast<uint64_t>(snapshot.timestamp_us), 8);
+
+        for (size_t pin = 0; pin < MAX_PINS; pin++){
+            const PinMetrics &metrics = snapshot.pins[pin];
+            if (metrics.edges == 0){
+                continue;
+            }
+            out.put(pin, 1);
+            out.put(metrics.edges, 4);
+            out.put(metrics.drops, 4);
+            out.put(metrics.isr_cycles_total, 4);
+            out.put(metrics.isr_cycles_max, 4);
+        }
+
+        for (size_t slot = 0; slot < snapshot.device_count; slot++){
+            const DeviceMetrics &metrics = snapshot.devices[slot];
+            out.put(metrics.port, 1);
+            out.put(metrics.dev_addr, 1);
+            out.put(metrics.transactions, 4);
+            out.put(metrics.errors, 4);
+            out.put(metrics.latency_total_us, 4);
+            out.put(metrics.latency_max_us, 4);
+            for (const uint32_t count : metrics.latency_histogram){
+                out.put(count, 4);
+            }
+        }
+
+        written = out.position;
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Format a snapshot as text, one "name{labels} value" line per counter
+     * 
+     * Histogram buckets are not cumulative, the lt label is the exclusive
+     * upper bound of each bucket.
+     * 
+     * @param snapshot Snapshot to format
+     * @param buffer Destination, always NUL-terminated if size > 0
+     * @param size Size of buffer
+     * @param written Set to the length of the text
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the text was truncated
+     */
+    esp_err_t ExportText(const MetricsSnapshot &snapshot, char *buffer, size_t size, size_t &written){
+        TextWriter out{buffer, size, 0, false};
+        if (buffer != nullptr && size > 0){
+            buffer[0] = '\0';
+        }
+
+        for (size_t pin = 0; pin < MAX_PINS; pin++){
+            const PinMetrics &metrics = snapshot.pins[pin];
+            if (metrics.edges == 0){
+                continue;
+            }
+            const unsigned label = static_cast<unsigned>(pin);
+            out.line("gpio_edges{pin=\"%u\"} %lu\n", label, static_cast<unsigned long>(metrics.edges));
+            out.line("gpio_drops{pin=\"%u\"} %lu\n", label, static_cast<unsigned long>(metrics.drops));
+            out.line("gpio_isr_cycles_total{pin=\"%u\"} %lu\n", label, static_cast<unsigned long>(metrics.isr_cycles_total));
+            out.line("gpio_isr_cycles_max{pin=\"%u\"} %lu\n", label, static_cast<unsigned long>(metrics.isr_cycles_max));
+        }
+
+        for (size_t slot = 0; slot < snapshot.device_count; slot++){
+            const DeviceMetrics &metrics = snapshot.devices[slot];
+            const unsigned port = metrics.port;
+            const unsigned addr = metrics.dev_addr;
+            out.line("i2c_transactions{port=\"%u\",addr=\"0x%02X\"} %lu\n", port, addr, static_cast<unsigned long>(metrics.transactions));
+            out.line("i2c_errors{port=\"%u\",addr=\"0x%02X\"} %lu\n", port, addr, static_cast<unsigned long>(metrics.errors));
+            out.line("i2c_latency_us_total{port=\"%u\",addr=\"0x%02X\"} %lu\n", port, addr, static_cast<unsigned long>(metrics.latency_total_us));
+            out.line("i2c_latency_us_max{port=\"%u\",addr=\"0x%02X\"} %lu\n", port, addr, static_cast<unsigned long>(metrics.latency_max_us));
+            for (size_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++){
+                const unsigned long count = metrics.latency_histogram[bucket];
+                if (bucket < LATENCY_BUCKETS - 1){
+                    out.line("i2c_latency_us_bucket{port=\"%u\",addr=\"0x%02X\",lt=\"%lu\"} %lu\n", port, addr,
+                             static_cast<unsigned long>(FIRST_BUCKET_US) << bucket, count);
+                } else {
+                    out.line("i2c_latency_us_bucket{port=\"%u\",addr=\"0x%02X\",lt=\"inf\"} %lu\n", port, addr, count);
+                }
+            }
+        }
+
+        written = out.length;
+        return out.truncated ? ESP_ERR_INVALID_SIZE : ESP_OK;
+    }
+}
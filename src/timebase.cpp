@@ -0,0 +1,212 @@
+#include "timebase.h"
+#include <atomic>
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_ipc.h"
+#include "esp_rom_sys.h"
+#include "esp_pm.h"
+
+namespace Timebase {
+    namespace {
+        /**
+         * @brief Latest calibration of each core, written only by that core
+         */
+        DRAM_ATTR CoreCalibration calibrations[portNUM_PROCESSORS];
+
+        /**
+         * @brief Guards calibrations against torn reads from the other core
+         */
+        portMUX_TYPE calibration_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+        esp_timer_handle_t calibration_timer{nullptr};
+        std::atomic<bool> started{false};
+
+        /**
+         * @brief Check whether the CPU frequency can only change at the application's request
+         * 
+         * Power management switches the frequency on its own, and can switch
+         * away and back between two calibrations unseen, only when DFS
+         * (min below max) or automatic light sleep is configured.
+         * 
+         * @return true if the current configuration keeps one fixed frequency
+         */
+        bool frequencyFixed(void){
+#if CONFIG_PM_ENABLE
+            esp_pm_config_t config{};
+            if (esp_pm_get_configuration(&config) != ESP_OK){
+                return false;
+            }
+            return config.min_freq_mhz == config.max_freq_mhz && !config.light_sleep_enable;
+#else
+            return true;
+#endif
+        }
+
+        /**
+         * @brief Pair the calling core's cycle counter with esp_timer
+         * 
+         * The esp_timer value was latched somewhere between the two cycle
+         * reads, so the midpoint is paired with it and half the window is
+         * the pairing uncertainty. Interrupts on this core are off, so Now()
+         * never sees a half-written calibration. While the frequency is not
+         * fixed the core is left uncalibrated and Now() reads esp_timer.
+         * 
+         * @param arg Pointer to a bool, true if the frequency is fixed
+         */
+        void calibrate(void *arg){
+            const bool fixed = *static_cast<const bool *>(arg);
+            CoreCalibration &calibration = calibrations[xPortGetCoreID()];
+
+            taskENTER_CRITICAL(&calibration_mutex);
+            const uint32_t before = esp_cpu_get_cycle_count();
+            const int64_t now_us = esp_timer_get_time();
+            const uint32_t after = esp_cpu_get_cycle_count();
+            calibration.cycle_base = before + (after - before) / 2;
+            calibration.us_base = now_us;
+            calibration.window_cycles = after - before;
+            calibration.ticks_per_us = fixed ? esp_rom_get_cpu_ticks_per_us() : 0;
+            taskEXIT_CRITICAL(&calibration_mutex);
+        }
+
+        /**
+         * @brief Calibrate every core on that core
+         * 
+         * Recalibrating well within the counter wrap, about 18 s at 240 MHz,
+         * keeps the unsigned cycle difference in Now() unambiguous. The power
+         * management configuration is checked on every pass, so switching to
+         * or from DFS takes effect within one period.
+         * 
+         * @param arg Unused
+         */
+        void calibrateAll(void *arg){
+            bool fixed = frequencyFixed();
+#if CONFIG_FREERTOS_UNICORE
+            calibrate(&fixed);
+#else
+            for (uint32_t core = 0; core < portNUM_PROCESSORS; core++){
+                esp_ipc_call_blocking(core, calibrate, &fixed);
+            }
+#endif
+        }
+    }
+
+    /**
+     * @brief Calibrate every core and keep recalibrating every CONFIG_TIMEBASE_CALIBRATION_MS
+     * 
+     * @return esp_err_t ESP_OK on success, error code if the calibration timer could not be started
+     */
+    esp_err_t Start(void){
+        bool expected{false};
+        if (!started.compare_exchange_strong(expected, true, std::memory_order_acq_rel)){
+            return ESP_OK;
+        }
+
+        calibrateAll(nullptr);
+
+        esp_timer_create_args_t args{};
+        args.callback = calibrateAll;
+        args.name = "timebase";
+        args.skip_unhandled_events = true;
+        esp_err_t status = esp_timer_create(&args, &calibration_timer);
+        if (status == ESP_OK){
+            status = esp_timer_start_periodic(calibration_timer, CONFIG_TIMEBASE_CALIBRATION_MS * 1000ULL);
+        }
+        if (status != ESP_OK){
+            Stop();
+        }
+        return status;
+    }
+
+    /**
+     * @brief Stop recalibrating, Now() falls back to esp_timer_get_time()
+     */
+    void Stop(void){
+        if (calibration_timer != nullptr){
+            esp_timer_stop(calibration_timer);
+            esp_timer_delete(calibration_timer);
+            calibration_timer = nullptr;
+        }
+
+        taskENTER_CRITICAL(&calibration_mutex);
+        for (CoreCalibration &calibration : calibrations){
+            calibration.ticks_per_us = 0;
+        }
+        taskEXIT_CRITICAL(&calibration_mutex);
+        started.store(false, std::memory_order_release);
+    }
+
+    /**
+     * @brief Current time on the esp_timer timeline, callable from an ISR on either core
+     * 
+     * Interrupts are masked for the few instructions that pick the core's
+     * calibration and read its counter, so a task cannot migrate between them.
+     * The ROM keeps the current CPU frequency, a mismatch means a frequency
+     * switch since the calibration.
+     * 
+     * @return int64_t Microseconds since boot
+     */
+    int64_t IRAM_ATTR Now(void){
+        const UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+        const CoreCalibration &calibration = calibrations[xPortGetCoreID()];
+        const uint32_t cycles = esp_cpu_get_cycle_count();
+        const uint32_t ticks_per_us = calibration.ticks_per_us;
+        const uint32_t cycle_base = calibration.cycle_base;
+        const int64_t us_base = calibration.us_base;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+
+        if (ticks_per_us == 0 || ticks_per_us != esp_rom_get_cpu_ticks_per_us()){
+            return esp_timer_get_time();
+        }
+        return us_base + (cycles - cycle_base) / ticks_per_us;
+    }
+
+    /**
+     * @brief Check whether every core has a calibration for its current frequency
+     * 
+     * @return true if Now() converts cycles on both cores
+     */
+    bool IsCalibrated(void){
+        const uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+        bool calibrated{true};
+        taskENTER_CRITICAL(&calibration_mutex);
+        for (const CoreCalibration &calibration : calibrations){
+            calibrated &= calibration.ticks_per_us == ticks_per_us;
+        }
+        taskEXIT_CRITICAL(&calibration_mutex);
+        return calibrated;
+    }
+
+    /**
+     * @brief Bound on the error between timestamps taken on different cores
+     * 
+     * @return uint32_t Error bound in microseconds
+     */
+    uint32_t GetErrorBoundUs(void){
+        uint32_t bound{0};
+        taskENTER_CRITICAL(&calibration_mutex);
+        for (const CoreCalibration &calibration : calibrations){
+            const uint32_t ticks_per_us = calibration.ticks_per_us > 0 ? calibration.ticks_per_us : 1;
+            const uint32_t half_window = calibration.window_cycles / 2;
+            bound += (half_window + ticks_per_us - 1) / ticks_per_us + 1;
+        }
+        taskEXIT_CRITICAL(&calibration_mutex);
+        return bound;
+    }
+
+    /**
+     * @brief Get the latest calibration of a core
+     * 
+     * @param core Core to read
+     * @return CoreCalibration Calibration, all zero for a bad or uncalibrated core
+     */
+    CoreCalibration GetCalibration(BaseType_t core){
+        CoreCalibration calibration{};
+        if (core < 0 || core >= portNUM_PROCESSORS){
+            return calibration;
+        }
+        taskENTER_CRITICAL(&calibration_mutex);
+        calibration = calibrations[core];
+        taskEXIT_CRITICAL(&calibration_mutex);
+        return calibration.ticks_per_us > 0 ? calibration : CoreCalibration{};
+    }
+}
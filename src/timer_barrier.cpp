@@ -0,0 +1,44 @@
+#include "timer_barrier.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+namespace TimerBarrier {
+    namespace {
+        /**
+         * @brief Callback of the barrier timer, releases the waiting task
+         * 
+         * @param arg Semaphore of the waiting task
+         */
+        void release(void *arg){
+            xSemaphoreGive(static_cast<SemaphoreHandle_t>(arg));
+        }
+    }
+
+    /**
+     * @brief Wait until every esp_timer callback dispatched so far has returned
+     * 
+     * @return esp_err_t ESP_OK once the barrier fired, error code if its timer could not be started
+     */
+    esp_err_t Wait(void){
+        StaticSemaphore_t buffer;
+        SemaphoreHandle_t fired = xSemaphoreCreateBinaryStatic(&buffer);
+
+        esp_timer_create_args_t args{};
+        args.callback = release;
+        args.arg = fired;
+        args.name = "timer_barrier";
+        esp_timer_handle_t timer{nullptr};
+        esp_err_t status = esp_timer_create(&args, &timer);
+        if (status == ESP_OK){
+            status = esp_timer_start_once(timer, 0);
+            if (status == ESP_OK){
+                xSemaphoreTake(fired, portMAX_DELAY);
+            }
+            esp_timer_delete(timer);
+        }
+
+        vSemaphoreDelete(fired);
+        return status;
+    }
+}
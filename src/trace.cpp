@@ -0,0 +1,527 @@
+#include "trace.h"
+#include <atomic>
+#include <cstring>
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "timebase.h"
+
+namespace Trace {
+    namespace {
+        /**
+         * @brief Recorder the hooks append to, nullptr while nothing is recorded
+         */
+        std::atomic<Recorder *> active{nullptr};
+        portMUX_TYPE active_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+        /**
+         * @brief Hooks between loading active and finishing their append
+         * 
+         * Stop() waits for this to drain, so a hook never writes to a
+         * recorder after Stop() returned.
+         */
+        std::atomic<uint32_t> in_flight{0};
+
+        constexpr size_t EDGE_FIELDS = 2;   ///< Pin and level
+        constexpr size_t MAX_VARINT = 10;   ///< Longest encoding of a 64-bit varint
+
+        /**
+         * @brief Map a signed value onto an unsigned one with small magnitudes staying small
+         */
+        inline uint64_t IRAM_ATTR zigzag(int64_t value){
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        inline int64_t unzigzag(uint64_t value){
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        inline size_t IRAM_ATTR varintSize(uint64_t value){
+            size_t size{1};
+            while (value >= 0x80){
+                value >>= 7;
+                size++;
+            }
+            return size;
+        }
+
+        inline uint8_t * IRAM_ATTR putVarint(uint8_t *out, uint64_t value){
+            while (value >= 0x80){
+                *out++ = static_cast<uint8_t>(value) | 0x80;
+                value >>= 7;
+            }
+            *out++ = static_cast<uint8_t>(value);
+            return out;
+        }
+
+        /**
+         * @brief Bounds-checked reader of a recorded stream
+         */
+        struct Reader {
+            const uint8_t *data;
+            size_t size;
+            size_t position;
+
+            bool byte(uint8_t &value){
+                if (position >= size){
+                    return false;
+                }
+                value = data[position++];
+                return true;
+            }
+
+            bool varint(uint64_t &value){
+                value = 0;
+                for (size_t shift = 0; shift < 7 * MAX_VARINT; shift += 7){
+                    uint8_t next;
+                    if (!byte(next)){
+                        return false;
+                    }
+                    value |= static_cast<uint64_t>(next & 0x7F) << shift;
+                    if ((next & 0x80) == 0){
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool bytes(std::span<const uint8_t> &value){
+                uint64_t length;
+                if (!varint(length) || length > size - position){
+                    return false;
+                }
+                value = {data + position, static_cast<size_t>(length)};
+                position += length;
+                return true;
+            }
+        };
+
+        template<typename Segments>
+        size_t totalSize(Segments segments){
+            size_t total{0};
+            for (const auto &segment : segments){
+                total += segment.size();
+            }
+            return total;
+        }
+
+        template<typename Segments>
+        uint8_t *putSegments(uint8_t *out, Segments segments){
+            out = putVarint(out, totalSize(segments));
+            for (const auto &segment : segments){
+                memcpy(out, segment.data(), segment.size());
+                out += segment.size();
+            }
+            return out;
+        }
+    }
+
+    /**
+     * @brief Construct a recorder writing into a buffer
+     * 
+     * @param buffer Destination of the stream, in internal RAM
+     * @param size Size of buffer, at least HEADER_SIZE
+     */
+    Recorder::Recorder(uint8_t *buffer, size_t size) : _buffer(buffer), _size(size){
+    }
+
+    /**
+     * @brief Stops recording if this recorder is active
+     */
+    Recorder::~Recorder(){
+        Stop();
+    }
+
+    /**
+     * @brief Start a new stream and make this the active recorder
+     * 
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if another recorder is active,
+     *         ESP_ERR_INVALID_SIZE if the buffer cannot hold the header, error code if the Timebase
+     *         could not be started
+     */
+    esp_err_t Recorder::Start(void){
+        if (_buffer == nullptr || _size < HEADER_SIZE){
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        esp_err_t status = Timebase::Start();
+        if (status != ESP_OK){
+            return status;
+        }
+
+        taskENTER_CRITICAL(&active_mutex);
+        if (active.load(std::memory_order_relaxed) != nullptr){
+            status = ESP_ERR_INVALID_STATE;
+        } else {
+            _last_us = Timebase::Now();
+            _dropped = 0;
+            uint8_t *out = _buffer;
+            for (size_t i = 0; i < 4; i++){
+                *out++ = static_cast<uint8_t>(STREAM_MAGIC >> (8 * i));
+            }
+            *out++ = STREAM_VERSION;
+            *out++ = 0;
+            *out++ = 0;
+            *out++ = 0;
+            for (size_t i = 0; i < 8; i++){
+                *out++ = static_cast<uint8_t>(static_cast<uint64_t>(_last_us) >> (8 * i));
+            }
+            _length = HEADER_SIZE;
+            active.store(this, std::memory_order_release);
+        }
+        taskEXIT_CRITICAL(&active_mutex);
+        return status;
+    }
+
+    /**
+     * @brief Stop recording, the stream is kept
+     * 
+     * A hook may have loaded this recorder just before it was cleared, so
+     * Stop() waits until no hook is in flight. A hook preempted on this
+     * core gets to run while Stop() sleeps a tick.
+     * 
+     * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if this recorder is not active
+     */
+    esp_err_t Recorder::Stop(void){
+        esp_err_t status{ESP_OK};
+        taskENTER_CRITICAL(&active_mutex);
+        if (active.load(std::memory_order_relaxed) != this){
+            status = ESP_ERR_INVALID_STATE;
+        } else {
+            active.store(nullptr, std::memory_order_seq_cst);
+        }
+        taskEXIT_CRITICAL(&active_mutex);
+
+        if (status == ESP_OK){
+            while (in_flight.load(std::memory_order_seq_cst) != 0){
+                vTaskDelay(1);
+            }
+        }
+        return status;
+    }
+
+    /**
+     * @brief Reserve room for an event and write its type and time delta
+     * 
+     * Must be called with _mutex held.
+     * 
+     * @param type Kind of event
+     * @param length Bytes of the event fields after the time delta
+     * @param now_us esp_timer time of the event
+     * @param out Set to where the event fields go
+     * @return bool False if the event does not fit and was counted as dropped
+     */
+    bool IRAM_ATTR Recorder::_reserve(EventType type, size_t length, int64_t now_us, uint8_t *&out){
+        const uint64_t delta = zigzag(now_us - _last_us);
+        if (_length + 1 + varintSize(delta) + length > _size){
+            _dropped++;
+            return false;
+        }
+        _last_us = now_us;
+        out = _buffer + _length;
+        *out++ = static_cast<uint8_t>(type);
+        out = putVarint(out, delta);
+        _length = (out - _buffer) + length;
+        return true;
+    }
+
+    /**
+     * @brief Append a GPIO edge, callable from an ISR
+     * 
+     * @param pin GPIO that interrupted
+     * @param level Level of the pin
+     */
+    void IRAM_ATTR Recorder::AddEdge(gpio_num_t pin, int level){
+        const int64_t now_us = Timebase::Now();
+        uint8_t *out;
+        taskENTER_CRITICAL_ISR(&_mutex);
+        if (_reserve(EventType::EDGE, EDGE_FIELDS, now_us, out)){
+            out[0] = static_cast<uint8_t>(pin);
+            out[1] = static_cast<uint8_t>(level);
+        }
+        taskEXIT_CRITICAL_ISR(&_mutex);
+    }
+
+    /**
+     * @brief Append a completed I2C transaction
+     * 
+     * Only the room and the fixed fields are written under the lock, the
+     * payload is copied after it is released so long transfers do not keep
+     * the GPIO ISR waiting. The reserved bytes belong to this call alone.
+     * 
+     * @param port I2C port
+     * @param dev_addr 7-bit device address
+     * @param status Result of the transaction
+     * @param start_us esp_timer time the transaction was issued
+     * @param duration_us Time until it completed
+     * @param tx Segments written
+     * @param rx Segments read
+     */
+    void Recorder::AddTransaction(i2c_port_t port, uint8_t dev_addr, esp_err_t status, int64_t start_us, uint32_t duration_us,
+                                  std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx){
+        const uint64_t encoded_status = zigzag(status);
+        const size_t tx_size = totalSize(tx);
+        const size_t rx_size = totalSize(rx);
+        const size_t length = 2 + varintSize(encoded_status) + varintSize(duration_us) +
+                              varintSize(tx_size) + tx_size + varintSize(rx_size) + rx_size;
+
+        uint8_t *out;
+        taskENTER_CRITICAL(&_mutex);
+        const bool reserved = _reserve(EventType::TRANSACTION, length, start_us, out);
+        taskEXIT_CRITICAL(&_mutex);
+        if (reserved){
+            *out++ = static_cast<uint8_t>(port);
+            *out++ = dev_addr;
+            out = putVarint(out, encoded_status);
+            out = putVarint(out, duration_us);
+            out = putSegments(out, tx);
+            putSegments(out, rx);
+        }
+    }
+
+    /**
+     * @brief Get the recorded stream
+     * 
+     * @return const uint8_t* Start of the stream
+     */
+    const uint8_t *Recorder::GetData(void) const{
+        return _buffer;
+    }
+
+    /**
+     * @brief Get the length of the recorded stream
+     * 
+     * @return size_t Bytes recorded, including the header
+     */
+    size_t Recorder::GetSize(void) const{
+        return _length;
+    }
+
+    /**
+     * @brief Get the number of events that did not fit
+     * 
+     * @return uint32_t Dropped events since Start()
+     */
+    uint32_t Recorder::GetDropped(void) const{
+        return _dropped;
+    }
+
+#ifdef CONFIG_TRACE_ENABLE
+    /**
+     * @brief Record a GPIO edge with the active recorder, callable from an ISR
+     * 
+     * @param pin GPIO that interrupted
+     * @param level Raw level the ISR read from the input register
+     */
+    void IRAM_ATTR RecordEdge(gpio_num_t pin, uint32_t level){
+        in_flight.fetch_add(1, std::memory_order_seq_cst);
+        Recorder *recorder = active.load(std::memory_order_seq_cst);
+        if (recorder != nullptr){
+            recorder->AddEdge(pin, level);
+        }
+        in_flight.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Record an I2C transaction with the active recorder
+     * 
+     * @param port I2C port
+     * @param dev_addr 7-bit device address
+     * @param status Result of the transaction
+     * @param start_us esp_timer time the transaction was issued
+     * @param duration_us Time until it completed
+     * @param tx Segments written
+     * @param rx Segments read
+     */
+    void RecordTransaction(i2c_port_t port, uint8_t dev_addr, esp_err_t status, int64_t start_us, uint32_t duration_us,
+                           std::span<const std::span<const uint8_t>> tx, std::span<const std::span<uint8_t>> rx){
+        in_flight.fetch_add(1, std::memory_order_seq_cst);
+        Recorder *recorder = active.load(std::memory_order_seq_cst);
+        if (recorder != nullptr){
+            recorder->AddTransaction(port, dev_addr, status, start_us, duration_us, tx, rx);
+        }
+        in_flight.fetch_sub(1, std::memory_order_release);
+    }
+#endif
+
+    /**
+     * @brief Construct a replayer over a recorded stream
+     * 
+     * @param data Stream as produced by a Recorder
+     * @param size Length of the stream
+     */
+    Replayer::Replayer(const uint8_t *data, size_t size) : _data(data), _size(size){
+    }
+
+    /**
+     * @brief Check the stream header
+     * 
+     * @return esp_err_t ESP_OK if the stream is valid, ESP_ERR_INVALID_VERSION for an unknown version,
+     *         ESP_ERR_INVALID_RESPONSE otherwise
+     */
+    esp_err_t Replayer::Validate(void) const{
+        if (_data == nullptr || _size < HEADER_SIZE){
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        uint32_t magic{0};
+        for (size_t i = 0; i < 4; i++){
+            magic |= static_cast<uint32_t>(_data[i]) << (8 * i);
+        }
+        if (magic != STREAM_MAGIC){
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        return _data[4] == STREAM_VERSION ? ESP_OK : ESP_ERR_INVALID_VERSION;
+    }
+
+    /**
+     * @brief Decode the next event
+     * 
+     * @param event Filled with the event
+     * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND at the end of the stream,
+     *         ESP_ERR_INVALID_RESPONSE if the stream is corrupt
+     */
+    esp_err_t Replayer::Next(Event &event){
+        esp_err_t status = Validate();
+        if (status != ESP_OK){
+            return status;
+        }
+        if (_position >= _size){
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        Reader reader{_data, _size, _position};
+        uint8_t type;
+        uint64_t delta;
+        bool valid = reader.byte(type) && reader.varint(delta);
+        event = Event{};
+        event.type = static_cast<EventType>(type);
+        event.timestamp_us = _timestamp_us + unzigzag(delta);
+
+        if (valid && event.type == EventType::EDGE){
+            uint8_t pin;
+            valid = reader.byte(pin) && reader.byte(event.level);
+            event.pin = static_cast<gpio_num_t>(pin);
+        } else if (valid && event.type == EventType::TRANSACTION){
+            uint8_t port;
+            uint64_t encoded_status;
+            uint64_t duration;
+            valid = reader.byte(port) && reader.byte(event.dev_addr) && reader.varint(encoded_status) &&
+                    reader.varint(duration) && reader.bytes(event.tx) && reader.bytes(event.rx);
+            event.port = static_cast<i2c_port_t>(port);
+            event.status = static_cast<esp_err_t>(unzigzag(encoded_status));
+            event.duration_us = static_cast<uint32_t>(duration);
+        } else {
+            valid = false;
+        }
+
+        if (!valid){
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        _position = reader.position;
+        _timestamp_us = event.timestamp_us;
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Go back to the first event
+     */
+    void Replayer::Rewind(void){
+        _position = HEADER_SIZE;
+        _timestamp_us = 0;
+    }
+
+    /**
+     * @brief Deliver every remaining event at its recorded time
+     * 
+     * Long gaps are slept through, the last tick before an event is spun so
+     * deliveries land close to their scheduled time.
+     * 
+     * @param handler Called for every event
+     * @param context Passed to the handler
+     * @param speedup Time compression, 1 for real time, 0 to deliver without pacing
+     * @param stats Optional, filled with the timing of the replay
+     * @return esp_err_t ESP_OK once the stream is exhausted, the decoding or handler error otherwise
+     */
+    esp_err_t Replayer::Run(EventHandler handler, void *context, uint32_t speedup, ReplayStats *stats){
+        if (handler == nullptr){
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        ReplayStats run{};
+        const int64_t start_us = esp_timer_get_time();
+        int64_t first_us{-1};
+        Event event;
+        esp_err_t status;
+        while ((status = Next(event)) == ESP_OK){
+            if (first_us < 0){
+                first_us = event.timestamp_us;
+            }
+            if (speedup > 0){
+                const int64_t target_us = start_us + (event.timestamp_us - first_us) / speedup;
+                const int64_t sleep_us = target_us - esp_timer_get_time() - portTICK_PERIOD_MS * 1000;
+                if (sleep_us > 0){
+                    vTaskDelay(static_cast<TickType_t>(sleep_us / (portTICK_PERIOD_MS * 1000)));
+                }
+                int64_t now_us;
+                while ((now_us = esp_timer_get_time()) < target_us){
+                }
+                if (now_us - target_us > run.max_lateness_us){
+                    run.max_lateness_us = now_us - target_us;
+                }
+            }
+            status = handler(event, context);
+            if (status != ESP_OK){
+                break;
+            }
+            run.events++;
+        }
+
+        run.elapsed_us = esp_timer_get_time() - start_us;
+        if (stats != nullptr){
+            *stats = run;
+        }
+        return status == ESP_ERR_NOT_FOUND ? ESP_OK : status;
+    }
+
+    /**
+     * @brief Drive a recorded edge onto a pin
+     * 
+     * @param event EDGE event
+     * @param pin Output to drive, a loopback of the input under test
+     * @return esp_err_t Result of gpio_set_level(), ESP_ERR_INVALID_ARG for other events
+     */
+    esp_err_t ReplayEdge(const Event &event, gpio_num_t pin){
+        if (event.type != EventType::EDGE){
+            return ESP_ERR_INVALID_ARG;
+        }
+        return gpio_set_level(pin, event.level);
+    }
+
+    /**
+     * @brief Issue a recorded transaction again on a bus
+     * 
+     * @param i2c Bus to issue the transaction on
+     * @param event TRANSACTION event
+     * @param rx_buffer Receives the bytes read
+     * @param rx_size Size of rx_buffer
+     * @return esp_err_t Result of the transaction, ESP_ERR_INVALID_ARG for other events,
+     *         ESP_ERR_INVALID_SIZE if rx_buffer is too small
+     */
+    esp_err_t ReplayTransaction(I2C::I2c &i2c, const Event &event, uint8_t *rx_buffer, size_t rx_size){
+        if (event.type != EventType::TRANSACTION){
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (event.rx.size() > rx_size){
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        const std::span<const uint8_t> tx[1] {event.tx};
+        const std::span<uint8_t> rx[1] {{rx_buffer, event.rx.size()}};
+        if (event.rx.empty()){
+            return i2c.Write(event.dev_addr, tx);
+        }
+        if (event.tx.empty()){
+            return i2c.Read(event.dev_addr, rx[0]);
+        }
+        return i2c.WriteRead(event.dev_addr, tx, rx);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef TEST_LOOPBACK_H
+#define TEST_LOOPBACK_H
+
+#include <unity.h>
+#include "gpio.h"
+
+// Free pins of the test board used as loopbacks. Each one is driven and
+// sensed at once, so every level change the test makes is an edge on the input.
+static const gpio_num_t LOOPBACK_PIN_A = GPIO_NUM_27;
+static const gpio_num_t LOOPBACK_PIN_B = GPIO_NUM_14;
+static const gpio_num_t LOOPBACK_PIN_C = GPIO_NUM_33;
+
+// Initializes an input on a loopback pin and drives it low
+static inline void loopback_init(GPIO::GpioInput &input, gpio_num_t pin) {
+    TEST_ASSERT_EQUAL(ESP_OK, input.init(pin));
+    TEST_ASSERT_EQUAL(ESP_OK, gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT));
+    gpio_set_level(pin, 0);
+}
+
+// Same as loopback_init, then enables interrupts on both edges
+static inline void loopback_init_interrupt(GPIO::GpioInput &input, gpio_num_t pin) {
+    loopback_init(input, pin);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+}
+
+#endif
@@ -2,6 +2,8 @@
 #include "gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_rom_sys.h"
+#include "loopback.h"
 
 using namespace GPIO;
 
@@ -214,6 +216,117 @@ void test_gpio_handler_priority() {
     vQueueDelete(gpio_queue);
 }
 
+void test_gpio_isr_budget() {
+    GpioInput input(LOOPBACK_PIN_A);
+    loopback_init(input, LOOPBACK_PIN_A);
+    QueueHandle_t gpio_queue = xQueueCreate(20, sizeof(int32_t));
+    input.setQueueHandle(gpio_queue);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    IsrBudgetRecord record;
+    while (GpioInput::readIsrBudgetLog(record)) {
+    }
+
+    // No handler fits in one cycle
+    TEST_ASSERT_EQUAL(ESP_OK, input.setIsrBudget(1));
+    for (int i = 0; i < 4; i++) {
+        gpio_set_level(LOOPBACK_PIN_A, (i + 1) % 2);
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL(4, input.getIsrOverBudgetCount());
+    TEST_ASSERT_GREATER_THAN(1, input.getIsrWorstCycles());
+
+    int64_t last_us = 0;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(GpioInput::readIsrBudgetLog(record));
+        printf("pin %d over budget: %lu cycles at %lld us\n", record.pin,
+               static_cast<unsigned long>(record.cycles), static_cast<long long>(record.timestamp_us));
+        TEST_ASSERT_EQUAL(LOOPBACK_PIN_A, record.pin);
+        TEST_ASSERT_LESS_OR_EQUAL(input.getIsrWorstCycles(), record.cycles);
+        TEST_ASSERT_GREATER_THAN(last_us, record.timestamp_us);
+        last_us = record.timestamp_us;
+    }
+    TEST_ASSERT_FALSE(GpioInput::readIsrBudgetLog(record));
+
+    // A generous budget keeps the worst case but logs nothing
+    input.resetIsrBudgetStats();
+    TEST_ASSERT_EQUAL(ESP_OK, input.setIsrBudget(1000000));
+    for (int i = 0; i < 4; i++) {
+        gpio_set_level(LOOPBACK_PIN_A, (i + 1) % 2);
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL(0, input.getIsrOverBudgetCount());
+    TEST_ASSERT_GREATER_THAN(0, input.getIsrWorstCycles());
+    TEST_ASSERT_FALSE(GpioInput::readIsrBudgetLog(record));
+
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    vQueueDelete(gpio_queue);
+}
+
+void test_gpio_coalescing() {
+    GpioInput input(LOOPBACK_PIN_A);
+    loopback_init(input, LOOPBACK_PIN_A);
+    QueueHandle_t gpio_queue = xQueueCreate(20, sizeof(CoalescedEvent));
+    input.setQueueHandle(gpio_queue);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, input.enableCoalescing(0));
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableCoalescing(50000));
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    // 1 kHz of edges for 200 ms, plus one to end high
+    const int edges = 200;
+    for (int i = 0; i < edges; i++) {
+        gpio_set_level(LOOPBACK_PIN_A, (i + 1) % 2);
+        esp_rom_delay_us(1000);
+    }
+    gpio_set_level(LOOPBACK_PIN_A, 1);
+    vTaskDelay(pdMS_TO_TICKS(120));
+
+    // At most one event per 50 ms window, together carrying every edge
+    const UBaseType_t events = uxQueueMessagesWaiting(gpio_queue);
+    printf("%d edges delivered as %u events\n", edges + 1, static_cast<unsigned>(events));
+    TEST_ASSERT_LESS_OR_EQUAL(6, events);
+    uint32_t total = 0;
+    CoalescedEvent event;
+    while (xQueueReceive(gpio_queue, &event, 0) == pdTRUE) {
+        TEST_ASSERT_EQUAL(LOOPBACK_PIN_A, event.pin);
+        total += event.edges;
+    }
+    TEST_ASSERT_EQUAL(edges + 1, total);
+    TEST_ASSERT_EQUAL(1, event.level);
+
+    // Idle windows deliver nothing
+    vTaskDelay(pdMS_TO_TICKS(120));
+    TEST_ASSERT_EQUAL(0, uxQueueMessagesWaiting(gpio_queue));
+
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableCoalescing());
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    vQueueDelete(gpio_queue);
+}
+
+void test_gpio_coalescing_teardown() {
+    // A one-slot queue makes most windows fail to deliver while the input is destroyed under it
+    QueueHandle_t gpio_queue = xQueueCreate(1, sizeof(CoalescedEvent));
+    for (int round = 0; round < 20; round++) {
+        GpioInput *input = new GpioInput(LOOPBACK_PIN_A);
+        loopback_init(*input, LOOPBACK_PIN_A);
+        input->setQueueHandle(gpio_queue);
+        TEST_ASSERT_EQUAL(ESP_OK, input->enableCoalescing(100));
+        TEST_ASSERT_EQUAL(ESP_OK, input->enableInterrupt(GPIO_INTR_ANYEDGE));
+        for (int i = 0; i < 20; i++) {
+            gpio_set_level(LOOPBACK_PIN_A, (i + 1) % 2);
+            esp_rom_delay_us(70);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, input->disableInterrupt());
+        delete input;
+    }
+
+    // Nothing arrives once the inputs are gone
+    xQueueReset(gpio_queue);
+    vTaskDelay(2);
+    TEST_ASSERT_EQUAL(0, uxQueueMessagesWaiting(gpio_queue));
+    vQueueDelete(gpio_queue);
+}
+
 void RUN_UNITY_TESTS() {
     UNITY_BEGIN();
     
@@ -228,6 +341,9 @@ void RUN_UNITY_TESTS() {
     RUN_TEST(test_gpio_custom_event_handler);
     RUN_TEST(test_gpio_queue_handler);
     RUN_TEST(test_gpio_handler_priority);
+    RUN_TEST(test_gpio_isr_budget);
+    RUN_TEST(test_gpio_coalescing);
+    RUN_TEST(test_gpio_coalescing_teardown);
     
     UNITY_END();
 }
@@ -0,0 +1,233 @@
+#include <unity.h>
+#include "gpio.h"
+#include "gpio_batch.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "loopback.h"
+
+using namespace GPIO;
+
+static const gpio_num_t edge_pin = LOOPBACK_PIN_A;
+
+static const int bench_edges = 50000;       // One second at 50k edges/s
+static const int64_t edge_period_us = 20;
+
+static volatile bool driving = false;
+static volatile uint32_t received = 0;
+static volatile uint32_t receives = 0;
+static volatile bool consuming = false;
+
+// Paces edges against esp_timer so both paths see exactly the same input
+static void drive_task(void *arg) {
+    const int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < bench_edges; i++) {
+        while (esp_timer_get_time() < start_us + i * edge_period_us) {
+        }
+        gpio_set_level(edge_pin, (i + 1) % 2);
+    }
+    driving = false;
+    vTaskDelete(nullptr);
+}
+
+static void edge_consumer_task(void *arg) {
+    QueueHandle_t queue = static_cast<QueueHandle_t>(arg);
+    int32_t pin;
+    while (consuming) {
+        if (xQueueReceive(queue, &pin, pdMS_TO_TICKS(10)) == pdTRUE) {
+            receives++;
+            received++;
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+static GpioBatch *bench_batch = nullptr;
+
+static void block_consumer_task(void *arg) {
+    QueueHandle_t queue = static_cast<QueueHandle_t>(arg);
+    EdgeBlock *block;
+    while (consuming) {
+        if (xQueueReceive(queue, &block, pdMS_TO_TICKS(10)) == pdTRUE) {
+            receives++;
+            received += block->count;
+            bench_batch->release(block);
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+// Drives the benchmark edges from core 1 while the consumer shares core 0 with the ISR
+static void run_bench(GpioInput &input, TaskFunction_t consumer, QueueHandle_t queue) {
+    received = 0;
+    receives = 0;
+    consuming = true;
+    driving = true;
+    xTaskCreatePinnedToCore(consumer, "consumer", 3072, queue, 5, nullptr, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+    xTaskCreatePinnedToCore(drive_task, "drive", 2048, nullptr, 10, nullptr, 1);
+    while (driving) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+}
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_batch_deadline_flush() {
+    GpioBatch batch;
+    GpioInput input;
+    loopback_init(input, edge_pin);
+    QueueHandle_t queue = xQueueCreate(4, sizeof(EdgeBlock *));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, batch.start(nullptr, 10000));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, batch.start(queue, GpioBatch::MIN_DEADLINE_US - 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, input.setBatch(nullptr));
+    TEST_ASSERT_EQUAL(ESP_OK, batch.start(queue, 10000));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, batch.start(queue, 10000));
+    TEST_ASSERT_EQUAL(ESP_OK, input.setBatch(&batch));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, input.enableCoalescing(1000));
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    // A partial block arrives within the deadline
+    for (int i = 0; i < 5; i++) {
+        gpio_set_level(edge_pin, (i + 1) % 2);
+        esp_rom_delay_us(100);
+    }
+    EdgeBlock *block = nullptr;
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(queue, &block, pdMS_TO_TICKS(20)));
+    TEST_ASSERT_EQUAL(5, block->count);
+    for (size_t i = 0; i < block->count; i++) {
+        TEST_ASSERT_EQUAL(edge_pin, block->records[i].pin);
+        TEST_ASSERT_EQUAL((i + 1) % 2, block->records[i].level);
+        if (i > 0) {
+            TEST_ASSERT_GREATER_OR_EQUAL(block->records[i - 1].timestamp_us, block->records[i].timestamp_us);
+        }
+    }
+    TEST_ASSERT_EQUAL(1, batch.getPoolStats().in_use);
+    batch.release(block);
+    TEST_ASSERT_EQUAL(0, batch.getPoolStats().in_use);
+
+    // Full blocks are handed off without waiting for the deadline
+    for (size_t i = 0; i < EDGE_BLOCK_RECORDS + 3; i++) {
+        gpio_set_level(edge_pin, (i + 1) % 2);
+        esp_rom_delay_us(100);
+    }
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(queue, &block, 0));
+    TEST_ASSERT_EQUAL(EDGE_BLOCK_RECORDS, block->count);
+    batch.release(block);
+
+    // Stopping hands off the rest
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    TEST_ASSERT_EQUAL(ESP_OK, batch.stop());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, batch.stop());
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(queue, &block, 0));
+    TEST_ASSERT_EQUAL(3, block->count);
+    batch.release(block);
+
+    const BatchStats stats = batch.getStats();
+    TEST_ASSERT_EQUAL(3, stats.blocks);
+    TEST_ASSERT_EQUAL(5 + EDGE_BLOCK_RECORDS + 3, stats.edges);
+    TEST_ASSERT_EQUAL(0, stats.drops);
+    vQueueDelete(queue);
+}
+
+void test_batch_teardown() {
+    // The shortest deadline keeps the deadline callback busy while the batch is destroyed under it
+    QueueHandle_t queue = xQueueCreate(4, sizeof(EdgeBlock *));
+    GpioInput input;
+    loopback_init(input, edge_pin);
+    for (int round = 0; round < 20; round++) {
+        GpioBatch *batch = new GpioBatch();
+        TEST_ASSERT_EQUAL(ESP_OK, batch->start(queue, GpioBatch::MIN_DEADLINE_US));
+        TEST_ASSERT_EQUAL(ESP_OK, input.setBatch(batch));
+        TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+        for (int i = 0; i < 20; i++) {
+            gpio_set_level(edge_pin, (i + 1) % 2);
+            esp_rom_delay_us(30);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+        delete batch;
+        xQueueReset(queue);
+    }
+
+    // Nothing arrives once the batches are gone
+    vTaskDelay(2);
+    TEST_ASSERT_EQUAL(0, uxQueueMessagesWaiting(queue));
+    vQueueDelete(queue);
+}
+
+void test_batch_throughput_at_50k_edges() {
+    // Per-edge queue items
+    GpioInput single;
+    loopback_init(single, edge_pin);
+    QueueHandle_t edge_queue = xQueueCreate(64, sizeof(int32_t));
+    single.setQueueHandle(edge_queue);
+    run_bench(single, edge_consumer_task, edge_queue);
+    const uint32_t single_received = received;
+    const uint32_t single_receives = receives;
+    consuming = false;
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    // Blocks of EDGE_BLOCK_RECORDS edges
+    GpioBatch batch;
+    bench_batch = &batch;
+    GpioInput batched;
+    loopback_init(batched, edge_pin);
+    QueueHandle_t block_queue = xQueueCreate(GpioBatch::POOL_BLOCKS, sizeof(EdgeBlock *));
+    TEST_ASSERT_EQUAL(ESP_OK, batch.start(block_queue, 5000));
+    TEST_ASSERT_EQUAL(ESP_OK, batched.setBatch(&batch));
+    run_bench(batched, block_consumer_task, block_queue);
+    TEST_ASSERT_EQUAL(ESP_OK, batch.stop());
+    vTaskDelay(pdMS_TO_TICKS(50));
+    const uint32_t batch_received = received;
+    const uint32_t batch_receives = receives;
+    consuming = false;
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    const BatchStats stats = batch.getStats();
+    printf("Per-edge: %lu/%d edges, %lu receives; batched: %lu/%d edges, %lu receives, %lu dropped, pool high water %u\n",
+           static_cast<unsigned long>(single_received), bench_edges, static_cast<unsigned long>(single_receives),
+           static_cast<unsigned long>(batch_received), bench_edges, static_cast<unsigned long>(batch_receives),
+           static_cast<unsigned long>(stats.drops), static_cast<unsigned>(batch.getPoolStats().high_water));
+
+    // The consumer takes one queue item per block and gets every edge that was handed off
+    TEST_ASSERT_EQUAL(stats.blocks, batch_receives);
+    TEST_ASSERT_EQUAL(stats.edges, batch_received);
+    TEST_ASSERT_EQUAL(0, batch.getPoolStats().in_use);
+
+    vQueueDelete(edge_queue);
+    vQueueDelete(block_queue);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_batch_deadline_flush);
+    RUN_TEST(test_batch_teardown);
+    RUN_TEST(test_batch_throughput_at_50k_edges);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
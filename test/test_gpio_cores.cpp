@@ -0,0 +1,185 @@
+#include <unity.h>
+#include "gpio.h"
+#include "gpio_cores.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "loopback.h"
+
+using namespace GPIO;
+
+static const gpio_num_t edge_pin = LOOPBACK_PIN_A;
+
+static const int bench_edges = 200;
+static const BaseType_t consumer_core = 1;
+
+static volatile int64_t driven_us = 0;
+static volatile int64_t latency_total_us = 0;
+static volatile uint32_t consumed = 0;
+static volatile bool consuming = false;
+
+// Wakes on every edge on the consumer core and measures the time since the edge was driven
+static void consumer_task(void *arg) {
+    QueueHandle_t queue = static_cast<QueueHandle_t>(arg);
+    int32_t pin;
+    while (consuming) {
+        if (xQueueReceive(queue, &pin, pdMS_TO_TICKS(10)) == pdTRUE) {
+            latency_total_us += esp_timer_get_time() - driven_us;
+            consumed++;
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+static void IRAM_ATTR count_handler(void *arg) {
+    (*static_cast<volatile uint32_t *>(arg))++;
+}
+
+// Drives edges from core 0 to a consumer on core 1, returns the average wake-up latency in us
+static int64_t run_latency(BaseType_t interrupt_core) {
+    GpioInput input;
+    loopback_init(input, edge_pin);
+    QueueHandle_t queue = xQueueCreate(4, sizeof(int32_t));
+    input.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, input.setInterruptCore(interrupt_core));
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    latency_total_us = 0;
+    consumed = 0;
+    consuming = true;
+    xTaskCreatePinnedToCore(consumer_task, "consumer", 2048, queue, 10, nullptr, consumer_core);
+    vTaskDelay(1);
+
+    for (int i = 0; i < bench_edges; i++) {
+        driven_us = esp_timer_get_time();
+        gpio_set_level(edge_pin, (i + 1) % 2);
+        vTaskDelay(1);
+    }
+    consuming = false;
+    vTaskDelay(pdMS_TO_TICKS(20));
+
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    TEST_ASSERT_EQUAL(bench_edges, consumed);
+    vQueueDelete(queue);
+    return latency_total_us / bench_edges;
+}
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_cores_route_pin() {
+    GpioInput input;
+    loopback_init(input, edge_pin);
+    QueueHandle_t queue = xQueueCreate(16, sizeof(int32_t));
+    input.setQueueHandle(queue);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, input.setInterruptCore(portNUM_PROCESSORS));
+    TEST_ASSERT_EQUAL(ESP_OK, input.setInterruptCore(consumer_core));
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, input.setInterruptCore(tskNO_AFFINITY));
+
+    // The test task installed the service on core 0, the pin is dispatched on core 1
+    TEST_ASSERT_EQUAL(0, GpioInput::getInterruptServiceCore());
+    const uint32_t dispatches = GpioCores::getDispatchCount(consumer_core);
+    for (int i = 0; i < 10; i++) {
+        gpio_set_level(edge_pin, (i + 1) % 2);
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL(10, uxQueueMessagesWaiting(queue));
+    TEST_ASSERT_EQUAL(dispatches + 10, GpioCores::getDispatchCount(consumer_core));
+
+    // Disabled pins leave the core's table
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, GpioCores::detach(edge_pin));
+    gpio_set_level(edge_pin, 1);
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL(10, uxQueueMessagesWaiting(queue));
+
+    // Back on the service core
+    TEST_ASSERT_EQUAL(ESP_OK, input.setInterruptCore(tskNO_AFFINITY));
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+    gpio_set_level(edge_pin, 0);
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL(11, uxQueueMessagesWaiting(queue));
+    TEST_ASSERT_EQUAL(dispatches + 10, GpioCores::getDispatchCount(consumer_core));
+
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    vQueueDelete(queue);
+}
+
+void test_cores_affine_latency() {
+    const int64_t cross_us = run_latency(tskNO_AFFINITY);
+    const int64_t affine_us = run_latency(consumer_core);
+
+    // Every edge reached the consumer both ways, the latencies are for information only
+    printf("Edge to consumer on core %d: %lld us from the service core, %lld us from its own core\n",
+           static_cast<int>(consumer_core), static_cast<long long>(cross_us), static_cast<long long>(affine_us));
+}
+
+void test_cores_service_conflict() {
+    TEST_ASSERT_EQUAL(ESP_OK, GpioInput::installInterruptService());
+    const BaseType_t service_core = GpioInput::getInterruptServiceCore();
+    TEST_ASSERT_EQUAL(0, service_core);
+    TEST_ASSERT_EQUAL(service_core, GpioCores::getServiceCore());
+
+    // The service's core is refused without touching the pin
+    GpioInput input;
+    loopback_init(input, edge_pin);
+    TEST_ASSERT_EQUAL(ESP_OK, gpio_set_intr_type(edge_pin, GPIO_INTR_ANYEDGE));
+    volatile uint32_t count = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, GpioCores::attach(edge_pin, service_core, count_handler, (void *)&count));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, GpioCores::detach(edge_pin));
+
+    // The other core takes the pin, and installing the service again does not move it there
+    TEST_ASSERT_EQUAL(ESP_OK, GpioCores::attach(edge_pin, consumer_core, count_handler, (void *)&count));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioCores::installService(consumer_core));
+    TEST_ASSERT_EQUAL(service_core, GpioCores::getServiceCore());
+    gpio_set_level(edge_pin, 1);
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL(ESP_OK, GpioCores::detach(edge_pin));
+    TEST_ASSERT_EQUAL(ESP_OK, gpio_set_intr_type(edge_pin, GPIO_INTR_DISABLE));
+
+    // A pin asking for the service's core is left to the service
+    QueueHandle_t queue = xQueueCreate(4, sizeof(int32_t));
+    input.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, input.setInterruptCore(service_core));
+    const uint32_t dispatches = GpioCores::getDispatchCount(service_core);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+    gpio_set_level(edge_pin, 0);
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL(1, uxQueueMessagesWaiting(queue));
+    TEST_ASSERT_EQUAL(dispatches, GpioCores::getDispatchCount(service_core));
+
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    vQueueDelete(queue);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_cores_route_pin);
+    RUN_TEST(test_cores_affine_latency);
+    RUN_TEST(test_cores_service_conflict);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
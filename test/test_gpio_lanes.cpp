@@ -0,0 +1,170 @@
+#include <unity.h>
+#include "gpio.h"
+#include "gpio_lanes.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "loopback.h"
+
+using namespace GPIO;
+
+static const gpio_num_t chatty_pin = LOOPBACK_PIN_A;
+static const gpio_num_t stop_pin = LOOPBACK_PIN_B;
+
+static const uint32_t low_handler_us = 50;
+static const int emergency_edges = 40;
+
+static volatile bool flooding = false;
+static volatile int64_t stop_driven_us = 0;
+static volatile uint32_t stop_events = 0;
+static volatile int64_t stop_latency_max_us = 0;
+static volatile uint32_t chatty_events = 0;
+
+static void chatty_handler(const LaneEvent &event, void *context) {
+    // Stands in for bulk processing of every edge
+    esp_rom_delay_us(low_handler_us);
+    chatty_events++;
+}
+
+static void stop_handler(const LaneEvent &event, void *context) {
+    const int64_t latency_us = esp_timer_get_time() - stop_driven_us;
+    if (latency_us > stop_latency_max_us) {
+        stop_latency_max_us = latency_us;
+    }
+    stop_events++;
+}
+
+static void counting_handler(const LaneEvent &event, void *context) {
+    (*static_cast<volatile uint32_t *>(context))++;
+}
+
+// Toggles the chatty pin as fast as the edges can be taken
+static void flood_task(void *arg) {
+    uint32_t level = 0;
+    while (flooding) {
+        level ^= 1;
+        gpio_set_level(chatty_pin, level);
+        esp_rom_delay_us(10);
+    }
+    vTaskDelete(nullptr);
+}
+
+// Floods the chatty pin while driving emergency edges, returns the worst emergency latency, INT64_MAX if any was lost
+static int64_t run_stress(PriorityClass stop_class) {
+    // The test task must outrank the saturated LOW dispatcher on its core
+    const UBaseType_t priority = uxTaskPriorityGet(nullptr);
+    vTaskPrioritySet(nullptr, 10);
+
+    GpioInput chatty;
+    GpioInput stop;
+    loopback_init(chatty, chatty_pin);
+    loopback_init(stop, stop_pin);
+    TEST_ASSERT_EQUAL(ESP_OK, chatty.setLaneHandler(PriorityClass::LOW, chatty_handler, nullptr));
+    TEST_ASSERT_EQUAL(ESP_OK, stop.setLaneHandler(stop_class, stop_handler, nullptr));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLanes::start(PriorityClass::LOW, 2, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLanes::start(PriorityClass::HIGH, 20, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, chatty.enableInterrupt(GPIO_INTR_ANYEDGE));
+    TEST_ASSERT_EQUAL(ESP_OK, stop.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    stop_events = 0;
+    stop_latency_max_us = 0;
+    chatty_events = 0;
+    flooding = true;
+    xTaskCreatePinnedToCore(flood_task, "flood", 2048, nullptr, 3, nullptr, 1);
+
+    for (int i = 0; i < emergency_edges; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        stop_driven_us = esp_timer_get_time();
+        gpio_set_level(stop_pin, (i + 1) % 2);
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+    flooding = false;
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    TEST_ASSERT_EQUAL(ESP_OK, chatty.disableInterrupt());
+    TEST_ASSERT_EQUAL(ESP_OK, stop.disableInterrupt());
+    const LaneStats low = GpioLanes::getStats(PriorityClass::LOW);
+    printf("Emergency on %s lane: %lu/%d delivered, max latency %lld us; chatty %lu delivered, %lu dropped, high water %lu\n",
+           stop_class == PriorityClass::HIGH ? "HIGH" : "LOW", static_cast<unsigned long>(stop_events), emergency_edges,
+           static_cast<long long>(stop_latency_max_us), static_cast<unsigned long>(low.delivered),
+           static_cast<unsigned long>(low.drops), static_cast<unsigned long>(low.high_water));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLanes::stop(PriorityClass::LOW));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLanes::stop(PriorityClass::HIGH));
+    GpioLanes::unroute(chatty_pin);
+    GpioLanes::unroute(stop_pin);
+    vTaskPrioritySet(nullptr, priority);
+    return stop_events == emergency_edges ? stop_latency_max_us : INT64_MAX;
+}
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_lanes_route_and_deliver() {
+    volatile uint32_t events = 0;
+    GpioInput input;
+    loopback_init(input, chatty_pin);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, input.setLaneHandler(PriorityClass::NORMAL, nullptr, nullptr));
+    TEST_ASSERT_EQUAL(ESP_OK, input.setLaneHandler(PriorityClass::NORMAL, counting_handler, const_cast<uint32_t *>(&events)));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLanes::start(PriorityClass::NORMAL, 5));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, GpioLanes::start(PriorityClass::NORMAL, 5));
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    for (int i = 0; i < 10; i++) {
+        gpio_set_level(chatty_pin, (i + 1) % 2);
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL(10, events);
+    TEST_ASSERT_EQUAL(10, GpioLanes::getStats(PriorityClass::NORMAL).delivered);
+
+    // Switching to a queue takes the pin off its lane
+    QueueHandle_t queue = xQueueCreate(4, sizeof(int32_t));
+    input.setQueueHandle(queue);
+    gpio_set_level(chatty_pin, 1);
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL(10, events);
+    TEST_ASSERT_EQUAL(1, uxQueueMessagesWaiting(queue));
+
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLanes::stop(PriorityClass::NORMAL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, GpioLanes::stop(PriorityClass::NORMAL));
+    vQueueDelete(queue);
+}
+
+void test_lanes_emergency_latency_under_flood() {
+    const int64_t shared_us = run_stress(PriorityClass::LOW);
+    const int64_t separate_us = run_stress(PriorityClass::HIGH);
+
+    // On its own lane every emergency edge arrives, behind the flood it queues or drops
+    printf("Worst emergency latency: shared lane %lld us, own lane %lld us (%lld means an edge was lost)\n",
+           static_cast<long long>(shared_us), static_cast<long long>(separate_us), static_cast<long long>(INT64_MAX));
+    TEST_ASSERT_TRUE(separate_us != INT64_MAX);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_lanes_route_and_deliver);
+    RUN_TEST(test_lanes_emergency_latency_under_flood);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
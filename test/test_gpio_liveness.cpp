@@ -0,0 +1,165 @@
+#include <unity.h>
+#include "gpio.h"
+#include "gpio_liveness.h"
+#include "timebase.h"
+#include "esp_cpu.h"
+#include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "loopback.h"
+
+using namespace GPIO;
+
+static const gpio_num_t heartbeat_pin = LOOPBACK_PIN_A;
+static const gpio_num_t silent_pin = LOOPBACK_PIN_B;
+static const gpio_num_t flow_pin = LOOPBACK_PIN_C;
+
+static const uint32_t tick_us = 2000;
+static const uint32_t timeout_us = 50000;
+static const TickType_t settle_ticks = pdMS_TO_TICKS(20) + 1;  // A few wheel ticks
+static const int bench_posts = 1000;
+
+static volatile uint32_t lost_events[GPIO_NUM_MAX];
+static volatile uint32_t restored_events[GPIO_NUM_MAX];
+static volatile uint32_t last_silent_us = 0;
+static volatile bool beating = false;
+
+static void liveness_handler(void *handler_args, esp_event_base_t base, int32_t id, void *event_data) {
+    const LivenessEvent *event = static_cast<const LivenessEvent *>(event_data);
+    if (id == SIGNAL_LOST) {
+        lost_events[event->pin]++;
+    } else if (id == SIGNAL_RESTORED) {
+        restored_events[event->pin]++;
+    }
+    last_silent_us = event->silent_us;
+}
+
+// Toggles the heartbeat pin every RTOS tick until stopped
+static void heartbeat_task(void *arg) {
+    uint32_t level = 0;
+    while (beating) {
+        level ^= 1;
+        gpio_set_level(heartbeat_pin, level);
+        vTaskDelay(1);
+    }
+    vTaskDelete(nullptr);
+}
+
+void setUp(void) {
+    for (int i = 0; i < GPIO_NUM_MAX; i++) {
+        lost_events[i] = 0;
+        restored_events[i] = 0;
+    }
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_liveness_lost_and_restored() {
+    esp_event_loop_create_default();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register(LIVENESS_EVENTS, ESP_EVENT_ANY_ID, liveness_handler, nullptr));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, GpioLiveness::start(GpioLiveness::MIN_TICK_US - 1));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLiveness::start(tick_us));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, GpioLiveness::start(tick_us));
+
+    GpioInput heartbeat;
+    GpioInput silent;
+    loopback_init_interrupt(heartbeat, heartbeat_pin);
+    loopback_init_interrupt(silent, silent_pin);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, silent.enableLivenessMonitor(0));
+    TEST_ASSERT_EQUAL(ESP_OK, heartbeat.enableLivenessMonitor(timeout_us));
+    TEST_ASSERT_EQUAL(ESP_OK, silent.enableLivenessMonitor(timeout_us));
+
+    beating = true;
+    xTaskCreatePinnedToCore(heartbeat_task, "heartbeat", 2048, nullptr, 10, nullptr, 1);
+
+    // Ten timeouts of silence still post a single SIGNAL_LOST
+    vTaskDelay(pdMS_TO_TICKS(10 * timeout_us / 1000));
+    TEST_ASSERT_EQUAL(1, lost_events[silent_pin]);
+    TEST_ASSERT_TRUE(GpioLiveness::isLost(silent_pin));
+    TEST_ASSERT_EQUAL(0, lost_events[heartbeat_pin]);
+    TEST_ASSERT_FALSE(GpioLiveness::isLost(heartbeat_pin));
+
+    // One edge restores it, and it is lost again a timeout later
+    gpio_set_level(silent_pin, 1);
+    vTaskDelay(settle_ticks);
+    TEST_ASSERT_EQUAL(1, restored_events[silent_pin]);
+    TEST_ASSERT_GREATER_OR_EQUAL(10 * timeout_us, last_silent_us);
+    vTaskDelay(pdMS_TO_TICKS(2 * timeout_us / 1000));
+    TEST_ASSERT_EQUAL(2, lost_events[silent_pin]);
+
+    // Stopping the heartbeat is detected within a timeout and a tick
+    beating = false;
+    vTaskDelay(pdMS_TO_TICKS(2 * timeout_us / 1000));
+    TEST_ASSERT_EQUAL(1, lost_events[heartbeat_pin]);
+    TEST_ASSERT_LESS_OR_EQUAL(timeout_us + 2 * tick_us, last_silent_us);
+
+    // Unwatched pins post nothing
+    silent.disableLivenessMonitor();
+    gpio_set_level(silent_pin, 0);
+    vTaskDelay(settle_ticks);
+    TEST_ASSERT_EQUAL(1, restored_events[silent_pin]);
+    TEST_ASSERT_EQUAL(0, GpioLiveness::getDropCount());
+
+    TEST_ASSERT_EQUAL(ESP_OK, heartbeat.disableInterrupt());
+    TEST_ASSERT_EQUAL(ESP_OK, silent.disableInterrupt());
+    heartbeat.disableLivenessMonitor();
+    GpioLiveness::stop();
+    esp_event_handler_unregister(LIVENESS_EVENTS, ESP_EVENT_ANY_ID, liveness_handler);
+}
+
+void test_liveness_edge_cost() {
+    TEST_ASSERT_EQUAL(ESP_OK, Timebase::Start());
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLiveness::watch(heartbeat_pin, timeout_us));
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < bench_posts; i++) {
+        GpioLiveness::post(heartbeat_pin);
+    }
+    const uint32_t one_cycles = (esp_cpu_get_cycle_count() - start) / bench_posts;
+
+    // More watched pins leave an edge's work unchanged, printed for comparison
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLiveness::watch(silent_pin, timeout_us));
+    TEST_ASSERT_EQUAL(ESP_OK, GpioLiveness::watch(flow_pin, timeout_us));
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < bench_posts; i++) {
+        GpioLiveness::post(heartbeat_pin);
+    }
+    const uint32_t three_cycles = (esp_cpu_get_cycle_count() - start) / bench_posts;
+
+    printf("Liveness cost per edge: %lu cycles with one pin watched, %lu cycles with three\n",
+           static_cast<unsigned long>(one_cycles), static_cast<unsigned long>(three_cycles));
+
+    // Posting only stamps the edge, the watched pins stay alive and nothing was reported
+    TEST_ASSERT_FALSE(GpioLiveness::isLost(heartbeat_pin));
+    TEST_ASSERT_FALSE(GpioLiveness::isLost(silent_pin));
+    TEST_ASSERT_FALSE(GpioLiveness::isLost(flow_pin));
+    TEST_ASSERT_EQUAL(0, GpioLiveness::getDropCount());
+
+    GpioLiveness::unwatch(heartbeat_pin);
+    GpioLiveness::unwatch(silent_pin);
+    GpioLiveness::unwatch(flow_pin);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_liveness_lost_and_restored);
+    RUN_TEST(test_liveness_edge_cost);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
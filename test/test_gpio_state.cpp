@@ -0,0 +1,170 @@
+#include <unity.h>
+#include "gpio.h"
+#include "gpio_state.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "loopback.h"
+
+using namespace GPIO;
+
+static const gpio_num_t low_pin = LOOPBACK_PIN_A;
+static const gpio_num_t high_pin = LOOPBACK_PIN_C;
+
+static const int bench_polls = 200;
+static const int64_t edge_period_us = 50;   // 20k edges/s
+
+static volatile bool driving = false;
+
+// Toggles the low pin at a fixed rate until stopped
+static void drive_task(void *arg) {
+    const int64_t start_us = esp_timer_get_time();
+    uint32_t level = 0;
+    for (int64_t i = 0; driving; i++) {
+        while (esp_timer_get_time() < start_us + i * edge_period_us) {
+        }
+        level ^= 1;
+        gpio_set_level(low_pin, level);
+    }
+    vTaskDelete(nullptr);
+}
+
+// Runs one poll per tick while the low pin is flooded, returns the average cycles per poll
+template<typename Poll>
+static uint32_t run_bench(Poll poll) {
+    uint64_t total_cycles = 0;
+    driving = true;
+    xTaskCreatePinnedToCore(drive_task, "drive", 2048, nullptr, 10, nullptr, 1);
+    for (int i = 0; i < bench_polls; i++) {
+        vTaskDelay(1);
+        const uint32_t start = esp_cpu_get_cycle_count();
+        poll();
+        total_cycles += esp_cpu_get_cycle_count() - start;
+    }
+    driving = false;
+    vTaskDelay(pdMS_TO_TICKS(10));
+    return total_cycles / bench_polls;
+}
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_state_levels_and_changes() {
+    GpioInput low;
+    GpioInput high;
+    loopback_init(low, low_pin);
+    loopback_init(high, high_pin);
+    const uint64_t low_bit = 1ULL << low_pin;
+    const uint64_t high_bit = 1ULL << high_pin;
+
+    // Enabling records the current level as a change
+    TEST_ASSERT_EQUAL(ESP_OK, low.enableStateTracking());
+    TEST_ASSERT_EQUAL(ESP_OK, high.enableStateTracking());
+    TEST_ASSERT_EQUAL(ESP_OK, low.enableInterrupt(GPIO_INTR_ANYEDGE));
+    TEST_ASSERT_EQUAL(ESP_OK, high.enableInterrupt(GPIO_INTR_ANYEDGE));
+    PinStates states = GpioState::poll();
+    TEST_ASSERT_TRUE((states.changed & (low_bit | high_bit)) == (low_bit | high_bit));
+    TEST_ASSERT_TRUE((states.levels & (low_bit | high_bit)) == 0);
+
+    gpio_set_level(low_pin, 1);
+    vTaskDelay(1);
+    states = GpioState::poll();
+    TEST_ASSERT_TRUE((states.changed & (low_bit | high_bit)) == low_bit);
+    TEST_ASSERT_TRUE((states.levels & low_bit) != 0);
+
+    // Nothing changed since the fetch
+    TEST_ASSERT_TRUE((GpioState::fetchChanged() & (low_bit | high_bit)) == 0);
+
+    // The changed bit is sticky across several edges, the level follows the last one
+    for (int i = 0; i < 3; i++) {
+        gpio_set_level(high_pin, (i + 1) % 2);
+        vTaskDelay(1);
+    }
+    states = GpioState::poll();
+    TEST_ASSERT_TRUE((states.changed & (low_bit | high_bit)) == high_bit);
+    TEST_ASSERT_TRUE((states.levels & (low_bit | high_bit)) == (low_bit | high_bit));
+
+    // Untracked pins keep no bits
+    high.disableStateTracking();
+    gpio_set_level(high_pin, 0);
+    vTaskDelay(1);
+    states = GpioState::poll();
+    TEST_ASSERT_TRUE((states.changed & high_bit) == 0);
+    TEST_ASSERT_TRUE((states.levels & high_bit) == 0);
+
+    TEST_ASSERT_EQUAL(ESP_OK, low.disableInterrupt());
+    TEST_ASSERT_EQUAL(ESP_OK, high.disableInterrupt());
+    low.disableStateTracking();
+}
+
+void test_state_poll_vs_queue_drain() {
+    // Queue draining: the control loop rebuilds state and changes from every edge
+    GpioInput queued;
+    loopback_init(queued, low_pin);
+    QueueHandle_t queue = xQueueCreate(64, sizeof(int32_t));
+    queued.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, queued.enableInterrupt(GPIO_INTR_ANYEDGE));
+    uint64_t queue_changed = 0;
+    uint64_t queue_levels = 0;
+    const uint32_t queue_cycles = run_bench([&]() {
+        int32_t pin;
+        while (xQueueReceive(queue, &pin, 0) == pdTRUE) {
+            queue_changed |= 1ULL << pin;
+        }
+        // Queue items carry no level, the pin has to be read
+        queue_levels = static_cast<uint64_t>(gpio_get_level(low_pin)) << low_pin;
+    });
+    TEST_ASSERT_EQUAL(ESP_OK, queued.disableInterrupt());
+    vQueueDelete(queue);
+
+    // Bitmap: one fetch-and-clear and one read per poll, whatever the edge rate
+    GpioInput tracked;
+    loopback_init(tracked, low_pin);
+    TEST_ASSERT_EQUAL(ESP_OK, tracked.enableStateTracking());
+    TEST_ASSERT_EQUAL(ESP_OK, tracked.enableInterrupt(GPIO_INTR_ANYEDGE));
+    uint64_t state_changed = 0;
+    const uint32_t state_cycles = run_bench([&]() {
+        const PinStates states = GpioState::poll();
+        state_changed |= states.changed;
+    });
+    TEST_ASSERT_EQUAL(ESP_OK, tracked.disableInterrupt());
+
+    // The bitmap follows the pin after the flood
+    const int level = gpio_get_level(low_pin);
+    TEST_ASSERT_EQUAL(level, static_cast<int>((GpioState::getLevels() >> low_pin) & 1));
+    tracked.disableStateTracking();
+
+    printf("Poll at 20k edges/s: queue drain %lu cycles, bitmap %lu cycles\n",
+           static_cast<unsigned long>(queue_cycles), static_cast<unsigned long>(state_cycles));
+    TEST_ASSERT_TRUE(queue_changed & (1ULL << low_pin));
+    TEST_ASSERT_TRUE(state_changed & (1ULL << low_pin));
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_state_levels_and_changes);
+    RUN_TEST(test_state_poll_vs_queue_drain);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,147 @@
+#include <unity.h>
+#include "gpio_trigger.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "loopback.h"
+
+using namespace GPIO;
+
+// The test sets the levels the triggers see through the loopbacks
+static const gpio_num_t edge_pin = LOOPBACK_PIN_A;
+static const gpio_num_t low_pin = LOOPBACK_PIN_B;
+static const gpio_num_t high_pin = LOOPBACK_PIN_C;
+
+static const int32_t RISE_WHILE_QUIET = 1;
+static const int32_t FALL_WHILE_ARMED = 2;
+
+static constexpr uint64_t bit(gpio_num_t pin) {
+    return 1ULL << pin;
+}
+
+static void loop_pin(gpio_num_t pin) {
+    GpioInput input(pin);
+    loopback_init(input, pin);
+}
+
+static void drive(gpio_num_t pin, uint32_t level) {
+    gpio_set_level(pin, level);
+    vTaskDelay(1);
+}
+
+void setUp(void) {
+    loop_pin(edge_pin);
+    loop_pin(low_pin);
+    loop_pin(high_pin);
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_trigger_definitions() {
+    GpioTrigger trigger;
+    QueueHandle_t queue = xQueueCreate(4, sizeof(TriggerEvent));
+
+    // Value bits must be cared about
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, trigger.addTrigger({bit(edge_pin), bit(low_pin), edge_pin}, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, trigger.addTrigger({bit(edge_pin), 0, GPIO_NUM_NC}, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, trigger.enable());
+
+    for (size_t i = 0; i < GpioTrigger::MAX_TRIGGERS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, trigger.addTrigger({bit(edge_pin), 0, edge_pin}, i));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, trigger.addTrigger({bit(edge_pin), 0, edge_pin}, 99));
+
+    // Enabling needs a delivery target
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, trigger.enable());
+    trigger.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.enable());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, trigger.addTrigger({bit(edge_pin), 0, edge_pin}, 99));
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.disable());
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.clearTriggers());
+    vQueueDelete(queue);
+}
+
+void test_trigger_compound_conditions() {
+    GpioTrigger trigger;
+    QueueHandle_t queue = xQueueCreate(16, sizeof(TriggerEvent));
+    trigger.setQueueHandle(queue);
+
+    // Edge pin rises while both other pins are low
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.addTrigger({bit(edge_pin) | bit(low_pin) | bit(high_pin), bit(edge_pin), edge_pin}, RISE_WHILE_QUIET));
+    // Edge pin falls while GPIO 33 is high
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.addTrigger({bit(edge_pin) | bit(high_pin), bit(high_pin), edge_pin}, FALL_WHILE_ARMED));
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.enable());
+
+    drive(edge_pin, 1);     // Rise, others low: RISE_WHILE_QUIET
+    drive(edge_pin, 0);     // Fall, 33 low: nothing
+    drive(low_pin, 1);
+    drive(edge_pin, 1);     // Rise, 14 high: nothing
+    drive(high_pin, 1);
+    drive(edge_pin, 0);     // Fall, 33 high: FALL_WHILE_ARMED
+    drive(low_pin, 0);
+    drive(edge_pin, 1);     // Rise, 33 high: nothing
+    drive(high_pin, 0);
+    drive(edge_pin, 0);     // Fall, 33 low: nothing
+    drive(edge_pin, 1);     // Rise, others low: RISE_WHILE_QUIET
+
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.disable());
+    printf("Edges %lu, task wakeups %lu\n", static_cast<unsigned long>(trigger.getEdgeCount()),
+           static_cast<unsigned long>(trigger.getMatchCount()));
+
+    // Edges on the condition pins never interrupt, only the edge pin does
+    TEST_ASSERT_EQUAL(7, trigger.getEdgeCount());
+    TEST_ASSERT_EQUAL(3, trigger.getMatchCount());
+    TEST_ASSERT_EQUAL(0, trigger.getDropCount());
+    TEST_ASSERT_EQUAL(3, uxQueueMessagesWaiting(queue));
+
+    const int32_t expected[3] = {RISE_WHILE_QUIET, FALL_WHILE_ARMED, RISE_WHILE_QUIET};
+    TriggerEvent event;
+    for (const int32_t id : expected) {
+        TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(queue, &event, 0));
+        TEST_ASSERT_EQUAL(id, event.id);
+        TEST_ASSERT_EQUAL(edge_pin, event.edge_pin);
+    }
+    vQueueDelete(queue);
+}
+
+void test_trigger_full_queue_drops() {
+    GpioTrigger trigger;
+    QueueHandle_t queue = xQueueCreate(1, sizeof(TriggerEvent));
+    trigger.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.addTrigger({0, 0, edge_pin}, 7));
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.enable());
+
+    for (int i = 0; i < 4; i++) {
+        drive(edge_pin, (i + 1) % 2);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, trigger.disable());
+
+    TEST_ASSERT_EQUAL(4, trigger.getMatchCount());
+    TEST_ASSERT_EQUAL(3, trigger.getDropCount());
+    vQueueDelete(queue);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_trigger_definitions);
+    RUN_TEST(test_trigger_compound_conditions);
+    RUN_TEST(test_trigger_full_queue_drops);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -2,6 +2,7 @@
 #include "i2c.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_cpu.h"
 
 using namespace I2C;
 
@@ -49,12 +50,272 @@ void test_i2c_multiple_bytes() {
     TEST_ASSERT_EQUAL(ESP_OK, i2c.WriteRegisterMultipleBytes(dev_addr, 0x00, tx_data, 2));
 }
 
+void test_i2c_bus_idle_not_stuck() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    // With pullups enabled and no transaction running both lines must be high
+    TEST_ASSERT_FALSE(i2c.IsBusStuck());
+    
+    // Recovery on a healthy bus must leave it usable
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.RecoverBus());
+    TEST_ASSERT_FALSE(i2c.IsBusStuck());
+    
+    I2cMetrics metrics = i2c.GetMetrics();
+    TEST_ASSERT_EQUAL(1, metrics.recoveries);
+    TEST_ASSERT_EQUAL(0, metrics.recovery_failures);
+    TEST_ASSERT_EQUAL(0, metrics.stuck_bus_detections);
+}
+
+void test_i2c_circuit_breaker() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    // Nothing answers at 0x7E, so every attempt NACKs
+    const uint8_t absent_addr = 0x7E;
+    DeviceConfig config;
+    config.timeout_ms = 10;
+    config.breaker_threshold = 2;
+    config.backoff_base_ms = 200;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ConfigureDevice(absent_addr, config));
+    
+    uint8_t rx_data[2];
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(absent_addr, 0x00, rx_data, 2));
+    TEST_ASSERT_FALSE(i2c.IsQuarantined(absent_addr));
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(absent_addr, 0x00, rx_data, 2));
+    TEST_ASSERT_TRUE(i2c.IsQuarantined(absent_addr));
+    
+    // Quarantined devices are refused without touching the bus
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, i2c.ReadRegisterMultipleBytes(absent_addr, 0x00, rx_data, 2));
+    
+    // The breaker reopens after the backoff period
+    vTaskDelay(pdMS_TO_TICKS(250));
+    TEST_ASSERT_FALSE(i2c.IsQuarantined(absent_addr));
+    
+    I2cMetrics metrics = i2c.GetMetrics();
+    TEST_ASSERT_EQUAL(1, metrics.quarantines);
+    TEST_ASSERT_EQUAL(1, metrics.quarantine_rejections);
+}
+
+void test_i2c_device_table_full() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    DeviceConfig config;
+    
+    for (uint8_t addr = 0x10; addr < 0x20; addr++) {
+        TEST_ASSERT_EQUAL(ESP_OK, i2c.ConfigureDevice(addr, config));
+    }
+    
+    // Reconfiguring a known device still works, a new one does not fit
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ConfigureDevice(0x10, config));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, i2c.ConfigureDevice(0x20, config));
+}
+
+void test_i2c_batch_groups_by_speed() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    // 0x36 runs at 400 kHz, 0x7E keeps the 100 kHz port speed
+    DeviceConfig fast;
+    fast.clk_speed = 400000;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ConfigureDevice(0x36, fast));
+    
+    uint8_t rx_data[4][2];
+    Transaction batch[4];
+    const uint8_t order[4] = {0x36, 0x7E, 0x36, 0x7E};
+    for (int i = 0; i < 4; i++) {
+        batch[i].dev_addr = order[i];
+        batch[i].reg_addr = 0x00;
+        batch[i].data = rx_data[i];
+        batch[i].length = 2;
+        batch[i].read = true;
+    }
+    i2c.ExecuteBatch(batch, 4);
+    
+    // Interleaved order would switch three times, grouped order switches once
+    TEST_ASSERT_EQUAL(1, i2c.GetMetrics().speed_switches);
+    TEST_ASSERT_EQUAL(ESP_OK, batch[0].status);
+    TEST_ASSERT_EQUAL(ESP_OK, batch[2].status);
+}
+
+void test_i2c_batch_groups_by_timing() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    // Same speed as the port, but a later sample point still needs a reprogram
+    DeviceConfig late_sample;
+    late_sample.clk_speed = 100000;
+    late_sample.sda_sample_cycles = 300;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ConfigureDevice(0x36, late_sample));
+    
+    uint8_t rx_data[4][2];
+    Transaction batch[4];
+    const uint8_t order[4] = {0x36, 0x7E, 0x36, 0x7E};
+    for (int i = 0; i < 4; i++) {
+        batch[i].dev_addr = order[i];
+        batch[i].reg_addr = 0x00;
+        batch[i].data = rx_data[i];
+        batch[i].length = 2;
+        batch[i].read = true;
+    }
+    i2c.ExecuteBatch(batch, 4);
+    
+    TEST_ASSERT_EQUAL(1, i2c.GetMetrics().speed_switches);
+    TEST_ASSERT_EQUAL(ESP_OK, batch[0].status);
+    TEST_ASSERT_EQUAL(ESP_OK, batch[2].status);
+}
+
+void test_i2c_calibrate_device() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    uint32_t max_speed = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.CalibrateDevice(0x36, 0x00, 2, 32, &max_speed));
+    TEST_ASSERT_GREATER_OR_EQUAL(100000, max_speed);
+    TEST_ASSERT_LESS_OR_EQUAL(1000000, max_speed);
+    
+    // The device keeps working at the calibrated speed
+    uint8_t rx_data[2];
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x36, 0x00, rx_data, 2));
+    
+    // Nothing answers at 0x7E, so there is no reference to calibrate against
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, i2c.CalibrateDevice(0x7E, 0x00, 2));
+}
+
+void test_i2c_scatter_gather() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    const uint8_t dev_addr = 0x36;
+    const uint8_t reg_addr = 0x00;
+    uint8_t whole[4];
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(dev_addr, reg_addr, std::span<uint8_t>(whole)));
+    
+    // The same read split over two destination buffers
+    uint8_t head[2];
+    uint8_t tail[2];
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.WriteRead(dev_addr, {std::span<const uint8_t>(&reg_addr, 1)}, {std::span<uint8_t>(head), std::span<uint8_t>(tail)}));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(whole, head, 2);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(whole + 2, tail, 2);
+    
+    // Header and payload from separate buffers in one write
+    const uint8_t payload[2] = {0x00, 0x00};
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.Write(dev_addr, {std::span<const uint8_t>(&reg_addr, 1), std::span<const uint8_t>(payload)}));
+    
+    // The runtime-sized overload rejects more segments than its link buffer holds
+    std::span<const uint8_t> segments[I2c::MAX_SEGMENTS + 1];
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, i2c.Write(dev_addr, std::span<const std::span<const uint8_t>>(segments)));
+}
+
+void test_i2c_prepared_transaction() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    static PreparedTransaction prepared;
+    static uint8_t front[2];
+    static uint8_t back[2];
+    uint8_t *const buffers[2] = {front, back};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, i2c.Execute(prepared));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, i2c.Prepare(prepared, 0x36, 0x00, 0, true, buffers));
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.Prepare(prepared, 0x36, 0x00, 2, true, buffers));
+    
+    uint8_t expected[2];
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x36, 0x00, expected, 2));
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.Execute(prepared, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.Execute(prepared, 1));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, front, 2);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, back, 2);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, i2c.Execute(prepared, 2));
+    
+    // The handle stays valid, every run of it transfers the data again
+    for (int run = 0; run < 3; run++) {
+        front[0] = front[1] = static_cast<uint8_t>(~expected[0]);
+        TEST_ASSERT_EQUAL(ESP_OK, i2c.Execute(prepared, 0));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, front, 2);
+    }
+}
+
+void test_i2c_prepared_transaction_benchmark() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 400000, true, true, 0));
+    
+    const uint32_t iterations = 200;
+    static PreparedTransaction prepared;
+    static uint8_t rx_data[14];
+    uint8_t *const buffers[1] = {rx_data};
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.Prepare(prepared, 0x36, 0x00, sizeof(rx_data), true, buffers));
+    
+    esp_err_t per_call_status = ESP_OK;
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < iterations; i++) {
+        per_call_status |= i2c.ReadRegisterMultipleBytes(0x36, 0x00, rx_data, sizeof(rx_data));
+    }
+    const uint32_t per_call_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    TEST_ASSERT_EQUAL(ESP_OK, per_call_status);
+    
+    esp_err_t prepared_status = ESP_OK;
+    start = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < iterations; i++) {
+        prepared_status |= i2c.Execute(prepared);
+    }
+    const uint32_t prepared_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    TEST_ASSERT_EQUAL(ESP_OK, prepared_status);
+    
+    // Bus time is identical, so the difference is the link build that was saved
+    const int32_t saved_cycles = static_cast<int32_t>(per_call_cycles - prepared_cycles);
+    printf("14-byte read: per-call build %lu cycles, prepared %lu cycles, saved %ld cycles (%.1f us)\n",
+           static_cast<unsigned long>(per_call_cycles), static_cast<unsigned long>(prepared_cycles),
+           static_cast<long>(saved_cycles), static_cast<double>(saved_cycles) / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+}
+
+void test_i2c_pools() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    // Every transfer borrows a link buffer and returns it
+    uint8_t rx_data[2];
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x36, 0x00, rx_data, 2));
+    PoolStats links = i2c.GetLinkPoolStats();
+    TEST_ASSERT_EQUAL(0, links.in_use);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, links.high_water);
+    
+    // Drain the descriptor pool, the next acquisition must fail
+    Transaction *taken[CONFIG_I2C_DESCRIPTOR_POOL_SIZE];
+    for (size_t i = 0; i < CONFIG_I2C_DESCRIPTOR_POOL_SIZE; i++) {
+        taken[i] = i2c.AcquireTransaction();
+        TEST_ASSERT_NOT_NULL(taken[i]);
+    }
+    TEST_ASSERT_NULL(i2c.AcquireTransaction());
+    
+    PoolStats descriptors = i2c.GetDescriptorPoolStats();
+    TEST_ASSERT_EQUAL(CONFIG_I2C_DESCRIPTOR_POOL_SIZE, descriptors.in_use);
+    TEST_ASSERT_EQUAL(CONFIG_I2C_DESCRIPTOR_POOL_SIZE, descriptors.high_water);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, descriptors.exhaustions);
+    
+    for (size_t i = 0; i < CONFIG_I2C_DESCRIPTOR_POOL_SIZE; i++) {
+        i2c.ReleaseTransaction(taken[i]);
+    }
+    TEST_ASSERT_EQUAL(0, i2c.GetDescriptorPoolStats().in_use);
+    Transaction *again = i2c.AcquireTransaction();
+    TEST_ASSERT_NOT_NULL(again);
+    i2c.ReleaseTransaction(again);
+}
+
 void RUN_UNITY_TESTS() {
     UNITY_BEGIN();
     
     RUN_TEST(test_i2c_initialization);
     RUN_TEST(test_i2c_read_write);
     RUN_TEST(test_i2c_multiple_bytes);
+    RUN_TEST(test_i2c_bus_idle_not_stuck);
+    RUN_TEST(test_i2c_circuit_breaker);
+    RUN_TEST(test_i2c_device_table_full);
+    RUN_TEST(test_i2c_batch_groups_by_speed);
+    RUN_TEST(test_i2c_batch_groups_by_timing);
+    RUN_TEST(test_i2c_calibrate_device);
+    RUN_TEST(test_i2c_scatter_gather);
+    RUN_TEST(test_i2c_prepared_transaction);
+    RUN_TEST(test_i2c_prepared_transaction_benchmark);
+    RUN_TEST(test_i2c_pools);
     
     UNITY_END();
 }
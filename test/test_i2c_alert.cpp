@@ -0,0 +1,158 @@
+#include <unity.h>
+#include "i2c_alert.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using namespace I2C;
+
+// The alert line is driven by the test itself through an open-drain output on the same pin
+static const gpio_num_t alert_pin = GPIO_NUM_27;
+static const uint8_t present_addr = 0x36;
+static const uint8_t absent_addr = 0x7E;
+
+static volatile int present_calls = 0;
+static volatile int absent_calls = 0;
+static volatile int ara_calls = 0;
+static volatile uint8_t last_status = 0;
+
+// Servicing the device clears its alert, modelled by releasing the line
+static void present_handler(uint8_t dev_addr, uint8_t status, void *context) {
+    present_calls++;
+    last_status = status;
+    gpio_set_level(alert_pin, 1);
+}
+
+static void absent_handler(uint8_t dev_addr, uint8_t status, void *context) {
+    absent_calls++;
+}
+
+static void ara_handler(uint8_t dev_addr, uint8_t status, void *context) {
+    ara_calls++;
+}
+
+static void assert_alert_line(bool asserted) {
+    gpio_set_direction(alert_pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_level(alert_pin, asserted ? 0 : 1);
+}
+
+void setUp(void) {
+    present_calls = 0;
+    absent_calls = 0;
+    ara_calls = 0;
+    last_status = 0;
+}
+
+void tearDown(void) {
+    assert_alert_line(false);
+}
+
+void test_alert_add_device() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    AlertRouter router(i2c, alert_pin);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, router.AddDevice(0x80, ara_handler));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, router.AddDevice(ALERT_RESPONSE_ADDR, ara_handler));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, router.AddDevice(present_addr, nullptr));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, router.AddDevice(present_addr, 0x00, 0x00, present_handler));
+
+    for (size_t i = 0; i < AlertRouter::MAX_ROUTES; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, router.AddDevice(0x40 + i, ara_handler));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, router.AddDevice(0x50, ara_handler));
+}
+
+void test_alert_idle_line_causes_no_bus_traffic() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    AlertRouter router(i2c, alert_pin);
+    TEST_ASSERT_EQUAL(ESP_OK, router.AddDevice(present_addr, 0x00, 0xFF, present_handler));
+    TEST_ASSERT_EQUAL(ESP_OK, router.Start());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, router.Start());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, router.AddDevice(absent_addr, 0x00, 0xFF, absent_handler));
+    assert_alert_line(false);
+
+    const uint32_t before = i2c.GetMetrics().transactions;
+    vTaskDelay(pdMS_TO_TICKS(500));
+    router.Stop();
+
+    TEST_ASSERT_EQUAL(before, i2c.GetMetrics().transactions);
+    TEST_ASSERT_EQUAL(0, router.GetStats().interrupts);
+    TEST_ASSERT_EQUAL(0, present_calls);
+}
+
+void test_alert_routes_to_status_register_owner() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+
+    uint8_t expected = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(present_addr, 0x00, std::span<uint8_t>(&expected, 1)));
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(0, expected, "Status register must be non-zero for this test");
+
+    // The absent device is checked first and fails, only the present one claims the alert
+    AlertRouter router(i2c, alert_pin);
+    TEST_ASSERT_EQUAL(ESP_OK, router.AddDevice(absent_addr, 0x00, 0xFF, absent_handler));
+    TEST_ASSERT_EQUAL(ESP_OK, router.AddDevice(present_addr, 0x00, 0xFF, present_handler));
+    TEST_ASSERT_EQUAL(ESP_OK, router.Start());
+    assert_alert_line(false);
+    vTaskDelay(pdMS_TO_TICKS(20));
+
+    assert_alert_line(true);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    router.Stop();
+
+    const AlertStats stats = router.GetStats();
+    TEST_ASSERT_EQUAL(1, present_calls);
+    TEST_ASSERT_EQUAL(0, absent_calls);
+    TEST_ASSERT_EQUAL(expected, last_status);
+    TEST_ASSERT_EQUAL(1, stats.interrupts);
+    TEST_ASSERT_EQUAL(1, stats.serviced);
+    TEST_ASSERT_EQUAL(2, stats.status_reads);
+    TEST_ASSERT_EQUAL(0, stats.ara_reads);
+}
+
+void test_alert_ara_falls_back_to_status_registers() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    AlertRouter router(i2c, alert_pin);
+    TEST_ASSERT_EQUAL(ESP_OK, router.AddDevice(0x48, ara_handler));
+    TEST_ASSERT_EQUAL(ESP_OK, router.AddDevice(present_addr, 0x00, 0xFF, present_handler));
+
+    // No device answers the Alert Response Address on this bus
+    uint8_t response = 0;
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, i2c.Read(ALERT_RESPONSE_ADDR, std::span<uint8_t>(&response, 1)));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, i2c.Read(present_addr, std::span<uint8_t>()));
+
+    assert_alert_line(true);
+    TEST_ASSERT_EQUAL(ESP_OK, router.Service());
+
+    const AlertStats stats = router.GetStats();
+    TEST_ASSERT_EQUAL(0, ara_calls);
+    TEST_ASSERT_EQUAL(1, present_calls);
+    TEST_ASSERT_EQUAL(1, stats.ara_reads);
+    TEST_ASSERT_EQUAL(1, stats.status_reads);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_alert_add_device);
+    RUN_TEST(test_alert_idle_line_causes_no_bus_traffic);
+    RUN_TEST(test_alert_routes_to_status_register_owner);
+    RUN_TEST(test_alert_ara_falls_back_to_status_registers);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,209 @@
+#include <unity.h>
+#include "i2c_bus_group.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+using namespace I2C;
+
+// Nothing is connected at these addresses. Every transaction still occupies
+// the wire for START, address, NACK and STOP, which is all the benchmark needs.
+static const uint8_t first_addr = 0x70;
+static const uint8_t second_addr = 0x71;
+static const size_t benchmark_count = 200;
+
+static uint8_t rx_data[benchmark_count][2];
+static Transaction batch[benchmark_count];
+
+static void fill_batch() {
+    for (size_t i = 0; i < benchmark_count; i++) {
+        batch[i].dev_addr = (i % 2) ? second_addr : first_addr;
+        batch[i].reg_addr = 0x00;
+        batch[i].data = rx_data[i];
+        batch[i].length = 2;
+        batch[i].read = true;
+    }
+}
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_bus_group_routes_by_placement() {
+    I2c bus0(I2C_NUM_0, 0, 0, 0);
+    I2c bus1(I2C_NUM_1, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.InitMaster(21, 22, 400000, true, true, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.InitMaster(25, 26, 400000, true, true, 0));
+    
+    I2cBusGroup group(bus0, bus1);
+    TEST_ASSERT_EQUAL(ESP_OK, group.Start());
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(second_addr, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, group.AssignDevice(second_addr, 2));
+    
+    fill_batch();
+    group.Submit(batch, benchmark_count);
+    
+    TEST_ASSERT_EQUAL(benchmark_count / 2, group.GetPortStats(0).transactions);
+    TEST_ASSERT_EQUAL(benchmark_count / 2, group.GetPortStats(1).transactions);
+    for (size_t i = 0; i < benchmark_count; i++) {
+        TEST_ASSERT_NOT_EQUAL(ESP_ERR_NOT_FINISHED, batch[i].status);
+    }
+}
+
+void test_bus_group_requires_workers() {
+    I2c bus0(I2C_NUM_0, 0, 0, 0);
+    I2c bus1(I2C_NUM_1, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.InitMaster(21, 22, 400000, true, true, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.InitMaster(25, 26, 400000, true, true, 0));
+    
+    I2cBusGroup group(bus0, bus1);
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(second_addr, 1));
+    fill_batch();
+    
+    // Nothing runs on the caller instead of the workers
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, group.Submit(batch, benchmark_count));
+    TEST_ASSERT_EQUAL(0, group.GetPortStats(0).transactions);
+    
+    // Stopped workers finish their queued jobs and can be started again
+    TEST_ASSERT_EQUAL(ESP_OK, group.Start());
+    group.Submit(batch, benchmark_count);
+    group.Stop();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, group.Submit(batch, benchmark_count));
+    TEST_ASSERT_EQUAL(ESP_OK, group.Start());
+    group.Submit(batch, benchmark_count);
+    TEST_ASSERT_EQUAL(2 * benchmark_count, group.GetPortStats(0).transactions + group.GetPortStats(1).transactions);
+}
+
+void test_bus_group_rebalances_mirrored_devices() {
+    I2c bus0(I2C_NUM_0, 0, 0, 0);
+    I2c bus1(I2C_NUM_1, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.InitMaster(21, 22, 400000, true, true, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.InitMaster(25, 26, 400000, true, true, 0));
+    
+    I2cBusGroup group(bus0, bus1);
+    TEST_ASSERT_EQUAL(ESP_OK, group.Start());
+    
+    // Both devices start on port 0 but may live on either bus
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(first_addr, 0, true));
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(second_addr, 0, true));
+    DeviceConfig config;
+    config.timeout_ms = 20;
+    config.breaker_threshold = 0;
+    config.clk_speed = 100000;
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.ConfigureDevice(first_addr, config));
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.ConfigureDevice(second_addr, config));
+    
+    fill_batch();
+    group.Submit(batch, benchmark_count);
+    TEST_ASSERT_EQUAL(0, group.GetPortStats(1).transactions);
+    
+    PortPlacement placement;
+    group.SuggestPlacement(placement);
+    TEST_ASSERT_NOT_EQUAL(placement.port[first_addr], placement.port[second_addr]);
+    
+    TEST_ASSERT_EQUAL(1, group.Rebalance());
+    group.ResetStats();
+    group.Submit(batch, benchmark_count);
+    TEST_ASSERT_EQUAL(benchmark_count / 2, group.GetPortStats(0).transactions);
+    TEST_ASSERT_EQUAL(benchmark_count / 2, group.GetPortStats(1).transactions);
+    
+    // The moved device took its policy along
+    const uint8_t moved_addr = placement.port[first_addr] == 1 ? first_addr : second_addr;
+    DeviceConfig moved;
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.GetDeviceConfig(moved_addr, moved));
+    TEST_ASSERT_EQUAL(config.timeout_ms, moved.timeout_ms);
+    TEST_ASSERT_EQUAL(config.breaker_threshold, moved.breaker_threshold);
+    TEST_ASSERT_EQUAL(config.clk_speed, moved.clk_speed);
+}
+
+void test_bus_group_keeps_unmovable_devices() {
+    I2c bus0(I2C_NUM_0, 0, 0, 0);
+    I2c bus1(I2C_NUM_1, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.InitMaster(21, 22, 400000, true, true, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.InitMaster(25, 26, 400000, true, true, 0));
+    
+    I2cBusGroup group(bus0, bus1);
+    TEST_ASSERT_EQUAL(ESP_OK, group.Start());
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(first_addr, 0, true));
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(second_addr, 0, true));
+    
+    // A policy only on port 1 would change how either device runs there
+    DeviceConfig config;
+    config.timeout_ms = 20;
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.ConfigureDevice(first_addr, config));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.ConfigureDevice(second_addr, config));
+    
+    fill_batch();
+    group.Submit(batch, benchmark_count);
+    TEST_ASSERT_EQUAL(0, group.Rebalance());
+    
+    group.ResetStats();
+    group.Submit(batch, benchmark_count);
+    TEST_ASSERT_EQUAL(0, group.GetPortStats(1).transactions);
+}
+
+void test_bus_group_throughput_scaling() {
+    I2c bus0(I2C_NUM_0, 0, 0, 0);
+    I2c bus1(I2C_NUM_1, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.InitMaster(21, 22, 100000, true, true, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.InitMaster(25, 26, 100000, true, true, 0));
+    
+    I2cBusGroup group(bus0, bus1);
+    TEST_ASSERT_EQUAL(ESP_OK, group.Start());
+    fill_batch();
+    
+    // One port carries everything
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(second_addr, 0));
+    int64_t start = esp_timer_get_time();
+    group.Submit(batch, benchmark_count);
+    const int64_t one_port_us = esp_timer_get_time() - start;
+    
+    // Load split across both ports
+    TEST_ASSERT_EQUAL(ESP_OK, group.AssignDevice(second_addr, 1));
+    group.ResetStats();
+    start = esp_timer_get_time();
+    group.Submit(batch, benchmark_count);
+    const int64_t two_port_us = esp_timer_get_time() - start;
+    
+    printf("1 port: %lld us, 2 ports: %lld us, scaling %.2fx\n",
+           static_cast<long long>(one_port_us), static_cast<long long>(two_port_us),
+           static_cast<double>(one_port_us) / two_port_us);
+    printf("Port utilization: %.2f / %.2f\n",
+           group.GetPortStats(0).utilization, group.GetPortStats(1).utilization);
+    
+    // The split batch really ran on both ports
+    TEST_ASSERT_EQUAL(benchmark_count / 2, group.GetPortStats(0).transactions);
+    TEST_ASSERT_EQUAL(benchmark_count / 2, group.GetPortStats(1).transactions);
+    for (size_t i = 0; i < benchmark_count; i++) {
+        TEST_ASSERT_NOT_EQUAL(ESP_ERR_NOT_FINISHED, batch[i].status);
+    }
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_bus_group_routes_by_placement);
+    RUN_TEST(test_bus_group_requires_workers);
+    RUN_TEST(test_bus_group_rebalances_mirrored_devices);
+    RUN_TEST(test_bus_group_keeps_unmovable_devices);
+    RUN_TEST(test_bus_group_throughput_scaling);
+    
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    
+    // Run tests
+    RUN_UNITY_TESTS();
+    
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
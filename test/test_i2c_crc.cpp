@@ -0,0 +1,112 @@
+#include <unity.h>
+#include "i2c_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+
+using namespace I2C;
+
+static uint8_t block[1024];
+
+void setUp(void) {
+    for (size_t i = 0; i < sizeof(block); i++) {
+        block[i] = static_cast<uint8_t>(i * 73 + 5);
+    }
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_crc_check_values() {
+    // CRC-8/SMBUS check value over "123456789"
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    TEST_ASSERT_EQUAL_HEX8(0xF4, Crc::Smbus(check, sizeof(check)));
+    // Example from the Sensirion datasheets
+    const uint8_t word[] = {0xBE, 0xEF};
+    TEST_ASSERT_EQUAL_HEX8(0x92, Crc::Sensirion(word, sizeof(word)));
+}
+
+void test_crc_tables_match_bitwise() {
+    for (size_t length = 0; length <= 64; length++) {
+        TEST_ASSERT_EQUAL_HEX8(Crc::Bitwise(block, length, Crc::SMBUS_POLY, Crc::SMBUS_INIT), Crc::Smbus(block, length));
+        TEST_ASSERT_EQUAL_HEX8(Crc::Bitwise(block, length, Crc::SENSIRION_POLY, Crc::SENSIRION_INIT), Crc::Sensirion(block, length));
+    }
+    TEST_ASSERT_EQUAL_HEX8(Crc::Bitwise(block, sizeof(block), Crc::SMBUS_POLY, 0), Crc::Smbus(block, sizeof(block)));
+}
+
+void test_crc_pec_is_incremental() {
+    // PEC over address, register and data equals the PEC computed piecewise
+    const uint8_t whole = Crc::Smbus(block, 40);
+    TEST_ASSERT_EQUAL_HEX8(whole, Crc::Smbus(block + 2, 38, Crc::Smbus(block, 2)));
+}
+
+void test_crc_sensirion_words() {
+    const uint16_t words[3] = {0xBEEF, 0x0000, 0x6666};
+    uint16_t decoded[3];
+    uint8_t frame[9];
+    Crc::PackSensirionWords(words, frame, 3);
+    TEST_ASSERT_EQUAL_HEX8(0x92, frame[2]);
+    TEST_ASSERT_TRUE(Crc::UnpackSensirionWords(frame, decoded, 3));
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(words, decoded, 3);
+
+    frame[4] ^= 0x01;
+    TEST_ASSERT_FALSE(Crc::UnpackSensirionWords(frame, decoded, 3));
+}
+
+void test_crc_benchmark() {
+    volatile uint8_t sink;
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    sink = Crc::Bitwise(block, sizeof(block), Crc::SMBUS_POLY, Crc::SMBUS_INIT);
+    const uint32_t bitwise_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    sink = Crc::Smbus(block, sizeof(block));
+    const uint32_t table_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (size_t i = 0; i + 2 <= sizeof(block); i += 2) {
+        sink = Crc::Bitwise(block + i, 2, Crc::SENSIRION_POLY, Crc::SENSIRION_INIT);
+    }
+    const uint32_t bitwise_word_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (size_t i = 0; i + 2 <= sizeof(block); i += 2) {
+        sink = Crc::Sensirion(block + i, 2);
+    }
+    const uint32_t table_word_cycles = esp_cpu_get_cycle_count() - start;
+    (void)sink;
+
+    printf("PEC over %u bytes: bitwise %lu cycles, slicing-by-4 %lu cycles\n",
+           static_cast<unsigned>(sizeof(block)),
+           static_cast<unsigned long>(bitwise_cycles), static_cast<unsigned long>(table_cycles));
+    printf("Sensirion per word: bitwise %lu cycles, table %lu cycles\n",
+           static_cast<unsigned long>(bitwise_word_cycles / (sizeof(block) / 2)),
+           static_cast<unsigned long>(table_word_cycles / (sizeof(block) / 2)));
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_crc_check_values);
+    RUN_TEST(test_crc_tables_match_bitwise);
+    RUN_TEST(test_crc_pec_is_incremental);
+    RUN_TEST(test_crc_sensirion_words);
+    RUN_TEST(test_crc_benchmark);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
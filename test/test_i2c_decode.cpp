@@ -0,0 +1,161 @@
+#include <unity.h>
+#include "i2c_decode.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+
+using namespace I2C;
+
+static const size_t sample_count = 1024;
+static uint8_t raw_frame[sample_count * 3];
+static int16_t samples16[sample_count];
+static int32_t samples32[sample_count];
+static int32_t scaled[sample_count];
+
+// BMP280 burst from 0xF7: press[19:0], temp[19:0], each as msb, lsb, xlsb[7:4]
+static constexpr std::array<Decode::PackedField, 2> bmp280_layout{{
+    {0, 20, false},
+    {24, 20, false},
+}};
+
+static void fill_frame() {
+    for (size_t i = 0; i < sizeof(raw_frame); i++) {
+        raw_frame[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+}
+
+// Reference decoders in the per-byte, float style the kernels replace
+static void naive_int16(const uint8_t *src, int16_t *dst, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = static_cast<int16_t>((src[2 * i] << 8) | src[2 * i + 1]);
+    }
+}
+
+static void naive_int24(const uint8_t *src, int32_t *dst, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = (src[3 * i] << 16) | (src[3 * i + 1] << 8) | src[3 * i + 2];
+        if (value & 0x800000) {
+            value -= 0x1000000;
+        }
+        dst[i] = value;
+    }
+}
+
+static void naive_scale(const int16_t *raw, int32_t *out, size_t count, float gain) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = static_cast<int32_t>(raw[i] * gain);
+    }
+}
+
+void setUp(void) {
+    fill_frame();
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_decode_int16_matches_reference() {
+    int16_t expected[17];
+    naive_int16(raw_frame, expected, 17);
+    Decode::SwapInt16(raw_frame, samples16, 17);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, samples16, 17);
+}
+
+void test_decode_int24_matches_reference() {
+    int32_t expected[11];
+    naive_int24(raw_frame, expected, 11);
+    Decode::UnpackInt24(raw_frame, samples32, 11);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(expected, samples32, 11);
+}
+
+void test_decode_int12() {
+    const uint8_t frame[4] = {0xFF, 0xF0, 0x7F, 0xF0};
+    Decode::UnpackInt12(frame, samples16, 2);
+    TEST_ASSERT_EQUAL(-1, samples16[0]);
+    TEST_ASSERT_EQUAL(2047, samples16[1]);
+    Decode::UnpackInt12(frame, samples16, 2, false);
+    TEST_ASSERT_EQUAL(4095, samples16[0]);
+}
+
+void test_decode_packed_fields() {
+    const uint8_t frame[6] = {0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00};
+    int32_t values[2];
+    Decode::ExtractFields<bmp280_layout>(frame, values);
+    TEST_ASSERT_EQUAL_HEX32(0x655AC, values[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x7EED0, values[1]);
+    
+    const Decode::PackedField signed_field{4, 12, true};
+    TEST_ASSERT_EQUAL(static_cast<int32_t>(0x55A) , Decode::ExtractField(frame, signed_field));
+    const Decode::PackedField negative_field{24, 8, true};
+    TEST_ASSERT_EQUAL(0x7E, Decode::ExtractField(frame, negative_field));
+    const Decode::PackedField high_bit{32, 8, true};
+    TEST_ASSERT_EQUAL(static_cast<int8_t>(0xED), Decode::ExtractField(frame, high_bit));
+}
+
+void test_decode_fixed_point_scale() {
+    // ±2 g accelerometer, 16384 LSB/g, output in mg
+    static constexpr Decode::Scale mg = Decode::MakeScale(1000.0 / 16384);
+    const int16_t raw[3] = {16384, -8192, 0};
+    Decode::ApplyScale(raw, scaled, 3, mg);
+    TEST_ASSERT_INT32_WITHIN(1, 1000, scaled[0]);
+    TEST_ASSERT_INT32_WITHIN(1, -500, scaled[1]);
+    TEST_ASSERT_EQUAL(0, scaled[2]);
+}
+
+void test_decode_benchmark() {
+    static constexpr Decode::Scale mg = Decode::MakeScale(1000.0 / 16384);
+    const float gain = 1000.0f / 16384;
+    
+    uint32_t start = esp_cpu_get_cycle_count();
+    naive_int16(raw_frame, samples16, sample_count);
+    naive_scale(samples16, scaled, sample_count, gain);
+    const uint32_t naive16_cycles = esp_cpu_get_cycle_count() - start;
+    
+    start = esp_cpu_get_cycle_count();
+    Decode::SwapInt16(raw_frame, samples16, sample_count);
+    Decode::ApplyScale(samples16, scaled, sample_count, mg);
+    const uint32_t kernel16_cycles = esp_cpu_get_cycle_count() - start;
+    
+    start = esp_cpu_get_cycle_count();
+    naive_int24(raw_frame, samples32, sample_count);
+    const uint32_t naive24_cycles = esp_cpu_get_cycle_count() - start;
+    
+    start = esp_cpu_get_cycle_count();
+    Decode::UnpackInt24(raw_frame, samples32, sample_count);
+    const uint32_t kernel24_cycles = esp_cpu_get_cycle_count() - start;
+    
+    const uint32_t cpu_hz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000;
+    printf("int16+scale: naive %lu cycles (%.0f samples/s), kernel %lu cycles (%.0f samples/s)\n",
+           static_cast<unsigned long>(naive16_cycles), static_cast<double>(sample_count) * cpu_hz / naive16_cycles,
+           static_cast<unsigned long>(kernel16_cycles), static_cast<double>(sample_count) * cpu_hz / kernel16_cycles);
+    printf("int24: naive %lu cycles (%.0f samples/s), kernel %lu cycles (%.0f samples/s)\n",
+           static_cast<unsigned long>(naive24_cycles), static_cast<double>(sample_count) * cpu_hz / naive24_cycles,
+           static_cast<unsigned long>(kernel24_cycles), static_cast<double>(sample_count) * cpu_hz / kernel24_cycles);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_decode_int16_matches_reference);
+    RUN_TEST(test_decode_int24_matches_reference);
+    RUN_TEST(test_decode_int12);
+    RUN_TEST(test_decode_packed_fields);
+    RUN_TEST(test_decode_fixed_point_scale);
+    RUN_TEST(test_decode_benchmark);
+    
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    
+    // Run tests
+    RUN_UNITY_TESTS();
+    
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
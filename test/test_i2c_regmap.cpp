@@ -0,0 +1,132 @@
+#include <unity.h>
+#include "i2c_regmap.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using namespace I2C;
+
+// BME280-style register map used to check the generated masks
+namespace Bme280 {
+    enum class Mode : uint8_t { SLEEP = 0, FORCED = 1, NORMAL = 3 };
+
+    using ChipId = Register<0xD0, 1, Endian::BIG, Access::RO>;
+    using CtrlMeas = Register<0xF4>;
+    using PressMsb = Register<0xF7, 2, Endian::BIG, Access::RO>;
+    using PressXlsb = Register<0xF9, 1, Endian::BIG, Access::RO>;
+    using Reset = Register<0xE0, 1, Endian::BIG, Access::WO>;
+
+    using Id = Field<ChipId, 0, 8>;
+    using OsrsT = Field<CtrlMeas, 5, 3>;
+    using OsrsP = Field<CtrlMeas, 2, 3>;
+    using PowerMode = Field<CtrlMeas, 0, 2, Mode>;
+    using Pressure = Field<PressMsb, 0, 16>;
+    using PressureLow = Field<PressXlsb, 4, 4>;
+    using ResetWord = Field<Reset, 0, 8>;
+}
+
+using namespace Bme280;
+
+static_assert(OsrsT::mask == 0xE0, "Unexpected mask");
+static_assert(OsrsP::mask == 0x1C, "Unexpected mask");
+static_assert(PowerMode::mask == 0x03, "Unexpected mask");
+static_assert(SameRegister<OsrsT, OsrsP, PowerMode>, "ctrl_meas fields share a register");
+static_assert(!SameRegister<OsrsT, Pressure>, "Different registers must be detected");
+static_assert(DisjointFields<OsrsT, OsrsP, PowerMode>, "ctrl_meas fields do not overlap");
+static_assert(!DisjointFields<OsrsT, Field<CtrlMeas, 4, 2>>, "Overlap must be detected");
+static_assert(BurstSpan<Pressure, PressureLow> == 3, "Pressure spans three registers");
+
+// Generated accessors must fold to the same constants as hand-written masks
+static_assert(OsrsT::set(OsrsP::set(PowerMode::set(0, Mode::NORMAL), 1), 2) == ((2 << 5) | (1 << 2) | 3), "Set mismatch");
+static_assert(OsrsP::get(0x57) == ((0x57 & 0x1C) >> 2), "Get mismatch");
+
+constexpr uint16_t decode_be16(const uint8_t (&bytes)[2]) {
+    return PressMsb::decode(bytes);
+}
+constexpr uint8_t sample[2] = {0x12, 0x34};
+static_assert(decode_be16(sample) == 0x1234, "Big-endian decode mismatch");
+static_assert(Register<0x00, 2, Endian::LITTLE>::decode(sample) == 0x3412, "Little-endian decode mismatch");
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_regmap_encode_roundtrip() {
+    uint8_t bytes[3];
+    Register<0x10, 3, Endian::BIG>::encode(0x00ABCDEF, bytes);
+    TEST_ASSERT_EQUAL_HEX8(0xAB, bytes[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xCD, bytes[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xEF, bytes[2]);
+    TEST_ASSERT_EQUAL_HEX32(0x00ABCDEF, (Register<0x10, 3, Endian::BIG>::decode(bytes)));
+    
+    Register<0x10, 3, Endian::LITTLE>::encode(0x00ABCDEF, bytes);
+    TEST_ASSERT_EQUAL_HEX8(0xEF, bytes[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x00ABCDEF, (Register<0x10, 3, Endian::LITTLE>::decode(bytes)));
+}
+
+void test_regmap_device_access() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    // STEMMA soil sensor at 0x36, register 0x0F is writable in the other tests
+    using Scratch = Register<0x0F>;
+    using Low = Field<Scratch, 0, 4>;
+    using High = Field<Scratch, 4, 4>;
+    
+    RegisterDevice device(i2c, 0x36);
+    const uint32_t before = i2c.GetMetrics().transactions;
+    
+    // Both nibbles cover the whole register, so the update is a single write
+    TEST_ASSERT_EQUAL(ESP_OK, (device.Update<Low, High>(0x0, 0x0)));
+    TEST_ASSERT_EQUAL(before + 1, i2c.GetMetrics().transactions);
+    
+    // One nibble leaves bits untouched, so the register is read first
+    TEST_ASSERT_EQUAL(ESP_OK, device.Update<Low>(0x0));
+    TEST_ASSERT_EQUAL(before + 3, i2c.GetMetrics().transactions);
+    
+    uint8_t low = 0xFF;
+    uint8_t high = 0xFF;
+    TEST_ASSERT_EQUAL(ESP_OK, (device.ReadFields<Low, High>(low, high)));
+    TEST_ASSERT_EQUAL(before + 4, i2c.GetMetrics().transactions);
+    TEST_ASSERT_EQUAL(0x0, low);
+    TEST_ASSERT_EQUAL(0x0, high);
+    
+    // Without auto-increment every field is read on its own
+    RegisterDevice single(i2c, 0x36, {.address_bytes = 1, .auto_increment = false});
+    low = 0xFF;
+    high = 0xFF;
+    TEST_ASSERT_EQUAL(ESP_OK, (single.ReadFields<Low, High>(low, high)));
+    TEST_ASSERT_EQUAL(before + 6, i2c.GetMetrics().transactions);
+    TEST_ASSERT_EQUAL(0x0, low);
+    TEST_ASSERT_EQUAL(0x0, high);
+    
+    // A 2-byte address cannot be sent to a device with 1-byte addressing
+    uint8_t wide = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, device.ReadRegister<Register<0x0100>>(wide));
+    TEST_ASSERT_EQUAL(before + 6, i2c.GetMetrics().transactions);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_regmap_encode_roundtrip);
+    RUN_TEST(test_regmap_device_access);
+    
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    
+    // Run tests
+    RUN_UNITY_TESTS();
+    
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
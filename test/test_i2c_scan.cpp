@@ -0,0 +1,137 @@
+#include <unity.h>
+#include "i2c_presence.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+
+using namespace I2C;
+
+// The STEMMA soil sensor answers at 0x36, nothing answers at 0x7E
+static const uint8_t present_addr = 0x36;
+static const uint8_t absent_addr = 0x7E;
+
+static volatile int added_events = 0;
+static volatile int removed_events = 0;
+
+static void presence_handler(void *handler_args, esp_event_base_t base, int32_t id, void *event_data) {
+    const auto *event = static_cast<const PresenceEvent *>(event_data);
+    if (event->dev_addr != present_addr) {
+        return;
+    }
+    if (id == DEVICE_ADDED) {
+        added_events++;
+    } else if (id == DEVICE_REMOVED) {
+        removed_events++;
+    }
+}
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_scan_probe() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.Probe(present_addr));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, i2c.Probe(absent_addr));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, i2c.Probe(0x80));
+
+    // Probes never feed the circuit breaker
+    TEST_ASSERT_EQUAL(0, i2c.GetMetrics().errors);
+}
+
+void test_scan_full_range() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+
+    ScanResult result;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.Scan(result));
+    printf("Scanned 0x%02X-0x%02X in %lu us, %u devices\n", FIRST_SCAN_ADDR, LAST_SCAN_ADDR,
+           static_cast<unsigned long>(result.elapsed_us), static_cast<unsigned>(result.count));
+
+    TEST_ASSERT_TRUE(result.Contains(present_addr));
+    TEST_ASSERT_FALSE(result.Contains(absent_addr));
+
+    // Every address is reported exactly as a single probe sees it
+    size_t probed = 0;
+    for (uint8_t addr = FIRST_SCAN_ADDR; addr <= LAST_SCAN_ADDR; addr++) {
+        const bool present = i2c.Probe(addr) == ESP_OK;
+        TEST_ASSERT_EQUAL(present, result.Contains(addr));
+        probed += present ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(probed, result.count);
+}
+
+void test_scan_both_ports_concurrently() {
+    I2c bus0(I2C_NUM_0, 0, 0, 0);
+    I2c bus1(I2C_NUM_1, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.InitMaster(21, 22, 100000, true, true, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.InitMaster(25, 26, 100000, true, true, 0));
+
+    ScanResult single;
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.Scan(single));
+
+    ScanResult first;
+    ScanResult second;
+    const int64_t start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, I2c::Scan(bus0, first, bus1, second));
+    const int64_t both_us = esp_timer_get_time() - start;
+    printf("One port: %lu us, both ports: %lld us\n", static_cast<unsigned long>(single.elapsed_us), static_cast<long long>(both_us));
+
+    // The parallel scan of port 0 finds the same devices as the scan on its own
+    TEST_ASSERT_TRUE(first.Contains(present_addr));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(single.present, first.present, 4);
+    TEST_ASSERT_EQUAL(single.count, first.count);
+}
+
+void test_scan_presence_monitor_events() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    esp_event_loop_create_default();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_event_handler_register(I2C_EVENTS, ESP_EVENT_ANY_ID, presence_handler, nullptr));
+    added_events = 0;
+    removed_events = 0;
+
+    // The first scan reports the devices that are already there
+    PresenceMonitor monitor(i2c, present_addr - 1, present_addr + 1);
+    TEST_ASSERT_EQUAL(ESP_OK, monitor.Start(50));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, monitor.Start(50));
+    vTaskDelay(pdMS_TO_TICKS(200));
+    monitor.Stop();
+
+    TEST_ASSERT_EQUAL(1, added_events);
+    TEST_ASSERT_EQUAL(0, removed_events);
+    TEST_ASSERT_TRUE(monitor.GetPresent().Contains(present_addr));
+
+    esp_event_handler_unregister(I2C_EVENTS, ESP_EVENT_ANY_ID, presence_handler);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_scan_probe);
+    RUN_TEST(test_scan_full_range);
+    RUN_TEST(test_scan_both_ports_concurrently);
+    RUN_TEST(test_scan_presence_monitor_events);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
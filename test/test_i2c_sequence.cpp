@@ -0,0 +1,168 @@
+#include <unity.h>
+#include "i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using namespace I2C;
+
+// Program layout is fixed at compile time
+static constexpr auto soil_init = Init::Sequence(
+    Init::Write(0x0F, 0x00),
+    Init::Write(0x10, 0x00),
+    Init::Delay(5),
+    Init::BurstWrite(0x0F, 0x00, 0x00));
+
+static_assert(soil_init.size() == 3 + 3 + 3 + 5 + 1, "Unexpected program size");
+static_assert(soil_init[0] == static_cast<uint8_t>(InitOp::WRITE), "Program must start with WRITE");
+static_assert(soil_init[soil_init.size() - 1] == static_cast<uint8_t>(InitOp::END), "Program must end with END");
+
+static constexpr auto absent_init = Init::Sequence(
+    Init::Write(0x00, 0x01),
+    Init::PollUntil(0x01, 0x80, 0x80, 20));
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_sequence_encoding() {
+    static constexpr auto program = Init::Sequence(
+        Init::PollUntil(0x20, 0x01, 0x00, 300),
+        Init::Verify(0x21, 0xF0, 0x60));
+    
+    const uint8_t expected[] = {
+        static_cast<uint8_t>(InitOp::POLL), 0x20, 0x01, 0x00, 0x2C, 0x01,
+        static_cast<uint8_t>(InitOp::VERIFY), 0x21, 0xF0, 0x60,
+        static_cast<uint8_t>(InitOp::END)
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), program.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, program.data(), sizeof(expected));
+}
+
+void test_sequence_merges_adjacent_writes() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    InitSequence sequences[] = {MakeInitSequence(0x36, soil_init)};
+    InitReport report;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.RunInitSequences(sequences, 1, &report));
+    
+    // Two adjacent WRITEs become one burst, the BURST after the delay is separate
+    TEST_ASSERT_EQUAL(1, report.merged_writes);
+    TEST_ASSERT_EQUAL(2, report.transactions);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, report.total_us);
+}
+
+void test_sequence_without_auto_increment() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    InitSequence sequences[] = {MakeInitSequence(0x36, soil_init, false)};
+    InitReport report;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.RunInitSequences(sequences, 1, &report));
+    TEST_ASSERT_EQUAL(0, report.merged_writes);
+    TEST_ASSERT_EQUAL(3, report.transactions);
+}
+
+void test_sequence_failure_is_isolated() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    InitSequence sequences[] = {
+        MakeInitSequence(0x7E, absent_init),
+        MakeInitSequence(0x36, soil_init),
+    };
+    InitReport report;
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, i2c.RunInitSequences(sequences, 2, &report));
+    
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, sequences[0].status);
+    TEST_ASSERT_EQUAL(ESP_OK, sequences[1].status);
+    TEST_ASSERT_EQUAL(1, report.failed_sequences);
+}
+
+void test_sequence_delays_overlap() {
+    static constexpr auto slow_init = Init::Sequence(
+        Init::Write(0x0F, 0x00),
+        Init::Delay(50));
+    
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    
+    // Three devices waiting 50 ms each should finish in roughly one delay, not three
+    InitSequence sequences[] = {
+        MakeInitSequence(0x36, slow_init),
+        MakeInitSequence(0x36, slow_init),
+        MakeInitSequence(0x36, slow_init),
+    };
+    InitReport report;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.RunInitSequences(sequences, 3, &report));
+    printf("Init of 3 devices took %lu us\n", static_cast<unsigned long>(report.total_us));
+    
+    // Every sequence ran its write and honoured its delay
+    for (const InitSequence &sequence : sequences) {
+        TEST_ASSERT_EQUAL(ESP_OK, sequence.status);
+    }
+    TEST_ASSERT_EQUAL(3, report.transactions);
+    TEST_ASSERT_EQUAL(0, report.failed_sequences);
+    TEST_ASSERT_GREATER_OR_EQUAL(50000, report.total_us);
+}
+
+void test_sequence_two_ports() {
+    static constexpr auto late_init = Init::Sequence(
+        Init::Delay(20),
+        Init::Write(0x0F, 0x00));
+    
+    I2c bus0(I2C_NUM_0, 0, 0, 0);
+    I2c bus1(I2C_NUM_1, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, bus0.InitMaster(21, 22, 100000, true, true, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, bus1.InitMaster(25, 26, 100000, true, true, 0));
+    
+    // The device answers on port 0, nothing answers at 0x7E on port 1
+    InitSequence first[] = {
+        MakeInitSequence(0x36, soil_init),
+        MakeInitSequence(0x36, late_init),
+    };
+    InitSequence second[] = {
+        MakeInitSequence(0x7E, late_init),
+    };
+    InitReport report;
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, I2c::RunInitSequences(bus0, first, 2, bus1, second, 1, &report));
+    
+    // Each port's results land in its own sequences, the report adds both
+    TEST_ASSERT_EQUAL(ESP_OK, first[0].status);
+    TEST_ASSERT_EQUAL(ESP_OK, first[1].status);
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, second[0].status);
+    TEST_ASSERT_EQUAL(1, report.failed_sequences);
+    TEST_ASSERT_EQUAL(1, report.merged_writes);
+    TEST_ASSERT_GREATER_OR_EQUAL(20000, report.total_us);
+    printf("Init on two ports took %lu us\n", static_cast<unsigned long>(report.total_us));
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_sequence_encoding);
+    RUN_TEST(test_sequence_merges_adjacent_writes);
+    RUN_TEST(test_sequence_without_auto_increment);
+    RUN_TEST(test_sequence_failure_is_isolated);
+    RUN_TEST(test_sequence_delays_overlap);
+    RUN_TEST(test_sequence_two_ports);
+    
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    
+    // Run tests
+    RUN_UNITY_TESTS();
+    
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,220 @@
+#include <unity.h>
+#include "i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+using namespace I2C;
+
+// Every word carries the same counter, so a torn copy is easy to spot
+struct Reading {
+    uint32_t words[8];
+};
+
+struct RegisterImage {
+    uint8_t bytes[2];
+};
+
+static const TickType_t run_ticks = pdMS_TO_TICKS(200);
+
+static Snapshot<Reading> shared_snapshot;
+static Snapshot<Reading, 1> shared_single;
+static Reading shared_global;
+static SemaphoreHandle_t shared_mutex;
+
+static volatile bool running = false;
+static volatile uint32_t torn_reads = 0;
+static volatile uint32_t total_reads = 0;
+static SemaphoreHandle_t finished;
+static portMUX_TYPE totals_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+enum class Method { SNAPSHOT, SINGLE, MUTEX };
+
+static void fill(Reading &reading, uint32_t value) {
+    for (auto &word : reading.words) {
+        word = value;
+    }
+}
+
+static bool consistent(const Reading &reading) {
+    for (const auto word : reading.words) {
+        if (word != reading.words[0]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Publishes at 1 kHz from the esp_timer task, as a bus task polling a sensor would
+static void writer_callback(void *arg) {
+    static uint32_t counter = 0;
+    const auto method = *static_cast<Method *>(arg);
+    Reading reading;
+    fill(reading, ++counter);
+    if (method == Method::SNAPSHOT) {
+        shared_snapshot.Publish(reading);
+    } else if (method == Method::SINGLE) {
+        shared_single.Publish(reading);
+    } else {
+        xSemaphoreTake(shared_mutex, portMAX_DELAY);
+        shared_global = reading;
+        xSemaphoreGive(shared_mutex);
+    }
+}
+
+static void reader_task(void *arg) {
+    const auto method = *static_cast<Method *>(arg);
+    Reading reading;
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    while (running) {
+        if (method == Method::SNAPSHOT) {
+            reading = shared_snapshot.Read();
+        } else if (method == Method::SINGLE) {
+            reading = shared_single.Read();
+        } else {
+            xSemaphoreTake(shared_mutex, portMAX_DELAY);
+            reading = shared_global;
+            xSemaphoreGive(shared_mutex);
+        }
+        torn += consistent(reading) ? 0 : 1;
+        reads++;
+    }
+    taskENTER_CRITICAL(&totals_mutex);
+    total_reads += reads;
+    torn_reads += torn;
+    taskEXIT_CRITICAL(&totals_mutex);
+    xSemaphoreGive(finished);
+    vTaskDelete(nullptr);
+}
+
+// Runs the writer and the given number of readers spread over both cores, returns the reads completed
+static uint32_t run_readers(Method method, int readers) {
+    static Method task_method;
+    task_method = method;
+    total_reads = 0;
+    torn_reads = 0;
+    running = true;
+
+    // The test task must outrank the spinning readers to end the run
+    const UBaseType_t priority = uxTaskPriorityGet(nullptr);
+    vTaskPrioritySet(nullptr, 10);
+
+    esp_timer_handle_t writer;
+    esp_timer_create_args_t args{};
+    args.callback = writer_callback;
+    args.arg = &task_method;
+    args.name = "writer";
+    esp_timer_create(&args, &writer);
+    esp_timer_start_periodic(writer, 1000);
+    for (int i = 0; i < readers; i++) {
+        xTaskCreatePinnedToCore(reader_task, "reader", 2048, &task_method, 5, nullptr, i % 2);
+    }
+    vTaskDelay(run_ticks);
+    running = false;
+    esp_timer_stop(writer);
+    esp_timer_delete(writer);
+    for (int i = 0; i < readers; i++) {
+        xSemaphoreTake(finished, portMAX_DELAY);
+    }
+    vTaskPrioritySet(nullptr, priority);
+    return total_reads;
+}
+
+void setUp(void) {
+    if (finished == nullptr) {
+        finished = xSemaphoreCreateCounting(8, 0);
+        shared_mutex = xSemaphoreCreateMutex();
+    }
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_snapshot_publish_read() {
+    Snapshot<Reading> snapshot;
+    Reading reading;
+    uint32_t version = 0;
+
+    TEST_ASSERT_EQUAL(0, snapshot.GetVersion());
+    TEST_ASSERT_FALSE(snapshot.ReadIfNewer(reading, version));
+
+    fill(reading, 7);
+    snapshot.Publish(reading);
+    fill(reading, 8);
+    snapshot.Publish(reading);
+
+    TEST_ASSERT_EQUAL(2, snapshot.GetVersion());
+    TEST_ASSERT_TRUE(snapshot.TryRead(reading, &version));
+    TEST_ASSERT_EQUAL(2, version);
+    TEST_ASSERT_EQUAL(8, reading.words[0]);
+    TEST_ASSERT_FALSE(snapshot.ReadIfNewer(reading, version));
+}
+
+void test_snapshot_consistent_across_cores() {
+    TEST_ASSERT_GREATER_THAN(0, run_readers(Method::SNAPSHOT, 4));
+    TEST_ASSERT_EQUAL(0, torn_reads);
+
+    TEST_ASSERT_GREATER_THAN(0, run_readers(Method::SINGLE, 4));
+    TEST_ASSERT_EQUAL(0, torn_reads);
+}
+
+void test_snapshot_reader_scaling_vs_mutex() {
+    uint32_t snapshot_reads[3];
+    uint32_t mutex_reads[3];
+    const int readers[3] = {1, 2, 4};
+
+    // Throughput depends on scheduling and load, it is printed for comparison only
+    for (int i = 0; i < 3; i++) {
+        snapshot_reads[i] = run_readers(Method::SNAPSHOT, readers[i]);
+        TEST_ASSERT_EQUAL(0, torn_reads);
+        mutex_reads[i] = run_readers(Method::MUTEX, readers[i]);
+        TEST_ASSERT_EQUAL(0, torn_reads);
+        printf("%d readers: snapshot %lu reads, mutex %lu reads\n", readers[i],
+               static_cast<unsigned long>(snapshot_reads[i]), static_cast<unsigned long>(mutex_reads[i]));
+    }
+}
+
+void test_snapshot_read_register() {
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+
+    // Test device address (0x36 for STEMMA soil sensor)
+    Snapshot<RegisterImage> snapshot;
+    RegisterImage expected;
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x36, 0x00, expected.bytes, 2));
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterSnapshot(0x36, 0x00, snapshot));
+    TEST_ASSERT_EQUAL(1, snapshot.GetVersion());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.bytes, snapshot.Read().bytes, 2);
+
+    // A failed read keeps the last good value
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, i2c.ReadRegisterSnapshot(0x7E, 0x00, snapshot));
+    TEST_ASSERT_EQUAL(1, snapshot.GetVersion());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.bytes, snapshot.Read().bytes, 2);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_snapshot_publish_read);
+    RUN_TEST(test_snapshot_consistent_across_cores);
+    RUN_TEST(test_snapshot_reader_scaling_vs_mutex);
+    RUN_TEST(test_snapshot_read_register);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,173 @@
+#include <unity.h>
+#include <cstring>
+#include "metrics.h"
+#include "gpio.h"
+#include "i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "loopback.h"
+
+using namespace Metrics;
+
+static const gpio_num_t loop_pin = LOOPBACK_PIN_A;
+static const uint32_t increments = 100000;
+
+static MetricsSnapshot snapshot;
+static char text[4096];
+static uint8_t binary[1024];
+static SemaphoreHandle_t finished;
+
+static const DeviceMetrics *find_device(uint8_t dev_addr) {
+    for (size_t i = 0; i < snapshot.device_count; i++) {
+        if (snapshot.devices[i].dev_addr == dev_addr) {
+            return &snapshot.devices[i];
+        }
+    }
+    return nullptr;
+}
+
+static void increment_task(void *arg) {
+    for (uint32_t i = 0; i < increments; i++) {
+        RecordTransaction(I2C_NUM_1, 0x50, i % 2 ? ESP_OK : ESP_FAIL, 100);
+    }
+    xSemaphoreGive(finished);
+    vTaskDelete(nullptr);
+}
+
+void setUp(void) {
+    Reset();
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_metrics_i2c_devices() {
+    I2C::I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+
+    uint8_t rx_data[2];
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x36, 0x00, rx_data, 2));
+    }
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_NOT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x7E, 0x00, rx_data, 2));
+    }
+
+    TakeSnapshot(snapshot);
+    TEST_ASSERT_EQUAL(2, snapshot.device_count);
+
+    const DeviceMetrics *present = find_device(0x36);
+    TEST_ASSERT_NOT_NULL(present);
+    TEST_ASSERT_EQUAL(I2C_NUM_0, present->port);
+    TEST_ASSERT_EQUAL(10, present->transactions);
+    TEST_ASSERT_EQUAL(0, present->errors);
+    TEST_ASSERT_GREATER_THAN(0, present->latency_max_us);
+
+    uint32_t histogram_total = 0;
+    for (const uint32_t count : present->latency_histogram) {
+        histogram_total += count;
+    }
+    TEST_ASSERT_EQUAL(10, histogram_total);
+
+    const DeviceMetrics *absent = find_device(0x7E);
+    TEST_ASSERT_NOT_NULL(absent);
+    TEST_ASSERT_EQUAL(3, absent->transactions);
+    TEST_ASSERT_EQUAL(3, absent->errors);
+}
+
+void test_metrics_gpio_edges_and_drops() {
+    GPIO::GpioInput input(loop_pin);
+    loopback_init(input, loop_pin);
+    QueueHandle_t queue = xQueueCreate(4, sizeof(int32_t));
+    input.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    // Nothing drains the queue, so the last six edges find it full
+    for (int i = 0; i < 10; i++) {
+        gpio_set_level(loop_pin, (i + 1) % 2);
+        vTaskDelay(1);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+
+    TakeSnapshot(snapshot);
+    const PinMetrics &pin = snapshot.pins[loop_pin];
+    printf("Edges %lu, drops %lu, ISR cycles max %lu\n", static_cast<unsigned long>(pin.edges),
+           static_cast<unsigned long>(pin.drops), static_cast<unsigned long>(pin.isr_cycles_max));
+    TEST_ASSERT_EQUAL(10, pin.edges);
+    TEST_ASSERT_EQUAL(6, pin.drops);
+    TEST_ASSERT_GREATER_THAN(0, pin.isr_cycles_max);
+    TEST_ASSERT_GREATER_OR_EQUAL(pin.isr_cycles_max, pin.isr_cycles_total);
+    vQueueDelete(queue);
+}
+
+void test_metrics_both_cores_sum_exactly() {
+    finished = xSemaphoreCreateCounting(2, 0);
+    xTaskCreatePinnedToCore(increment_task, "inc0", 2048, nullptr, 5, nullptr, 0);
+    xTaskCreatePinnedToCore(increment_task, "inc1", 2048, nullptr, 5, nullptr, 1);
+    xSemaphoreTake(finished, portMAX_DELAY);
+    xSemaphoreTake(finished, portMAX_DELAY);
+    vSemaphoreDelete(finished);
+
+    TakeSnapshot(snapshot);
+    const DeviceMetrics *device = find_device(0x50);
+    TEST_ASSERT_NOT_NULL(device);
+    TEST_ASSERT_EQUAL(2 * increments, device->transactions);
+    TEST_ASSERT_EQUAL(increments, device->errors);
+    TEST_ASSERT_EQUAL(2 * increments, device->latency_histogram[1]);
+}
+
+void test_metrics_export() {
+    RecordEdge(GPIO_NUM_4, 500);
+    RecordTransaction(I2C_NUM_0, 0x36, ESP_OK, 150);
+    TakeSnapshot(snapshot);
+
+    size_t written = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, ExportBinary(snapshot, binary, 16, written));
+    TEST_ASSERT_EQUAL(ESP_OK, ExportBinary(snapshot, binary, sizeof(binary), written));
+    // Header, one pin and one device
+    TEST_ASSERT_EQUAL(16 + 17 + 2 + 4 * (4 + LATENCY_BUCKETS), written);
+    uint32_t magic = 0;
+    memcpy(&magic, binary, sizeof(magic));
+    TEST_ASSERT_EQUAL_HEX32(BINARY_MAGIC, magic);
+    TEST_ASSERT_EQUAL(BINARY_VERSION, binary[4]);
+    TEST_ASSERT_EQUAL(1, binary[5]);
+    TEST_ASSERT_EQUAL(1, binary[6]);
+    TEST_ASSERT_EQUAL(GPIO_NUM_4, binary[16]);
+
+    TEST_ASSERT_EQUAL(ESP_OK, ExportText(snapshot, text, sizeof(text), written));
+    TEST_ASSERT_EQUAL(strlen(text), written);
+    TEST_ASSERT_NOT_NULL(strstr(text, "gpio_edges{pin=\"4\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "gpio_isr_cycles_max{pin=\"4\"} 500\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "i2c_transactions{port=\"0\",addr=\"0x36\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "i2c_latency_us_bucket{port=\"0\",addr=\"0x36\",lt=\"256\"} 1\n"));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, ExportText(snapshot, text, 32, written));
+    TEST_ASSERT_EQUAL(31, strlen(text));
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_metrics_i2c_devices);
+    RUN_TEST(test_metrics_gpio_edges_and_drops);
+    RUN_TEST(test_metrics_both_cores_sum_exactly);
+    RUN_TEST(test_metrics_export);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,148 @@
+#include <unity.h>
+#include "sdkconfig.h"
+#include "gpio.h"
+#include "i2c.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "loopback.h"
+
+using namespace GPIO;
+using namespace I2C;
+
+static const gpio_num_t loop_pin = LOOPBACK_PIN_A;
+static const int samples = 100;
+
+struct Latency {
+    int64_t min_us = INT64_MAX;
+    int64_t max_us = 0;
+    int64_t total_us = 0;
+
+    void add(int64_t us) {
+        min_us = us < min_us ? us : min_us;
+        max_us = us > max_us ? us : max_us;
+        total_us += us;
+    }
+
+    int64_t mean(void) const { return total_us / samples; }
+    int64_t jitter(void) const { return max_us - min_us; }
+};
+
+static esp_err_t configure_dfs(bool enabled) {
+    esp_pm_config_t config{};
+    config.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    config.min_freq_mhz = enabled ? 40 : CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    config.light_sleep_enable = false;
+    return esp_pm_configure(&config);
+}
+
+static void print_latency(const char *name, const Latency &latency) {
+    printf("%s: mean %lld us, min %lld us, max %lld us, jitter %lld us\n", name,
+           static_cast<long long>(latency.mean()), static_cast<long long>(latency.min_us),
+           static_cast<long long>(latency.max_us), static_cast<long long>(latency.jitter()));
+}
+
+// Idles a tick between reads so the governor drops the clock before each one
+static Latency measure_i2c(I2c &i2c) {
+    Latency latency;
+    uint8_t rx_data[2];
+    for (int i = 0; i < samples; i++) {
+        vTaskDelay(1);
+        const int64_t start = esp_timer_get_time();
+        TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x36, 0x00, rx_data, 2));
+        latency.add(esp_timer_get_time() - start);
+    }
+    return latency;
+}
+
+// Time from driving the edge until the queue delivers it to this task
+static Latency measure_gpio(QueueHandle_t queue) {
+    Latency latency;
+    uint32_t level = 0;
+    int32_t pin;
+    for (int i = 0; i < samples; i++) {
+        vTaskDelay(1);
+        level ^= 1;
+        const int64_t start = esp_timer_get_time();
+        gpio_set_level(loop_pin, level);
+        TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(queue, &pin, pdMS_TO_TICKS(100)));
+        latency.add(esp_timer_get_time() - start);
+    }
+    return latency;
+}
+
+void setUp(void) {
+    // Set up before each test
+}
+
+void tearDown(void) {
+    configure_dfs(false);
+}
+
+void test_power_i2c_latency_under_dfs() {
+#if !CONFIG_PM_ENABLE
+    TEST_IGNORE_MESSAGE("Needs CONFIG_PM_ENABLE to configure DFS");
+#endif
+    I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+
+    TEST_ASSERT_EQUAL(ESP_OK, configure_dfs(false));
+    const Latency fixed = measure_i2c(i2c);
+    TEST_ASSERT_EQUAL(ESP_OK, configure_dfs(true));
+    const Latency scaled = measure_i2c(i2c);
+
+    // With CONFIG_I2C_PM_LOCK the APB lock is taken before the transaction is queued, so only the switch is added
+    print_latency("I2C, DFS off", fixed);
+    print_latency("I2C, DFS on", scaled);
+}
+
+void test_power_gpio_latency_under_dfs() {
+#if !CONFIG_PM_ENABLE
+    TEST_IGNORE_MESSAGE("Needs CONFIG_PM_ENABLE to configure DFS");
+#endif
+    GpioInput input(loop_pin);
+    loopback_init(input, loop_pin);
+    QueueHandle_t queue = xQueueCreate(4, sizeof(int32_t));
+    input.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    TEST_ASSERT_EQUAL(ESP_OK, configure_dfs(false));
+    const Latency fixed = measure_gpio(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, configure_dfs(true));
+    const Latency unlocked = measure_gpio(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enablePowerLock());
+    const Latency locked = measure_gpio(queue);
+
+    print_latency("GPIO, DFS off", fixed);
+    print_latency("GPIO, DFS on, no lock", unlocked);
+    print_latency("GPIO, DFS on, power lock", locked);
+
+    // Disabling interrupts releases the locks, so the clock may drop again
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    TEST_ASSERT_EQUAL(ESP_OK, input.disablePowerLock());
+    vQueueDelete(queue);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_power_i2c_latency_under_dfs);
+    RUN_TEST(test_power_gpio_latency_under_dfs);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
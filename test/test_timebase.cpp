@@ -0,0 +1,181 @@
+#include <unity.h>
+#include <atomic>
+#include "timebase.h"
+#include "esp_cpu.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const uint32_t ping_rounds = 10000;
+static const int bench_reads = 1000;
+static const int frequency_switches = 50;
+
+// Odd turns belong to core 1, even turns to core 0
+static std::atomic<uint32_t> turn{0};
+static std::atomic<int64_t> last_stamp_us{0};
+static std::atomic<int64_t> worst_inversion_us{0};
+static std::atomic<uint32_t> finished{0};
+
+// Takes a timestamp on every turn of its core, each one causally after the other core's last stamp
+static void ping_task(void *arg) {
+    const uint32_t parity = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(arg));
+    for (uint32_t round = parity; round < 2 * ping_rounds; round += 2) {
+        while (turn.load(std::memory_order_acquire) != round) {
+        }
+        const int64_t now_us = Timebase::Now();
+        const int64_t inversion_us = last_stamp_us.load(std::memory_order_relaxed) - now_us;
+        if (inversion_us > worst_inversion_us.load(std::memory_order_relaxed)) {
+            worst_inversion_us.store(inversion_us, std::memory_order_relaxed);
+        }
+        last_stamp_us.store(now_us, std::memory_order_relaxed);
+        turn.store(round + 1, std::memory_order_release);
+    }
+    finished.fetch_add(1);
+    vTaskDelete(nullptr);
+}
+
+void setUp(void) {
+    TEST_ASSERT_EQUAL(ESP_OK, Timebase::Start());
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+// Checks one Now() against the esp_timer reads around it
+static void assert_on_esp_timer(uint32_t bound_us) {
+    const int64_t before_us = esp_timer_get_time();
+    const int64_t now_us = Timebase::Now();
+    const int64_t after_us = esp_timer_get_time();
+    TEST_ASSERT_GREATER_OR_EQUAL(before_us - bound_us, now_us);
+    TEST_ASSERT_LESS_OR_EQUAL(after_us + bound_us, now_us);
+}
+
+void test_timebase_tracks_esp_timer() {
+    TEST_ASSERT_TRUE(Timebase::IsCalibrated());
+    TEST_ASSERT_NOT_EQUAL(0, Timebase::GetCalibration(0).ticks_per_us);
+    TEST_ASSERT_EQUAL(0, Timebase::GetCalibration(portNUM_PROCESSORS).ticks_per_us);
+
+    // Stays on the esp_timer timeline across several recalibrations
+    const uint32_t bound_us = Timebase::GetErrorBoundUs();
+    for (int i = 0; i < 50; i++) {
+        assert_on_esp_timer(bound_us);
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_TIMEBASE_CALIBRATION_MS / 5 + 1));
+    }
+
+    // Uncalibrated reads fall back to esp_timer
+    Timebase::Stop();
+    TEST_ASSERT_FALSE(Timebase::IsCalibrated());
+    const int64_t before_us = esp_timer_get_time();
+    const int64_t now_us = Timebase::Now();
+    TEST_ASSERT_GREATER_OR_EQUAL(before_us, now_us);
+    TEST_ASSERT_LESS_OR_EQUAL(esp_timer_get_time(), now_us);
+}
+
+void test_timebase_cross_core_order() {
+    turn.store(0);
+    last_stamp_us.store(0);
+    worst_inversion_us.store(0);
+    finished.store(0);
+    xTaskCreatePinnedToCore(ping_task, "ping0", 2048, reinterpret_cast<void *>(0), 10, nullptr, 0);
+    xTaskCreatePinnedToCore(ping_task, "ping1", 2048, reinterpret_cast<void *>(1), 10, nullptr, 1);
+    while (finished.load() < 2) {
+        vTaskDelay(1);
+    }
+
+    // Every stamp was taken after the previous one, so any step back is timebase error
+    const uint32_t bound_us = Timebase::GetErrorBoundUs();
+    printf("Cross-core timestamps over %lu handoffs: worst inversion %lld us, bound %lu us\n",
+           static_cast<unsigned long>(2 * ping_rounds), static_cast<long long>(worst_inversion_us.load()),
+           static_cast<unsigned long>(bound_us));
+    TEST_ASSERT_LESS_OR_EQUAL(static_cast<int64_t>(bound_us), worst_inversion_us.load());
+}
+
+void test_timebase_read_cost() {
+    volatile int64_t sink = 0;
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < bench_reads; i++) {
+        sink = esp_timer_get_time();
+    }
+    const uint32_t timer_cycles = (esp_cpu_get_cycle_count() - start) / bench_reads;
+
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < bench_reads; i++) {
+        sink = Timebase::Now();
+    }
+    const uint32_t timebase_cycles = (esp_cpu_get_cycle_count() - start) / bench_reads;
+    (void)sink;
+
+    printf("Timestamp cost: esp_timer_get_time %lu cycles, Timebase::Now %lu cycles\n",
+           static_cast<unsigned long>(timer_cycles), static_cast<unsigned long>(timebase_cycles));
+}
+
+void test_timebase_frequency_switch() {
+#if CONFIG_PM_ENABLE
+    const TickType_t period = pdMS_TO_TICKS(CONFIG_TIMEBASE_CALIBRATION_MS) + 1;
+
+    // A fixed frequency keeps the cycle counter
+    esp_pm_config_t config{};
+    config.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    config.min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    config.light_sleep_enable = false;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_pm_configure(&config));
+    vTaskDelay(period);
+    TEST_ASSERT_TRUE(Timebase::IsCalibrated());
+
+    // Lets the governor drop to the minimum whenever the lock is released and the core idles
+    config.min_freq_mhz = 80;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_pm_configure(&config));
+    vTaskDelay(period);
+    TEST_ASSERT_FALSE(Timebase::IsCalibrated());
+    esp_pm_lock_handle_t lock;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "timebase", &lock));
+
+    // Round trips well inside a calibration period stay on the esp_timer timeline
+    const uint32_t bound_us = Timebase::GetErrorBoundUs();
+    for (int i = 0; i < frequency_switches; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_pm_lock_acquire(lock));
+        assert_on_esp_timer(bound_us);
+        TEST_ASSERT_EQUAL(ESP_OK, esp_pm_lock_release(lock));
+        vTaskDelay(1);
+        assert_on_esp_timer(bound_us);
+    }
+
+    esp_pm_lock_delete(lock);
+
+    // Fixing the frequency again brings the cycle counter back
+    config.min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_pm_configure(&config));
+    vTaskDelay(period);
+    TEST_ASSERT_TRUE(Timebase::IsCalibrated());
+    assert_on_esp_timer(bound_us);
+#else
+    TEST_IGNORE_MESSAGE("Needs CONFIG_PM_ENABLE to switch the CPU frequency");
+#endif
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_timebase_tracks_esp_timer);
+    RUN_TEST(test_timebase_cross_core_order);
+    RUN_TEST(test_timebase_read_cost);
+    RUN_TEST(test_timebase_frequency_switch);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
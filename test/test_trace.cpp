@@ -0,0 +1,251 @@
+#include <unity.h>
+#include <cstring>
+#include "trace.h"
+#include "gpio.h"
+#include "i2c.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "loopback.h"
+
+using namespace Trace;
+
+static const gpio_num_t loop_pin = LOOPBACK_PIN_A;
+
+static uint8_t stream[2048];
+
+struct Counts {
+    uint32_t edges = 0;
+    uint32_t transactions = 0;
+};
+
+static esp_err_t count_handler(const Event &event, void *context) {
+    auto *counts = static_cast<Counts *>(context);
+    if (event.type == EventType::EDGE) {
+        counts->edges++;
+    } else {
+        counts->transactions++;
+    }
+    return ESP_OK;
+}
+
+// Drives recorded edges back onto the loopback pin, so the input sees the field signal again
+static esp_err_t edge_handler(const Event &event, void *context) {
+    if (event.type == EventType::EDGE) {
+        return ReplayEdge(event, loop_pin);
+    }
+    return ESP_OK;
+}
+
+void setUp(void) {
+    memset(stream, 0, sizeof(stream));
+}
+
+void tearDown(void) {
+    // Clean up after each test
+}
+
+void test_trace_round_trip() {
+    Recorder recorder(stream, sizeof(stream));
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Start());
+
+    Recorder other(stream, sizeof(stream));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, other.Start());
+
+    const uint8_t reg[1] = {0x10};
+    const uint8_t value[3] = {1, 2, 3};
+    uint8_t reply[2] = {0xAB, 0xCD};
+    const std::span<const uint8_t> tx[2] = {reg, value};
+    const std::span<uint8_t> rx[1] = {reply};
+    const int64_t start = esp_timer_get_time();
+    recorder.AddEdge(GPIO_NUM_4, 1);
+    recorder.AddTransaction(I2C_NUM_1, 0x36, ESP_ERR_TIMEOUT, start, 250, tx, rx);
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Stop());
+    TEST_ASSERT_EQUAL(0, recorder.GetDropped());
+
+    Replayer replayer(recorder.GetData(), recorder.GetSize());
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Validate());
+
+    Event event;
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Next(event));
+    TEST_ASSERT_EQUAL(EventType::EDGE, event.type);
+    TEST_ASSERT_EQUAL(GPIO_NUM_4, event.pin);
+    TEST_ASSERT_EQUAL(1, event.level);
+    const int64_t edge_us = event.timestamp_us;
+
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Next(event));
+    TEST_ASSERT_EQUAL(EventType::TRANSACTION, event.type);
+    TEST_ASSERT_EQUAL(I2C_NUM_1, event.port);
+    TEST_ASSERT_EQUAL(0x36, event.dev_addr);
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, event.status);
+    TEST_ASSERT_EQUAL(250, event.duration_us);
+    TEST_ASSERT_LESS_OR_EQUAL(edge_us, event.timestamp_us);
+    const uint8_t written[4] = {0x10, 1, 2, 3};
+    TEST_ASSERT_EQUAL(4, event.tx.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(written, event.tx.data(), 4);
+    TEST_ASSERT_EQUAL(2, event.rx.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(reply, event.rx.data(), 2);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, replayer.Next(event));
+    replayer.Rewind();
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Next(event));
+    TEST_ASSERT_EQUAL(EventType::EDGE, event.type);
+
+    // A truncated stream is reported, never read past its end
+    Replayer truncated(recorder.GetData(), recorder.GetSize() - 1);
+    TEST_ASSERT_EQUAL(ESP_OK, truncated.Next(event));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_RESPONSE, truncated.Next(event));
+}
+
+void test_trace_full_buffer_drops() {
+    Recorder recorder(stream, HEADER_SIZE + 10);
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Start());
+    for (int i = 0; i < 10; i++) {
+        recorder.AddEdge(GPIO_NUM_4, i % 2);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Stop());
+    TEST_ASSERT_GREATER_THAN(0, recorder.GetDropped());
+
+    Counts counts;
+    Replayer replayer(recorder.GetData(), recorder.GetSize());
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Run(count_handler, &counts, 0));
+    TEST_ASSERT_EQUAL(10, counts.edges + recorder.GetDropped());
+}
+
+void test_trace_record_live_traffic() {
+    I2C::I2c i2c(I2C_NUM_0, 0, 0, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, i2c.InitMaster(21, 22, 100000, true, true, 0));
+    GPIO::GpioInput input(loop_pin);
+    loopback_init(input, loop_pin);
+    QueueHandle_t queue = xQueueCreate(32, sizeof(int32_t));
+    input.setQueueHandle(queue);
+    TEST_ASSERT_EQUAL(ESP_OK, input.enableInterrupt(GPIO_INTR_ANYEDGE));
+
+    Recorder recorder(stream, sizeof(stream));
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Start());
+    uint8_t rx_data[2];
+    for (int i = 0; i < 8; i++) {
+        gpio_set_level(loop_pin, (i + 1) % 2);
+        TEST_ASSERT_EQUAL(ESP_OK, i2c.ReadRegisterMultipleBytes(0x36, 0x00, rx_data, 2));
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Stop());
+    TEST_ASSERT_EQUAL(0, recorder.GetDropped());
+    printf("Recorded %u bytes\n", static_cast<unsigned>(recorder.GetSize()));
+
+    Counts counts;
+    Replayer replayer(recorder.GetData(), recorder.GetSize());
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Run(count_handler, &counts, 0));
+    TEST_ASSERT_EQUAL(8, counts.edges);
+    TEST_ASSERT_EQUAL(8, counts.transactions);
+
+    // The recorded reads can be issued again on the bench bus
+    Event event;
+    replayer.Rewind();
+    while (replayer.Next(event) == ESP_OK && event.type != EventType::TRANSACTION) {
+    }
+    TEST_ASSERT_EQUAL(EventType::TRANSACTION, event.type);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, ReplayEdge(event, loop_pin));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, ReplayTransaction(i2c, event, rx_data, 1));
+    TEST_ASSERT_EQUAL(ESP_OK, ReplayTransaction(i2c, event, rx_data, sizeof(rx_data)));
+
+    // Replaying the edges onto the pin raises the same interrupts again
+    xQueueReset(queue);
+    replayer.Rewind();
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Run(edge_handler, nullptr, 0));
+    vTaskDelay(1);
+    TEST_ASSERT_EQUAL(8, uxQueueMessagesWaiting(queue));
+
+    TEST_ASSERT_EQUAL(ESP_OK, input.disableInterrupt());
+    vQueueDelete(queue);
+}
+
+void test_trace_paced_replay() {
+    Recorder recorder(stream, sizeof(stream));
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Start());
+    for (int i = 0; i < 10; i++) {
+        recorder.AddEdge(GPIO_NUM_4, i % 2);
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, recorder.Stop());
+
+    Counts counts;
+    ReplayStats real_time;
+    ReplayStats accelerated;
+    Replayer replayer(recorder.GetData(), recorder.GetSize());
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Run(count_handler, &counts, 1, &real_time));
+    replayer.Rewind();
+    TEST_ASSERT_EQUAL(ESP_OK, replayer.Run(count_handler, &counts, 10, &accelerated));
+    printf("Real time %lld us (late %lld us), 10x %lld us (late %lld us)\n",
+           static_cast<long long>(real_time.elapsed_us), static_cast<long long>(real_time.max_lateness_us),
+           static_cast<long long>(accelerated.elapsed_us), static_cast<long long>(accelerated.max_lateness_us));
+
+    // Nine gaps of about 20 ms between the ten edges, a paced replay never runs ahead of them
+    TEST_ASSERT_EQUAL(10, real_time.events);
+    TEST_ASSERT_EQUAL(10, accelerated.events);
+    TEST_ASSERT_GREATER_OR_EQUAL(170000, real_time.elapsed_us);
+    TEST_ASSERT_GREATER_OR_EQUAL(17000, accelerated.elapsed_us);
+}
+
+// Appends transactions from a task on the other core until told to stop
+static volatile bool appending = false;
+static volatile uint32_t appended = 0;
+
+static void append_task(void *arg) {
+    const uint8_t payload[64] = {};
+    const std::span<const uint8_t> tx[1] = {payload};
+    while (appending) {
+        RecordTransaction(I2C_NUM_0, 0x36, ESP_OK, esp_timer_get_time(), 100, tx, {});
+        appended++;
+    }
+    vTaskDelete(nullptr);
+}
+
+void test_trace_stop_under_traffic() {
+    // A hook may still be appending when Stop() is called, the stream must be complete once it returns
+    appending = true;
+    appended = 0;
+    xTaskCreatePinnedToCore(append_task, "append", 2048, nullptr, 5, nullptr, 1);
+    for (int round = 0; round < 20; round++) {
+        Recorder recorder(stream, sizeof(stream));
+        TEST_ASSERT_EQUAL(ESP_OK, recorder.Start());
+        vTaskDelay(1);
+        TEST_ASSERT_EQUAL(ESP_OK, recorder.Stop());
+        const size_t size = recorder.GetSize();
+        memset(stream + size, 0xFF, sizeof(stream) - size);
+
+        Counts counts;
+        Replayer replayer(recorder.GetData(), size);
+        TEST_ASSERT_EQUAL(ESP_OK, replayer.Run(count_handler, &counts, 0));
+        TEST_ASSERT_EQUAL(size, recorder.GetSize());
+    }
+    appending = false;
+    vTaskDelay(2);
+    TEST_ASSERT_GREATER_THAN(0, appended);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_trace_round_trip);
+    RUN_TEST(test_trace_full_buffer_drops);
+    RUN_TEST(test_trace_record_live_traffic);
+    RUN_TEST(test_trace_paced_replay);
+    RUN_TEST(test_trace_stop_under_traffic);
+
+    UNITY_END();
+}
+
+extern "C" void app_main(void) {
+    // Wait for serial to be ready
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // Run tests
+    RUN_UNITY_TESTS();
+
+    // Keep the ESP32 running
+    while(1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}